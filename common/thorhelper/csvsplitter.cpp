@@ -21,6 +21,7 @@
 #include "jexcept.hpp"
 #include "junicode.hpp"
 #include "jfile.hpp"
+#include "jset.hpp"
 #include "eclhelper.hpp"
 
 #ifdef _USE_ICU
@@ -32,6 +33,10 @@
 #include "roxiemem.hpp"
 using roxiemem::OwnedRoxieString;
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 // If you have lines more than 2Mb in length it is more likely to be a bug - so require an explicit override
 #define DEFAULT_CSV_LINE_LENGTH 2048
 #define MAX_SENSIBLE_CSV_LINE_LENGTH 0x200000
@@ -55,6 +60,7 @@ CSVSplitter::~CSVSplitter()
 
 void CSVSplitter::addQuote(const char * text)
 {
+    scanTableValid = false;
     //Allow '' to remove quoting.
     if (text && *text)
         matcher.addEntry(text, QUOTE+(numQuotes++<<8));
@@ -62,28 +68,33 @@ void CSVSplitter::addQuote(const char * text)
 
 void CSVSplitter::addSeparator(const char * text)
 {
+    scanTableValid = false;
     if (text && *text)
         matcher.addEntry(text, SEPARATOR);
 }
 
 void CSVSplitter::addTerminator(const char * text)
 {
+    scanTableValid = false;
     matcher.addEntry(text, TERMINATOR);
 }
 
 void CSVSplitter::addItem(MatchItem item, const char * text)
 {
+    scanTableValid = false;
     if (text)
         matcher.addEntry(text, item);
 }
 
 void CSVSplitter::addEscape(const char * text)
 {
+    scanTableValid = false;
     matcher.queryAddEntry((size32_t)strlen(text), text, ESCAPE);
 }
 
 void CSVSplitter::addWhitespace()
 {
+    scanTableValid = false;
     matcher.queryAddEntry(1, " ", WHITESPACE);
     matcher.queryAddEntry(1, "\t", WHITESPACE);
 }
@@ -101,6 +112,7 @@ void CSVSplitter::reset()
     internalOffset = 0;
     sizeInternal = 0;
     maxCsvSize = 0;
+    scanTableValid = false;
 }
 
 void CSVSplitter::init(unsigned _maxColumns, ICsvParameters * csvInfo, const char * dfsQuotes, const char * dfsSeparators, const char * dfsTerminators, const char * dfsEscapes)
@@ -330,8 +342,36 @@ unsigned CSVSplitter::splitLine(ISerialStream *stream, size32_t maxRowSize)
     return thisLineLength;
 }
 
+void CSVSplitter::initScanTable()
+{
+    numScanBytes = 0;
+    for (unsigned c=0; c<256; c++)
+    {
+        isScanByte[c] = matcher.canStartMatch((byte)c);
+        if (isScanByte[c])
+        {
+            if (numScanBytes < maxScanBytes)
+                scanBytes[numScanBytes] = (byte)c;
+            numScanBytes++;
+        }
+    }
+    scanTableValid = true;
+}
+
 size32_t CSVSplitter::splitLine(size32_t maxLength, const byte * start)
 {
+    if (!scanTableValid)
+        initScanTable();
+#ifdef __SSE2__
+    // Compare 16 bytes at a time against each of the bytes that could start a separator/quote etc.
+    bool useSimdScan = (numScanBytes <= maxScanBytes);
+    __m128i scanVectors[maxScanBytes];
+    if (useSimdScan)
+    {
+        for (unsigned i=0; i<numScanBytes; i++)
+            scanVectors[i] = _mm_set1_epi8((char)scanBytes[i]);
+    }
+#endif
     unsigned curColumn = 0;
     unsigned quote = 0;
     unsigned quoteToStrip = 0;
@@ -349,7 +389,29 @@ size32_t CSVSplitter::splitLine(size32_t maxLength, const byte * start)
         switch (match & 255)
         {
         case NONE:
-            cur++;          // matchLen == 0;
+            // matchLen == 0; skip the run of bytes that cannot start a match
+            cur++;
+#ifdef __SSE2__
+            if (useSimdScan)
+            {
+                while (end-cur >= 16)
+                {
+                    __m128i block = _mm_loadu_si128((const __m128i *)cur);
+                    __m128i hits = _mm_setzero_si128();
+                    for (unsigned i=0; i<numScanBytes; i++)
+                        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, scanVectors[i]));
+                    unsigned mask = (unsigned)_mm_movemask_epi8(hits);
+                    if (mask)
+                    {
+                        cur += countTrailingUnsetBits(mask);
+                        break;
+                    }
+                    cur += 16;
+                }
+            }
+#endif
+            while ((cur != end) && !isScanByte[*cur])
+                cur++;
             lastGood = cur;
             break;
         case WHITESPACE:
@@ -633,3 +695,45 @@ void CSVOutputStream::writeHeaderLn(size32_t len, const char * data)
     }
 }
 
+
+#ifdef _USE_CPPUNIT
+#include "unittests.hpp"
+
+class CSVSplitterTests : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( CSVSplitterTests );
+        CPPUNIT_TEST(testSplitLine);
+    CPPUNIT_TEST_SUITE_END();
+
+    void checkField(CSVSplitter &splitter, unsigned column, const char *expected)
+    {
+        size32_t len = splitter.queryLengths()[column];
+        CPPUNIT_ASSERT_EQUAL((size32_t)strlen(expected), len);
+        CPPUNIT_ASSERT(0 == memcmp(expected, splitter.queryData()[column], len));
+    }
+public:
+    void testSplitLine()
+    {
+        CSVSplitter splitter;
+        splitter.init(3, 0, "\"", ",", "\\n,\\r\\n", nullptr, false);
+
+        // long unquoted fields exercise the block scanning of plain text
+        const char *text = "abcdefghijklmnopqrstuvwxyz0123456789,  \"quoted, text\" ,x\r\nnext,line";
+        size32_t len = splitter.splitLine((size32_t)strlen(text), (const byte *)text);
+        CPPUNIT_ASSERT_EQUAL((size32_t)(strchr(text, '\n') + 1 - text), len);
+        checkField(splitter, 0, "abcdefghijklmnopqrstuvwxyz0123456789");
+        checkField(splitter, 1, "quoted, text");
+        checkField(splitter, 2, "x");
+
+        const char *last = text + len;
+        CPPUNIT_ASSERT_EQUAL((size32_t)strlen(last), splitter.splitLine((size32_t)strlen(last), (const byte *)last));
+        checkField(splitter, 0, "next");
+        checkField(splitter, 1, "line");
+        checkField(splitter, 2, "");
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CSVSplitterTests );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( CSVSplitterTests, "CSVSplitterTests" );
+
+#endif
@@ -84,6 +84,7 @@ public:
 
 protected:
     void setFieldRange(const byte * start, const byte * end, unsigned curColumn, unsigned quoteToStrip, bool unescape);
+    void initScanTable();
 
 protected:
     unsigned            maxColumns;
@@ -95,6 +96,12 @@ protected:
     size32_t            internalOffset;
     size32_t            sizeInternal;
     size32_t            maxCsvSize;
+    // bytes that can start a match, used to skip quickly over runs of plain field text
+    static constexpr unsigned maxScanBytes = 8;
+    bool                scanTableValid = false;
+    bool                isScanByte[256];
+    unsigned            numScanBytes = 0;
+    byte                scanBytes[maxScanBytes];
 };
 
 class THORHELPER_API CSVOutputStream : public StringBuffer, implements ITypedOutputStream
@@ -834,6 +834,39 @@ public:
     }
 };
 
+class CRadixSortAlgorithm : public CInplaceSortAlgorithm
+{
+    const ICompareNormalizedKey * keyCompare;
+
+public:
+    CRadixSortAlgorithm(ICompare *_compare) : CInplaceSortAlgorithm(_compare)
+    {
+        keyCompare = dynamic_cast<const ICompareNormalizedKey *>(_compare);
+    }
+
+    virtual void prepare(IEngineRowStream *input)
+    {
+        curIndex = 0;
+        if (input->nextGroup(sorted))
+        {
+            size_t numRows = sorted.ordinality();
+            void **rows = const_cast<void * *>(sorted.getArray());
+            cycle_t startCycles = get_cycles_now();
+            if (keyCompare)
+            {
+                MemoryAttr workspace(radixSortWorkspaceSize(numRows)); // This should probably be allocated from roxiemem
+                radixsortvecstableinplace(rows, numRows, *keyCompare, workspace.bufferBase());
+            }
+            else
+            {
+                MemoryAttr tempAttr(numRows*sizeof(void **));
+                parqsortvecstableinplace(rows, numRows, *compare, (void **) tempAttr.bufferBase());
+            }
+            elapsedCycles += (get_cycles_now() - startCycles);
+        }
+    }
+};
+
 class CHeapSortAlgorithm : public CSortAlgorithm
 {
     unsigned curIndex;
@@ -1276,6 +1309,11 @@ extern ISortAlgorithm *createParallelTaskStableQuickSortAlgorithm(ICompare *_com
     return new CParallelTaskStableQuickSortAlgorithm(_compare);
 }
 
+extern ISortAlgorithm *createRadixSortAlgorithm(ICompare *_compare)
+{
+    return new CRadixSortAlgorithm(_compare);
+}
+
 extern ISortAlgorithm *createTbbQuickSortAlgorithm(ICompare *_compare)
 {
     return new CTbbQuickSortAlgorithm(_compare);
@@ -1339,6 +1377,8 @@ extern ISortAlgorithm *createSortAlgorithm(RoxieSortAlgorithm _algorithm, ICompa
         return createTbbQuickSortAlgorithm(_compare);
     case tbbStableQuickSortAlgorithm:
         return createTbbStableQuickSortAlgorithm(_compare);
+    case radixSortAlgorithm:
+        return createRadixSortAlgorithm(_compare);
     default:
         break;
     }
@@ -311,6 +311,7 @@ typedef enum {
     parallelStableQuickSortAlgorithm,   // stable version of parallelQuickSortAlgorithm
     parallelTaskQuickSortAlgorithm,      // task based parallel version of the internal quicksort implementation (for comparison)
     parallelTaskStableQuickSortAlgorithm,// task based stable version of parallelQuickSortAlgorithm
+    radixSortAlgorithm,                 // stable radix sort on the compare's normalized key, if it has one (otherwise parallel stable quick sort)
     unknownSortAlgorithm
 } RoxieSortAlgorithm;
 
@@ -334,6 +335,7 @@ extern THORHELPER_API ISortAlgorithm *createParallelMergeSortAlgorithm(ICompare
 extern THORHELPER_API ISortAlgorithm *createTbbQuickSortAlgorithm(ICompare *_compare);
 extern THORHELPER_API ISortAlgorithm *createTbbStableQuickSortAlgorithm(ICompare *_compare);
 extern THORHELPER_API ISortAlgorithm *createParallelTaskQuickSortAlgorithm(ICompare *_compare);
+extern THORHELPER_API ISortAlgorithm *createRadixSortAlgorithm(ICompare *_compare);
 extern THORHELPER_API ISortAlgorithm *createParallelTaskStableQuickSortAlgorithm(ICompare *_compare);
 
 extern THORHELPER_API ISortAlgorithm *createSortAlgorithm(RoxieSortAlgorithm algorithm, ICompare *_compare, roxiemem::IRowManager &_rowManager, IOutputMetaData * _rowMeta, ICodeContext *_ctx, const char *_tempDirectory, unsigned _activityId);
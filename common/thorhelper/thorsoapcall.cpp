@@ -19,6 +19,7 @@
 #include "jqueue.tpp"
 #include "jisem.hpp"
 #include "jsecrets.hpp"
+#include "jmetrics.hpp"
 
 #include "rtlformat.hpp"
 
@@ -500,6 +501,7 @@ public:
 static IPersistentHandler* persistentHandler = nullptr;
 static CriticalSection persistentCrit;
 static std::atomic<bool> persistentInitDone{false};
+static unsigned maxAdaptiveParallel = 0;    // If non-zero, dataset calls without PARALLEL adapt their concurrency up to this limit
 
 void initPersistentHandler()
 {
@@ -508,10 +510,14 @@ void initPersistentHandler()
     {
 #ifndef _CONTAINERIZED
         int maxPersistentRequests = queryEnvironmentConf().getPropInt("maxHttpCallPersistentRequests", 0);
+        maxAdaptiveParallel = queryEnvironmentConf().getPropInt("maxHttpCallAdaptiveParallel", 0);
 #else
         Owned<IPropertyTree> conf = getComponentConfig();
         int maxPersistentRequests = conf->getPropInt("@maxHttpCallPersistentRequests", 0);
+        maxAdaptiveParallel = conf->getPropInt("@maxHttpCallAdaptiveParallel", 0);
 #endif
+        if (maxAdaptiveParallel > MAXWSCTHREADS)
+            maxAdaptiveParallel = MAXWSCTHREADS;
         if (maxPersistentRequests != 0)
             persistentHandler = createPersistentHandler(nullptr, DEFAULT_MAX_PERSISTENT_IDLE_TIME, maxPersistentRequests, PersistentLogLevel::PLogMin, true);
         persistentInitDone = true;
@@ -781,6 +787,141 @@ bool isValidHttpValue(char const * in)
     return true;
 }
 
+//=================================================================================================
+// Limits the number of concurrent requests made by a dataset SOAPCALL/HTTPCALL.  The limit is raised
+// by one each time a full window of requests completes with an average latency close to the best seen
+// so far, and cut back when the average latency doubles, suggesting the service is becoming overloaded.
+
+class AdaptiveConcurrencyLimiter
+{
+public:
+    AdaptiveConcurrencyLimiter(unsigned _initialLimit, unsigned _maxLimit)
+        : limit(_initialLimit), maxLimit(_maxLimit)
+    {
+    }
+
+    void enter()
+    {
+        {
+            CriticalBlock block(crit);
+            if (active < limit)
+            {
+                active++;
+                return;
+            }
+            waiting++;
+        }
+        sem.wait(); // slot is handed over by leave()
+    }
+    void leave(unsigned __int64 latencyNs)
+    {
+        CriticalBlock block(crit);
+        noteLatency(latencyNs);
+        active--;
+        while (waiting && (active < limit))
+        {
+            waiting--;
+            active++;
+            sem.signal();
+        }
+    }
+    unsigned queryLimit() const
+    {
+        CriticalBlock block(crit);
+        return limit;
+    }
+
+protected:
+    void noteLatency(unsigned __int64 latencyNs)
+    {
+        windowLatencyNs += latencyNs;
+        if (++numInWindow < limit)
+            return;
+        unsigned __int64 averageNs = windowLatencyNs / numInWindow;
+        numInWindow = 0;
+        windowLatencyNs = 0;
+        // The baseline is taken from window averages so that a single unusually fast response does not pin the limit down
+        if (!baseLatencyNs || (averageNs < baseLatencyNs))
+            baseLatencyNs = averageNs;
+        if (averageNs <= baseLatencyNs + baseLatencyNs / 2)
+        {
+            if (limit < maxLimit)
+                limit++;
+        }
+        else if (averageNs >= baseLatencyNs * 2)
+        {
+            limit -= (limit + 3) / 4;
+            if (limit < 1)
+                limit = 1;
+        }
+        else
+        {
+            // Let the baseline follow a moderate sustained rise, so the limit can recover if the service is now slower for everyone
+            baseLatencyNs += baseLatencyNs / 32;
+        }
+    }
+
+private:
+    mutable CriticalSection crit;
+    Semaphore sem;
+    unsigned limit;
+    unsigned maxLimit;
+    unsigned active = 0;
+    unsigned waiting = 0;
+    unsigned numInWindow = 0;
+    unsigned __int64 windowLatencyNs = 0;
+    unsigned __int64 baseLatencyNs = 0;
+};
+
+//=================================================================================================
+// Latency histogram for the requests sent to a single url, reported when the helper is destroyed.
+// Every request is also recorded in the process wide soapcall.request.latency metric.
+
+// Response times from 1ms up to ~16s, in the same buckets as the per-url histograms
+static auto pRequestLatency = hpccMetrics::registerHistogramMetric("soapcall.request.latency", "Distribution of SOAPCALL/HTTPCALL response times", SMeasureTimeNs, hpccMetrics::createExponentialBuckets(1000000, 2, 15));
+
+class EndpointLatencyStats
+{
+public:
+    EndpointLatencyStats()
+        : histogram("soapcall.endpoint.latency", "Distribution of response times from a single url", SMeasureTimeNs, pRequestLatency->queryBucketLimits())
+    {
+    }
+
+    void noteLatency(unsigned __int64 latencyNs)
+    {
+        histogram.recordMeasurement(latencyNs);
+        pRequestLatency->recordMeasurement(latencyNs);
+        unsigned __int64 prevMax = maxNs.load();
+        while ((latencyNs > prevMax) && !maxNs.compare_exchange_weak(prevMax, latencyNs))
+            ;
+    }
+    bool getReport(StringBuffer &out) const
+    {
+        unsigned __int64 count = histogram.queryValue();
+        if (!count)
+            return false;
+        out.appendf("requests=%" I64F "u avg=%ums max=%ums histogram(ms):", count, (unsigned)nanoToMilli(histogram.querySum() / count), (unsigned)nanoToMilli(maxNs.load()));
+        const std::vector<__uint64> &limits = histogram.queryBucketLimits();
+        std::vector<__uint64> values = histogram.queryBucketValues();
+        for (unsigned i = 0; i < values.size(); i++)
+        {
+            if (values[i])
+            {
+                if (i < limits.size())
+                    out.appendf(" <=%u:%" I64F "u", (unsigned)nanoToMilli(limits[i]), values[i]);
+                else
+                    out.appendf(" >%u:%" I64F "u", (unsigned)nanoToMilli(limits.back()), values[i]);
+            }
+        }
+        return true;
+    }
+
+private:
+    hpccMetrics::HistogramMetric histogram;     // not registered - the per-url detail is only logged
+    std::atomic<unsigned __int64> maxNs{0};
+};
+
 //=================================================================================================
 //Web Service Call helper thread
 class CWSCHelperThread : public Thread
@@ -1022,6 +1163,9 @@ public:
                 throw MakeStringException(0, "%sCALL proxy address specified no URLs",wscType == STsoap ? "SOAP" : "HTTP");
         }
 
+        if (!persistentInitDone)
+            initPersistentHandler();
+
         if (wscMode == SCrow)
         {
             numRowThreads = 1;
@@ -1037,8 +1181,17 @@ public:
         else
         {
             unsigned totThreads = helper->numParallelThreads();
+            bool adaptive = false;
             if (totThreads < 1)
+            {
                 totThreads = 2; // default to 2 threads
+                if (maxAdaptiveParallel > totThreads)
+                {
+                    // Start from the default and let the limiter find how much concurrency the service can take
+                    adaptive = true;
+                    totThreads = maxAdaptiveParallel;
+                }
+            }
             else if (totThreads > MAXWSCTHREADS)
                 totThreads = MAXWSCTHREADS;
 
@@ -1050,10 +1203,22 @@ public:
             else if (numRowThreads > MAXWSCTHREADS)
                 numRowThreads = MAXWSCTHREADS;
 
+            if (adaptive)
+            {
+                // The limiter admits whole batches, and each batch is sent to up to numUrlThreads urls at once,
+                // so its limit is in row threads: start at the default of 2 requests and grow to all the row threads.
+                unsigned initialLimit = 2 / numUrlThreads;
+                if (initialLimit < 1)
+                    initialLimit = 1;
+                if (numRowThreads > initialLimit)
+                    limiter.reset(new AdaptiveConcurrencyLimiter(initialLimit, numRowThreads));
+            }
+
             numRecordsPerBatch = helper->numRecordsPerBatch();
             if (numRecordsPerBatch < 1)
                 numRecordsPerBatch = 1;
         }
+        urlLatency.reset(new EndpointLatencyStats[numUrls]);
 
         for (unsigned i=0; i<numRowThreads; i++)
             threads.append(*new CWSCHelperThread(this));
@@ -1063,6 +1228,7 @@ public:
         complete = true;
         waitUntilDone();
         threads.kill();
+        reportLatencies();
     }
     void waitUntilDone()
     {
@@ -1181,6 +1347,22 @@ public:
             logctx.CTXLOG("%s [time=%u]: %.*s", wscCallTypeText(), timeTaken, lenText, text.getstr());
         }
     }
+    void reportLatencies()
+    {
+        if (soapTraceLevel <= 2)
+            return;
+        for (unsigned i = 0; i < numUrls; i++)
+        {
+            StringBuffer report;
+            if (urlLatency[i].getReport(report))
+            {
+                Url &url = urlArray.item(i);
+                logctx.CTXLOG("%s latency for %s:%u: %s", wscCallTypeText(), url.host.str(), url.port, report.str());
+            }
+        }
+        if (limiter)
+            logctx.CTXLOG("%s final adaptive concurrency limit %u", wscCallTypeText(), limiter->queryLimit());
+    }
     inline IXmlToRowTransformer * getRowTransformer() { return rowTransformer; }
     inline const char * wscCallTypeText() const { return wscType == STsoap ? "SOAPCALL" : "HTTPCALL"; }
 
@@ -1235,6 +1417,8 @@ protected:
     Owned<IException> error;
     UrlArray urlArray;
     UrlArray proxyUrlArray;
+    std::unique_ptr<EndpointLatencyStats[]> urlLatency;
+    std::unique_ptr<AdaptiveConcurrencyLimiter> limiter;
     unsigned numRecordsPerBatch;
     unsigned numUrls;
     unsigned numRowThreads;
@@ -1446,7 +1630,25 @@ void CWSCHelperThread::processQuery(ConstPointerArray &inputRows)
     xmlWriter->finalize();
 
     Owned<IWSCAsyncFor> casyncfor = createWSCAsyncFor(master, *xmlWriter, inputRows, (PTreeReaderOptions) xmlReadFlags);
-    casyncfor->For(master->numUrls, master->numUrlThreads,false,true); // shuffle URLS for poormans load balance
+    AdaptiveConcurrencyLimiter * limiter = master->limiter.get();
+    if (!limiter)
+    {
+        casyncfor->For(master->numUrls, master->numUrlThreads,false,true); // shuffle URLS for poormans load balance
+        return;
+    }
+
+    limiter->enter();
+    CCycleTimer timer;
+    try
+    {
+        casyncfor->For(master->numUrls, master->numUrlThreads,false,true);
+    }
+    catch (...)
+    {
+        limiter->leave(timer.elapsedNs());
+        throw;
+    }
+    limiter->leave(timer.elapsedNs());
 }
 
 int CWSCHelperThread::run()
@@ -1619,6 +1821,7 @@ private:
     PTreeReaderOptions options;
     unsigned remainingMS;
     CCycleTimer mTimer;
+    std::atomic<unsigned> numRequests{0};
 
     inline void checkRoxieAbortMonitor(IRoxieAbortMonitor * roxieAbortMonitor)
     {
@@ -2175,7 +2378,9 @@ public:
 
     ~CWSCAsyncFor()
     {
+        // Only roxie gathers these per activity - thor and hthor pass the job's context logger, which does not record them
         master->logctx.noteStatistic(StTimeSoapcall, mTimer.elapsedNs());
+        master->logctx.noteStatistic(StNumSoapcalls, numRequests);
     }
 
     IMPLEMENT_IINTERFACE;
@@ -2299,6 +2504,8 @@ public:
                 bool keepAlive2;
                 int rval = readHttpResponse(response, socket, keepAlive2);
                 keepAlive = keepAlive && keepAlive2;
+                numRequests++;
+                master->urlLatency[startidx].noteLatency(timer.elapsedNs());
 
                 if (soapTraceLevel > 4)
                     master->logctx.CTXLOG("%sCALL: received response (%s) from %s:%d", master->wscType == STsoap ? "SOAP" : "HTTP",master->service.str(), url.host.str(), url.port);
@@ -2424,3 +2631,75 @@ IWSCAsyncFor * createWSCAsyncFor(CWSCHelper * _master, IXmlWriterExt &_xmlWriter
         initPersistentHandler();
     return new CWSCAsyncFor(_master, _xmlWriter, _inputRows, _options);
 }
+
+#ifdef _USE_CPPUNIT
+#include "unittests.hpp"
+
+class AdaptiveConcurrencyLimiterTests : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( AdaptiveConcurrencyLimiterTests );
+        CPPUNIT_TEST(testRisesWithFlatLatency);
+        CPPUNIT_TEST(testFallsWhenLatencyDoubles);
+        CPPUNIT_TEST(testNeverBelowOne);
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr unsigned __int64 oneMs = 1000000;
+
+    // Requests are made one at a time, so enter() never has to wait
+    static void sendRequests(AdaptiveConcurrencyLimiter & limiter, unsigned num, unsigned __int64 latencyNs)
+    {
+        for (unsigned i = 0; i < num; i++)
+        {
+            limiter.enter();
+            limiter.leave(latencyNs);
+        }
+    }
+
+public:
+    void testRisesWithFlatLatency()
+    {
+        AdaptiveConcurrencyLimiter limiter(2, 16);
+        sendRequests(limiter, 2, oneMs);
+        CPPUNIT_ASSERT_EQUAL(3U, limiter.queryLimit());
+        unsigned prev = limiter.queryLimit();
+        for (unsigned i = 0; i < 50; i++)
+        {
+            sendRequests(limiter, 10, oneMs);
+            unsigned next = limiter.queryLimit();
+            CPPUNIT_ASSERT(next >= prev);
+            prev = next;
+        }
+        CPPUNIT_ASSERT_EQUAL(16U, limiter.queryLimit());   // and never beyond the maximum
+    }
+
+    void testFallsWhenLatencyDoubles()
+    {
+        AdaptiveConcurrencyLimiter limiter(2, 16);
+        sendRequests(limiter, 500, oneMs);
+        CPPUNIT_ASSERT_EQUAL(16U, limiter.queryLimit());
+        sendRequests(limiter, 32, 2 * oneMs);    // at least one complete window at the doubled latency
+        CPPUNIT_ASSERT(limiter.queryLimit() < 16);
+    }
+
+    void testNeverBelowOne()
+    {
+        AdaptiveConcurrencyLimiter limiter(4, 16);
+        unsigned __int64 latencyNs = oneMs;
+        for (unsigned i = 0; i < 40; i++)
+        {
+            sendRequests(limiter, limiter.queryLimit(), latencyNs);
+            CPPUNIT_ASSERT(limiter.queryLimit() >= 1);
+            latencyNs *= 2;
+        }
+        CPPUNIT_ASSERT_EQUAL(1U, limiter.queryLimit());
+
+        // Requests still flow once the limit has bottomed out
+        sendRequests(limiter, 10, latencyNs);
+        CPPUNIT_ASSERT(limiter.queryLimit() >= 1);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( AdaptiveConcurrencyLimiterTests );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( AdaptiveConcurrencyLimiterTests, "AdaptiveConcurrencyLimiterTests" );
+
+#endif
@@ -22,6 +22,8 @@
 #include "errorlist.h"
 #include <exception>
 #include "jtask.hpp"
+#include "jmisc.hpp"
+#include "eclhelper.hpp"
 
 #ifdef _USE_TBB
 #include "tbb/parallel_sort.h"
@@ -749,3 +751,243 @@ void parmsortvecstableinplace(void ** rows, size_t n, const ICompare & compare,
         throw makeStringExceptionV(ERRORID_UNKNOWN, "TBB exception: %s", e.what());
     }
 }
+
+//-------------------------------------------------------------------------------------------------------------------
+// Radix sort of rows with a normalized key.  Each row is paired with the first 8 bytes of its key (as a big endian
+// integer), the pairs are sorted with a stable MSD radix sort, and any runs with identical prefixes are then sorted
+// with the compare.  The compare is only called to break ties, rather than O(n log n) times.
+
+struct RadixSortEntry
+{
+    unsigned __int64 prefix;
+    void * row;
+};
+
+static constexpr size_t radixInsertionThreshold = 32;
+static constexpr size_t radixParallelThreshold = 0x10000;
+static constexpr size_t radixKeyChunkSize = 0x4000;
+
+static void insertionSortPrefixes(RadixSortEntry * entries, size_t n)
+{
+    for (size_t i=1; i < n; i++)
+    {
+        RadixSortEntry next = entries[i];
+        size_t j = i;
+        while ((j > 0) && (entries[j-1].prefix > next.prefix))
+        {
+            entries[j] = entries[j-1];
+            j--;
+        }
+        entries[j] = next;
+    }
+}
+
+//Sort entries on the byte at shift (and all lower bytes), leaving the results in entries
+static void radixSortPrefixes(RadixSortEntry * entries, RadixSortEntry * temp, size_t n, unsigned shift)
+{
+    for (;;)
+    {
+        if (n <= radixInsertionThreshold)
+        {
+            insertionSortPrefixes(entries, n);
+            return;
+        }
+
+        size_t counts[256] = { 0 };
+        for (size_t i=0; i < n; i++)
+            counts[(byte)(entries[i].prefix >> shift)]++;
+
+        //If all entries are in the same bucket, move directly onto the next byte
+        if (counts[(byte)(entries[0].prefix >> shift)] != n)
+        {
+            size_t offsets[256];
+            size_t offset = 0;
+            for (unsigned i=0; i < 256; i++)
+            {
+                offsets[i] = offset;
+                offset += counts[i];
+            }
+            for (size_t i=0; i < n; i++)
+                temp[offsets[(byte)(entries[i].prefix >> shift)]++] = entries[i];
+            memcpy(entries, temp, n * sizeof(RadixSortEntry));
+
+            if (shift == 0)
+                return;
+
+            size_t start = 0;
+            for (unsigned i=0; i < 256; i++)
+            {
+                if (counts[i] > 1)
+                    radixSortPrefixes(entries + start, temp + start, counts[i], shift - 8);
+                start += counts[i];
+            }
+            return;
+        }
+
+        if (shift == 0)
+            return;
+        shift -= 8;
+    }
+}
+
+static void extractNormalizedKeys(RadixSortEntry * entries, void ** rows, size_t n, const ICompareNormalizedKey & compare)
+{
+    size32_t keySize = compare.getNormalizedKeySize();
+    size32_t prefixSize = std::min(keySize, (size32_t)sizeof(unsigned __int64));
+    MemoryAttr keyBuffer(keySize);
+    byte * key = (byte *)keyBuffer.bufferBase();
+    for (size_t i=0; i < n; i++)
+    {
+        compare.getNormalizedKey(key, rows[i]);
+        unsigned __int64 prefix = 0;
+        memcpy(&prefix, key, prefixSize);   // trailing bytes are zero, which preserves the ordering
+        _WINREV(prefix);
+        entries[i].prefix = prefix;
+        entries[i].row = rows[i];
+    }
+}
+
+void radixsortvecstableinplace(void ** rows, size_t n, const ICompareNormalizedKey & compare, void * workspace, unsigned maxCores)
+{
+    if (n <= 1)
+        return;
+
+    RadixSortEntry * entries = (RadixSortEntry *)workspace;
+    RadixSortEntry * temp = entries + n;
+    unsigned numCpus = getAffinityCpus();
+    if ((maxCores == 0) || (maxCores > numCpus))
+        maxCores = numCpus;
+    bool parallel = (n >= radixParallelThreshold) && (maxCores > 1);
+
+    //Calling the generated code to create the keys is likely to be the most expensive part, so do it in parallel
+    if (parallel)
+    {
+        unsigned numChunks = (unsigned)((n + radixKeyChunkSize - 1) / radixKeyChunkSize);
+        asyncFor(numChunks, maxCores, [&](unsigned i)
+        {
+            size_t start = (size_t)i * radixKeyChunkSize;
+            size_t num = std::min(radixKeyChunkSize, n - start);
+            extractNormalizedKeys(entries + start, rows + start, num, compare);
+        });
+    }
+    else
+        extractNormalizedKeys(entries, rows, n, compare);
+
+    if (parallel)
+    {
+        //Partition on the most significant byte, and then sort each of the partitions in parallel
+        size_t counts[256] = { 0 };
+        size_t offsets[256];
+        for (size_t i=0; i < n; i++)
+            counts[(byte)(entries[i].prefix >> 56)]++;
+        size_t offset = 0;
+        for (unsigned i=0; i < 256; i++)
+        {
+            offsets[i] = offset;
+            offset += counts[i];
+        }
+        size_t starts[256];
+        memcpy(starts, offsets, sizeof(starts));
+        for (size_t i=0; i < n; i++)
+            temp[offsets[(byte)(entries[i].prefix >> 56)]++] = entries[i];
+        memcpy(entries, temp, n * sizeof(RadixSortEntry));
+
+        asyncFor(256, maxCores, [&](unsigned i)
+        {
+            if (counts[i] > 1)
+                radixSortPrefixes(entries + starts[i], temp + starts[i], counts[i], 48);
+        });
+    }
+    else
+        radixSortPrefixes(entries, temp, n, 56);
+
+    for (size_t i=0; i < n; i++)
+        rows[i] = entries[i].row;
+
+    //Rows with the same prefix are sorted using the compare - the radix sort is stable, so the order is preserved.
+    void * * tempRows = (void * *)temp;
+    size_t start = 0;
+    while (start < n)
+    {
+        size_t end = start + 1;
+        while ((end < n) && (entries[end].prefix == entries[start].prefix))
+            end++;
+        size_t num = end - start;
+        if (num > singleThreadedMSortThreshold)
+            parmsortvecstableinplace(rows + start, num, compare, tempRows);
+        else if (num > 1)
+            msortvecstableinplace(rows + start, num, compare, tempRows);
+        start = end;
+    }
+}
+
+#ifdef _USE_CPPUNIT
+#include "eclrtl.hpp"
+#include "unittests.hpp"
+
+class RadixSortTests : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( RadixSortTests );
+        CPPUNIT_TEST(testRadixSort);
+    CPPUNIT_TEST_SUITE_END();
+
+    struct TestRow
+    {
+        int value;
+        unsigned sequence;
+    };
+
+    //Sorts on value, but the key only contains the top 16 bits of value, so the compare must be used to resolve ties
+    class TestCompare : public ICompareNormalizedKey
+    {
+    public:
+        virtual int docompare(const void * left, const void * right) const override
+        {
+            int l = ((const TestRow *)left)->value;
+            int r = ((const TestRow *)right)->value;
+            return (l < r) ? -1 : (l > r) ? +1 : 0;
+        }
+        virtual size32_t getNormalizedKeySize() const override { return 2; }
+        virtual void getNormalizedKey(byte * key, const void * row) const override
+        {
+            byte temp[sizeof(int)];
+            rtlWriteNormalizedInt(temp, ((const TestRow *)row)->value, sizeof(int));
+            memcpy(key, temp, 2);
+        }
+    };
+
+    void testRadixSort()
+    {
+        TestCompare compare;
+        for (size_t numRows : { 1, 10, 1000, 100000 })
+        {
+            for (unsigned range : { 10U, 100000000U })
+            {
+                std::vector<TestRow> rows(numRows);
+                std::vector<void *> ptrs(numRows);
+                for (size_t i=0; i < numRows; i++)
+                {
+                    rows[i].value = (int)(fastRand() % range) - (int)(range / 2);
+                    rows[i].sequence = (unsigned)i;
+                    ptrs[i] = &rows[i];
+                }
+                MemoryAttr workspace(radixSortWorkspaceSize(numRows));
+                radixsortvecstableinplace(ptrs.data(), numRows, compare, workspace.bufferBase());
+
+                for (size_t i=1; i < numRows; i++)
+                {
+                    const TestRow * prev = (const TestRow *)ptrs[i-1];
+                    const TestRow * cur = (const TestRow *)ptrs[i];
+                    CPPUNIT_ASSERT(prev->value <= cur->value);
+                    if (prev->value == cur->value)
+                        CPPUNIT_ASSERT(prev->sequence < cur->sequence);
+                }
+            }
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( RadixSortTests );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( RadixSortTests, "RadixSortTests" );
+
+#endif
@@ -37,6 +37,13 @@ inline void parsortvecstableinplace(void ** rows, size_t n, const ICompare & com
 #endif
 }
 
+struct ICompareNormalizedKey;
+
+//Stable MSD radix sort on a prefix of the normalized key, with ties resolved using the compare.
+//The workspace must be at least radixSortWorkspaceSize(n) bytes.
+inline size_t radixSortWorkspaceSize(size_t n) { return n * 2 * (sizeof(unsigned __int64) + sizeof(void *)); }
+extern THORHELPER_API void radixsortvecstableinplace(void ** rows, size_t n, const ICompareNormalizedKey & compare, void * workspace, unsigned maxCores=0);
+
 extern THORHELPER_API void tbbqsortvec(void **a, size_t n, const ICompare & compare);
 extern THORHELPER_API void tbbqsortstable(void ** rows, size_t n, const ICompare & compare, void ** temp);
 
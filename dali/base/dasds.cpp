@@ -16,6 +16,9 @@
 ############################################################################## */
 
 #include "platform.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include "jhash.hpp"
 #include "jlib.hpp"
 #include "jfile.hpp"
@@ -28,6 +31,7 @@
 #include "mplog.hpp"
 #include "jptree.ipp"
 #include "jqueue.tpp"
+#include "jflz.hpp"
 #include "dautils.hpp"
 #include "dadfs.hpp"
 #include "jmetrics.hpp"
@@ -63,6 +67,10 @@ static unsigned readWriteTimeout = 60000;
 #include "dacsds.ipp"
 #include "dasds.ipp"
 
+#ifdef _USE_CPPUNIT
+#include <cppunit/extensions/HelperMacros.h>
+#endif
+
 #define ALWAYSLAZY_NOTUSED
 #define NoMoreChildrenMarker ((__int64)-1)
 #define DEFAULT_MAXCLOSEDOWNRETRIES 20 // really do not want to give up.
@@ -73,6 +81,10 @@ static unsigned readWriteTimeout = 60000;
 #define DELTAINPROGRESS "delta.progress"
 #define DETACHINPROGRESS "detach.progress"
 #define TMPSAVENAME "dali_store_tmp.xml"
+#define SNAPSHOTNAME "dalisds_snapshot"   // binary snapshot manifest (.xml) and chunk files (_<n>.bin)
+#define DEFAULT_SNAPSHOT_THREADS 8
+#define DEFAULT_SNAPSHOT_BUCKETS 64              // # of chunks the children of a large branch are split into
+#define DEFAULT_SNAPSHOT_BUCKET_MIN_CHILDREN 1000 // # of children a branch needs to be split
 #define INIT_NODETABLE_SIZE 0x380000
 
 #define DEFAULT_LCIDLE_PERIOD (60*10)  // time has to be quiet for before blocking/saving (when using @lightweightCoalesce)
@@ -410,6 +422,7 @@ StringBuffer &constructStoreName(const char *storeBase, unsigned e, StringBuffer
 static CheckedCriticalSection loadStoreCrit, saveStoreCrit, saveIncCrit, nfyTableCrit, extCrit, blockedSaveCrit;
 class CCovenSDSManager;
 static CCovenSDSManager *SDSManager;
+class CServerStoreSnapshot;
 
 
 static StringAttr remoteBackupLocation;
@@ -2085,6 +2098,7 @@ private:
     StringBuffer blockedDelta;
     CBackupHandler backupHandler;
     bool backupOutOfSync = false;
+    Owned<CServerStoreSnapshot> snapshot;
 };
 
 ISDSManagerServer &querySDSServer()
@@ -2334,7 +2348,7 @@ CRemoteTreeBase *CRemoteTreeBase::createChild(int pos, const char *childName)
     else
     {
         unsigned e = 0;
-        if (children)
+        if (checkChildren())
         {
             PTree *match = (PTree *) children->query(childName);
             if (match)
@@ -2359,6 +2373,77 @@ CRemoteTreeBase *CRemoteTreeBase::createChild(int pos, const char *childName)
 
 static CheckedCriticalSection suppressedOrphanUnlockCrit; // to temporarily suppress unlockall
 static bool suppressedOrphanUnlock=false;
+/* Packed children are only expanded whilst the store is write locked, so that readers never see a partially expanded
+ * child map.  A connection expands any packed subtrees beneath its root when it is established, so requests made through
+ * a connection always see the same registered nodes.  Whilst any subtree remains packed, the other requests that can
+ * reach one (via an xpath from the root) take the write lock instead of a read lock.
+ */
+static std::atomic<unsigned> numPackedSubtrees{0};
+#define CHECKEDDALIPACKEDLOCKBLOCK(l, timeout)  Owned<CLCLockBlock> glue(block,__LINE__) = new CLCLockBlock(l, 0 == numPackedSubtrees, timeout, __FILE__, __LINE__)
+/* Traversals of the whole store (saves and GETSTORE), which only hold a read lock, set this flag so that iterating the
+ * children of a packed node iterates temporary copies, rather than expanding it.
+ */
+static thread_local bool transientPackedAccess = false;
+
+/* Packed children are the children serialized in turn (as IPropertyTree::serialize), followed by a blank name,
+ * compressed as a single block.  Returns the uncompressed size.
+ */
+static size32_t packTreeChildren(IPropertyTree &parent, MemoryBuffer &packed)
+{
+    MemoryBuffer mb;
+    Owned<IPropertyTreeIterator> iter = parent.getElements("*");
+    ForEach(*iter)
+        iter->query().serialize(mb);
+    mb.append(""); // element terminator
+    fastLZCompressToBuffer(packed, mb.length(), mb.toByteArray());
+    return mb.length();
+}
+
+// Creates a temporary (unregistered) tree called name, holding the uncompressed children written by packTreeChildren
+static IPropertyTree *createTransientChildren(const char *name, MemoryBuffer &src)
+{
+    Owned<IPropertyTree> tmp = createPTree(name);
+    StringAttr eName;
+    for (;;)
+    {
+        size32_t pos = src.getPos();
+        src.read(eName);
+        if (eName.isEmpty())
+            break;
+        src.reset(pos);
+        tmp->addPropTree(eName, createPTree(src));
+    }
+    return tmp.getClear();
+}
+
+// Serializes a temporary tree as serializeCutOffRT does, with serverId 0, so that clients treat the nodes as unregistered
+static void serializeTransientRT(IPropertyTree &tree, MemoryBuffer &tgt)
+{
+    static_cast<PTree &>(tree).serializeSelf(tgt);
+    tgt.append((__int64)0);
+    byte STIInfo = tree.hasChildren() ? STI_HaveChildren : 0;
+    tgt.append(STIInfo);
+    Owned<IPropertyTreeIterator> iter = tree.getElements("*");
+    ForEach(*iter)
+        serializeTransientRT(iter->query(), tgt);
+    tgt.append(""); // element terminator
+}
+
+// Iterates the children of a temporary tree, which it keeps alive
+class CTransientTreeIterator : public CInterfaceOf<IPropertyTreeIterator>
+{
+    Linked<IPropertyTree> root;
+    Owned<IPropertyTreeIterator> iter;
+public:
+    CTransientTreeIterator(IPropertyTree *_root, IPTIteratorCodes flags) : root(_root)
+    {
+        iter.setown(root->getElements("*", flags));
+    }
+    virtual bool first() override { return iter->first(); }
+    virtual bool next() override { return iter->next(); }
+    virtual bool isValid() override { return iter->isValid(); }
+    virtual IPropertyTree &query() override { return iter->query(); }
+};
 
 //Do not override the packing for this class - otherwise the fixed size allocator will allocate
 //misaligned objects, which can cause problems on some architectures (especially for atomic operations)
@@ -2370,6 +2455,7 @@ class CServerRemoteTree : public CRemoteTreeBase
     public:
         COrphanHandler() : ChildMap() { }
         ~COrphanHandler() { _releaseAll(); }
+        virtual bool isPacked() const { return false; }
         static void setOrphans(CServerRemoteTree &tree, bool tf)
         {
             if (tf)
@@ -2430,9 +2516,111 @@ class CServerRemoteTree : public CRemoteTreeBase
             return ChildMap::set(key, tree);
         }
     };
+    /* Children held as a single compressed serialized block, rather than as individual nodes.
+     * Used for large, rarely accessed subtrees, they are expanded in place the first time they are accessed.
+     * Packed nodes are not registered, and never contain externals, notifications or subscriptions.
+     */
+    class CPackedChildren : public COrphanHandler
+    {
+        MemoryAttr packedData;
+        std::atomic<bool> packed{true};
+    public:
+        CPackedChildren(MemoryBuffer &packed)
+        {
+            size32_t len = packed.length();
+            packedData.setOwn(len, packed.detach());
+        }
+        virtual bool isPacked() const override { return packed; }
+        size32_t queryPackedSize() const { return packedData.length(); }
+        void getSerialized(MemoryBuffer &out) const { fastLZDecompressToBuffer(out, packedData.get()); }
+        void expandFrom(ChildMap *expanded)
+        {
+            if (expanded)
+            {
+                SuperHashIteratorOf<IPropertyTree> iter(*expanded);
+                ForEach(iter)
+                {
+                    IPropertyTree &child = iter.query();
+                    set(child.queryName(), LINK(&child));
+                }
+            }
+            packed = false;
+            packedData.clear();
+        }
+    };
+
+    inline CPackedChildren *queryPackedChildren() const
+    {
+        if (children && static_cast<COrphanHandler *>(children)->isPacked())
+            return static_cast<CPackedChildren *>(children);
+        return nullptr;
+    }
+    bool getPackedChildren(MemoryBuffer &out) const
+    {
+        CPackedChildren *packedChildren = queryPackedChildren();
+        if (!packedChildren)
+            return false;
+        packedChildren->getSerialized(out);
+        return true;
+    }
+    void expandChildren()
+    {
+        // NB: only called whilst the store is write locked
+        CPackedChildren *packedChildren = queryPackedChildren();
+        if (!packedChildren)
+            return;
+        MemoryBuffer mb;
+        packedChildren->getSerialized(mb);
+
+        // Build under a temporary parent, so that multi-valued children are grouped as usual, then move them into the packed map.
+        // NB: readers only use the map once it is no longer marked as packed.
+        Owned<CServerRemoteTree> tmp = new CServerRemoteTree(queryName());
+        deserializeChildren(*tmp, mb);
+        packedChildren->expandFrom(tmp->children);
+        numPackedSubtrees--;
+        CHECKEDCRITICALBLOCK(suppressedOrphanUnlockCrit, fakeCritTimeout);
+        BoolSetBlock bblock(suppressedOrphanUnlock);
+        tmp->clearChildren();
+    }
+    static void deserializeChildren(CServerRemoteTree &parent, MemoryBuffer &src)
+    {
+        StringAttr eName;
+        for (;;)
+        {
+            size32_t pos = src.getPos();
+            src.read(eName);
+            if (eName.isEmpty())
+                break;
+            src.reset(pos); // reset to re-read tree name
+            Owned<CServerRemoteTree> child = new CServerRemoteTree();
+            child->deserializeSelf(src);
+            deserializeChildren(*child, src);
+            parent.addPropTree(eName, child.getClear());
+        }
+    }
+    static bool canPack(IPropertyTree &tree, const std::unordered_set<const IPropertyTree *> *connected)
+    {
+        Owned<IPropertyTreeIterator> iter = tree.getElements("*");
+        ForEach(*iter)
+        {
+            CServerRemoteTree &child = (CServerRemoteTree &)iter->query();
+            if (child.hasProp(EXT_ATTR) || child.hasProp(NOTIFY_ATTR) || child.isSubscribed())
+                return false;
+            if (connected && connected->count(&child))
+                return false;
+            if (!canPack(child, connected))
+                return false;
+        }
+        return true;
+    }
 
     static void clearTree(CServerRemoteTree &tree)
     {
+        if (tree.queryPackedChildren())
+        {
+            tree.clear();
+            return; // packed descendants are not registered
+        }
         Owned<IPropertyTreeIterator> iter = tree.getElements("*");
         ForEach(*iter)
         {
@@ -2519,6 +2707,71 @@ public:
 
     virtual bool isOrphaned() const override { return IptFlagTst(flags, ipt_ext5); }
 
+    virtual ChildMap *checkChildren() const override
+    {
+        if (queryPackedChildren())
+            const_cast<CServerRemoteTree *>(this)->expandChildren();
+        return children;
+    }
+    virtual bool hasChildren() const override
+    {
+        return children && (queryPackedChildren() || children->count());
+    }
+    virtual IPropertyTreeIterator *getElements(const char *xpath, IPTIteratorCodes flags = iptiter_null) const override
+    {
+        if (transientPackedAccess && xpath && streq(xpath, "*"))
+        {
+            Owned<IPropertyTree> tmp = getTransientChildren();
+            if (tmp)
+                return new CTransientTreeIterator(tmp, flags);
+        }
+        return CRemoteTreeBase::getElements(xpath, flags);
+    }
+    // Returns a temporary (unregistered) copy of this node's packed children, or null if the children are not packed
+    IPropertyTree *getTransientChildren() const
+    {
+        MemoryBuffer mb;
+        if (!getPackedChildren(mb))
+            return nullptr;
+        return createTransientChildren(queryName(), mb);
+    }
+    bool isPacked() const { return nullptr != queryPackedChildren(); }
+    // Expand this node's packed children, or else any packed subtrees beneath it.  The store must be write locked.
+    void expandPackedSubtrees()
+    {
+        if (isPacked())
+        {
+            expandChildren(); // packed subtrees are never nested
+            return;
+        }
+        if (!children)
+            return;
+        Owned<IPropertyTreeIterator> iter = getElements("*");
+        ForEach(*iter)
+            ((CServerRemoteTree &)iter->query()).expandPackedSubtrees();
+    }
+    /* Replace the children of this node with a packed copy, if no descendant needs to remain registered.
+     * Only safe whilst there are no connections to the subtree, i.e. when the store is loaded, or the store is write
+     * locked and no connection is rooted within or above this node.
+     */
+    bool packChildren(offset_t &unpackedSize, offset_t &packedSize, const std::unordered_set<const IPropertyTree *> *connected)
+    {
+        if (!children || !children->count() || queryPackedChildren() || !canPack(*this, connected))
+            return false;
+        MemoryBuffer mb;
+        unpackedSize += packTreeChildren(*this, mb);
+        CPackedChildren *packedChildren = new CPackedChildren(mb);
+        packedSize += packedChildren->queryPackedSize();
+
+        ChildMap *old = children;
+        children = packedChildren;
+        numPackedSubtrees++;
+        CHECKEDCRITICALBLOCK(suppressedOrphanUnlockCrit, fakeCritTimeout);
+        BoolSetBlock bblock(suppressedOrphanUnlock);
+        old->Release();
+        return true;
+    }
+
     virtual void setServerId(__int64 _serverId) override
     {
         if (serverId && serverId != _serverId)
@@ -2573,6 +2826,19 @@ public:
             cutoff = FETCH_ENTIRE_COND; // NB: can change all _COND references to FETCH_ENTIRE if not using alwaysFetch anymore
 #endif
 
+        if ((cutoff < 0 || depth<cutoff) && transientPackedAccess)
+        {
+            // Not on behalf of a connection (e.g. GETSTORE), so serialize temporary copies rather than expanding
+            Owned<IPropertyTree> tmp = getTransientChildren();
+            if (tmp)
+            {
+                Owned<IPropertyTreeIterator> iter = tmp->getElements("*");
+                ForEach(*iter)
+                    serializeTransientRT(iter->query(), tgt);
+                tgt.append("");
+                return;
+            }
+        }
         if (cutoff < 0 || depth<cutoff)
         {
             IPropertyTreeIterator *iter = getElements("*");
@@ -2604,7 +2870,7 @@ public:
             mb.append(serverId);
         }
         byte STIInfo = 0;
-        if (children && children->count())
+        if (hasChildren())
             STIInfo += STI_HaveChildren;
         if (index)
             STIInfo += STI_External;
@@ -2671,6 +2937,50 @@ private:
 friend class COrphanHandler;
 };
 
+// Adds the nodes of a subtree that a connection is rooted at to connected
+static void noteConnectedSubtree(IPropertyTree &tree, std::unordered_set<const IPropertyTree *> &connected)
+{
+    if (!connected.insert(&tree).second)
+        return; // within another connection's subtree, so already noted
+    Owned<IPropertyTreeIterator> iter = tree.getElements("*");
+    ForEach(*iter)
+        noteConnectedSubtree(iter->query(), connected);
+}
+
+/* Pack the children of the nodes matching each of a comma separated list of xpaths, e.g. "WorkUnits/*"
+ * Nodes in connected (i.e. within a connected subtree) are not packed, since connections hold their registered ids.
+ */
+static unsigned packServerSubtrees(CServerRemoteTree &root, const char *xpaths, const std::unordered_set<const IPropertyTree *> *connected=nullptr)
+{
+    unsigned totalPacked = 0;
+    StringArray paths;
+    paths.appendList(xpaths, ",");
+    ForEachItemIn(p, paths)
+    {
+        const char *xpath = paths.item(p);
+        IArrayOf<CServerRemoteTree> matches;
+        Owned<IPropertyTreeIterator> iter = root.getElements(xpath);
+        ForEach(*iter)
+            matches.append(*LINK((CServerRemoteTree *)&iter->query()));
+        iter.clear();
+        unsigned packed = 0;
+        offset_t unpackedSize = 0, packedSize = 0;
+        ForEachItemIn(m, matches)
+        {
+            CServerRemoteTree &match = matches.item(m);
+            if (!match.IsShared()) // within a subtree that has already been packed
+                continue;
+            if (connected && connected->count(&match))
+                continue;
+            if (match.packChildren(unpackedSize, packedSize, connected))
+                packed++;
+        }
+        PROGLOG("Packed %u of %u subtrees matching '%s', %" I64F "u bytes compressed to %" I64F "u", packed, matches.ordinality(), xpath, unpackedSize, packedSize);
+        totalPacked += packed;
+    }
+    return totalPacked;
+}
+
 class CNodeSubscriberContainer : public CSubscriberContainerBase
 {
     StringAttr xpath;
@@ -2900,6 +3210,574 @@ IPropertyTree *createServerTree(const char *tag=NULL)
     return new CServerRemoteTree(tag);
 }
 
+/* EXPERIMENTAL, off by default: optional binary copy of the store (@experimentalBinarySnapshot), written alongside the
+ * XML store of the same edition. The XML store (and its deltas) remains the primary, authoritative store - the snapshot
+ * is only used to speed up loading, and when enabled each save writes both, so saves take longer, not less.
+ * Each top-level branch is serialized to its own checksummed chunk file and a manifest records the chunks.
+ * Unique branches with many children (e.g. WorkUnits) are split further: the branch node itself is written to one chunk
+ * and its children to a fixed number of bucket chunks, chosen by a hash of the child's name (so same named children stay
+ * together and in order).
+ * Deltas note the branches, and the children of those branches, that they change. Only the affected chunks are rewritten
+ * when the store is saved, unchanged chunks are carried forward. Changes are tracked no finer than the children of a
+ * top-level branch, e.g. a change to one file scope rewrites the bucket holding all the Files/Scope children.
+ * On load all chunks are verified before any are deserialized (in parallel); any mismatch with the current
+ * XML edition falls back to loading the XML store.
+ * Loaded trees are plain property trees, the server's derived class creates registered nodes.
+ */
+class CStoreSnapshot : public CInterface
+{
+    struct DirtyBranch
+    {
+        bool whole = false;
+        std::unordered_set<std::string> children; // names of the changed children
+    };
+    StringAttr dataPath;
+    unsigned maxThreads;
+    unsigned numBuckets;
+    unsigned minBucketChildren;
+    CriticalSection crit;
+    std::unordered_map<std::string, DirtyBranch> dirtyBranches;
+    bool allDirty = true; // in-memory tree has not yet been written by this process
+    Owned<IPropertyTree> manifest;
+
+    StringBuffer &getFilename(StringBuffer &res, const char *tail) const
+    {
+        return res.append(dataPath).append(tail);
+    }
+    static const char *getChunkName(StringBuffer &res, unsigned chunk)
+    {
+        return res.appendf(SNAPSHOTNAME "_%u.bin", chunk).str();
+    }
+    static unsigned getBucket(const char *childName, unsigned buckets)
+    {
+        return hashc((const unsigned char *)childName, (unsigned)strlen(childName), 0) % buckets;
+    }
+    IPropertyTree *readManifest() const
+    {
+        StringBuffer filename;
+        getFilename(filename, SNAPSHOTNAME ".xml");
+        OwnedIFile iFile = createIFile(filename);
+        if (!iFile->exists())
+            return nullptr;
+        return createPTreeFromXMLFile(filename);
+    }
+    void writeChunk(IPropertyTree &entry, MemoryBuffer &mb) const
+    {
+        StringBuffer filename;
+        getFilename(filename, entry.queryProp("@file"));
+        OwnedIFile iFile = createIFile(filename);
+        OwnedIFileIO iFileIO = iFile->open(IFOcreate);
+        if (!iFileIO)
+            throw MakeStringException(0, "Failed to create SDS snapshot chunk '%s'", filename.str());
+        iFileIO->write(0, mb.length(), mb.toByteArray());
+        iFileIO->close();
+        entry.setPropInt64("@size", mb.length());
+        entry.setPropInt64("@crc", crc32(mb.toByteArray(), mb.length(), 0));
+    }
+    void readChunk(IPropertyTree &entry, MemoryBuffer &mb) const
+    {
+        StringBuffer filename;
+        getFilename(filename, entry.queryProp("@file"));
+        OwnedIFile iFile = createIFile(filename);
+        OwnedIFileIO iFileIO = iFile->open(IFOread);
+        if (!iFileIO)
+            throw MakeStringException(0, "Failed to open SDS snapshot chunk '%s'", filename.str());
+        size32_t size = (size32_t)entry.getPropInt64("@size");
+        if ((read(iFileIO, 0, size, mb) != size) || (iFileIO->size() != size))
+            throw MakeStringException(0, "SDS snapshot chunk '%s' has unexpected size", filename.str());
+        if (crc32(mb.toByteArray(), size, 0) != (unsigned)entry.getPropInt64("@crc"))
+            throw MakeStringException(0, "SDS snapshot chunk '%s' failed crc check", filename.str());
+    }
+    void deserializeTree(PTree &tree, MemoryBuffer &src, ICopyArrayOf<IPropertyTree> &externalCandidates) const
+    {
+        tree.deserializeSelf(src);
+        if (isExternalCandidate(tree))
+            externalCandidates.append(tree);
+        StringAttr eName;
+        for (;;)
+        {
+            size32_t pos = src.getPos();
+            src.read(eName);
+            if (eName.isEmpty())
+                break;
+            src.reset(pos); // reset to re-read tree name
+            PTree *child = createNode();
+            deserializeTree(*child, src, externalCandidates);
+            tree.addPropTree(eName, child);
+        }
+    }
+    // Deserializes the trees held in a chunk, which are either whole branches, a branch node on its own, or the children of a bucket
+    void deserializeChunk(IPropertyTree &entry, MemoryBuffer &mb, ICopyArrayOf<IPropertyTree> &trees, ICopyArrayOf<IPropertyTree> &externalCandidates) const
+    {
+        if (entry.hasProp("@buckets"))
+        {
+            PTree *node = createNode();
+            node->deserializeSelf(mb);
+            if (isExternalCandidate(*node))
+                externalCandidates.append(*node);
+            trees.append(*node);
+            return;
+        }
+        StringAttr eName;
+        for (;;)
+        {
+            size32_t pos = mb.getPos();
+            mb.read(eName);
+            if (eName.isEmpty())
+                break;
+            mb.reset(pos); // reset to re-read tree name
+            PTree *tree = createNode();
+            deserializeTree(*tree, mb, externalCandidates);
+            trees.append(*tree);
+        }
+    }
+    void removeUnreferencedChunks(IPropertyTree &current) const
+    {
+        Owned<IDirectoryIterator> di = createDirectoryIterator(dataPath.isEmpty() ? "." : dataPath.get(), SNAPSHOTNAME "_*.bin");
+        ForEach(*di)
+        {
+            StringBuffer name;
+            di->getName(name);
+            VStringBuffer xpath("//*[@file=\"%s\"]", name.str());
+            if (!current.hasProp(xpath))
+                di->query().remove();
+        }
+    }
+    /* Writes the chunks of a branch. If dirtyBuckets is empty the whole branch is written, and a unique branch with enough
+     * children is split into buckets, otherwise only the branch node and the dirty buckets of a split branch are rewritten.
+     */
+    void writeBranch(IPropertyTree &root, IPropertyTree &entry, const std::vector<bool> &dirtyBuckets, std::atomic<unsigned> &nextChunk, std::atomic<unsigned> &chunksWritten) const
+    {
+        const char *name = entry.queryProp("@name");
+        StringBuffer chunkName;
+        if (dirtyBuckets.empty() && (1 != entry.getPropInt("@count")))
+        {
+            MemoryBuffer mb;
+            Owned<IPropertyTreeIterator> branches = root.getElements(name);
+            ForEach(*branches)
+                branches->query().serialize(mb);
+            mb.append(""); // element terminator
+            writeChunk(entry, mb);
+            chunksWritten++;
+            return;
+        }
+        IPropertyTree *branch = root.queryPropTree(name);
+        assertex(branch);
+        unsigned buckets = dirtyBuckets.empty() ? numBuckets : entry.getPropInt("@buckets");
+        std::unique_ptr<MemoryBuffer[]> bucketData(new MemoryBuffer[buckets]);
+        unsigned numChildren = 0;
+        Owned<IPropertyTreeIterator> iter = branch->getElements("*");
+        ForEach(*iter)
+        {
+            IPropertyTree &child = iter->query();
+            unsigned bucket = getBucket(child.queryName(), buckets);
+            if (dirtyBuckets.empty() || dirtyBuckets[bucket])
+                child.serialize(bucketData[bucket]);
+            numChildren++;
+        }
+        iter.clear();
+        MemoryBuffer mb;
+        static_cast<PTree *>(branch)->serializeSelf(mb);
+        if (dirtyBuckets.empty() && (numChildren < minBucketChildren))
+        {
+            // not worth splitting, write it whole
+            for (unsigned b=0; b<buckets; b++)
+                mb.append(bucketData[b].length(), bucketData[b].toByteArray());
+            mb.append("").append(""); // end of branch children, and of branches
+            writeChunk(entry, mb);
+            chunksWritten++;
+            return;
+        }
+        if (!dirtyBuckets.empty()) // the carried forward file is still referenced by the current manifest
+            entry.setProp("@file", getChunkName(chunkName, nextChunk++));
+        writeChunk(entry, mb);
+        chunksWritten++;
+        if (dirtyBuckets.empty())
+        {
+            entry.setPropInt("@buckets", buckets);
+            for (unsigned b=0; b<buckets; b++)
+                entry.addPropTree("Bucket");
+        }
+        unsigned b = 0;
+        Owned<IPropertyTreeIterator> bucketIter = entry.getElements("Bucket");
+        ForEach(*bucketIter)
+        {
+            if (dirtyBuckets.empty() || dirtyBuckets[b])
+            {
+                IPropertyTree &bucketEntry = bucketIter->query();
+                bucketEntry.setProp("@file", getChunkName(chunkName.clear(), nextChunk++));
+                bucketData[b].append(""); // element terminator
+                writeChunk(bucketEntry, bucketData[b]);
+                chunksWritten++;
+            }
+            b++;
+        }
+    }
+    void setAllDirty()
+    {
+        allDirty = true;
+        dirtyBranches.clear();
+    }
+    static void setWholeDirty(DirtyBranch &branch)
+    {
+        branch.whole = true;
+        branch.children.clear();
+    }
+    static bool isWild(const std::string &name)
+    {
+        return name.empty() || (std::string::npos != name.find_first_of("*?"));
+    }
+    // Notes the children named by a change to a top-level branch
+    static void noteChildChanges(DirtyBranch &branch, IPropertyTree &change)
+    {
+        if (branch.whole)
+            return;
+        Owned<IPropertyTreeIterator> iter = change.getElements("*");
+        ForEach(*iter)
+        {
+            IPropertyTree &childChange = iter->query();
+            const char *tag = childChange.queryName();
+            if (streq(RESERVED_CHANGE_NODE, tag) || streq(DELETE_TAG, tag))
+            {
+                const char *childName = childChange.queryProp("@name");
+                if (!childName)
+                {
+                    setWholeDirty(branch);
+                    return;
+                }
+                branch.children.insert(childName);
+            }
+            else if (streq(RENAME_TAG, tag))
+            {
+                const char *from = childChange.queryProp("@from");
+                const char *to = childChange.queryProp("@to");
+                if (!from || !to)
+                {
+                    setWholeDirty(branch);
+                    return;
+                }
+                branch.children.insert(from);
+                branch.children.insert(to);
+            }
+            else if (!streq(ATTRCHANGE_TAG, tag) && !streq(ATTRDELETE_TAG, tag))
+            {
+                setWholeDirty(branch);
+                return;
+            }
+            // attribute changes are to the branch node itself, which is always rewritten if the branch is noted
+        }
+    }
+protected:
+    virtual PTree *createNode() const { return static_cast<PTree *>(createPTree()); }
+    virtual bool isExternalCandidate(PTree &node) const { return false; }
+public:
+    CStoreSnapshot(const char *_dataPath, unsigned _maxThreads, unsigned _numBuckets=DEFAULT_SNAPSHOT_BUCKETS, unsigned _minBucketChildren=DEFAULT_SNAPSHOT_BUCKET_MIN_CHILDREN)
+        : dataPath(_dataPath), maxThreads(_maxThreads), numBuckets(_numBuckets), minBucketChildren(_minBucketChildren)
+    {
+        if (0 == maxThreads)
+            maxThreads = 1;
+        if (0 == numBuckets)
+            numBuckets = 1;
+    }
+    void noteChange(const char *path, IPropertyTree &changeTree)
+    {
+        CriticalBlock b(crit);
+        if (allDirty)
+            return;
+        while ('/' == *path)
+            path++;
+        if (!*path)
+        {
+            // change made via a connection to the root, note each top-level branch it names
+            Owned<IPropertyTreeIterator> iter = changeTree.getElements("*");
+            ForEach(*iter)
+            {
+                IPropertyTree &change = iter->query();
+                const char *tag = change.queryName();
+                if (streq(RESERVED_CHANGE_NODE, tag) && change.hasProp("@name"))
+                {
+                    DirtyBranch &branch = dirtyBranches[change.queryProp("@name")];
+                    if (change.getPropBool("@new") || change.getPropBool("@replace"))
+                        setWholeDirty(branch);
+                    else
+                        noteChildChanges(branch, change);
+                }
+                else if (streq(DELETE_TAG, tag) && change.hasProp("@name"))
+                    setWholeDirty(dirtyBranches[change.queryProp("@name")]);
+                else if (streq(RENAME_TAG, tag) && change.hasProp("@from") && change.hasProp("@to"))
+                {
+                    setWholeDirty(dirtyBranches[change.queryProp("@from")]);
+                    setWholeDirty(dirtyBranches[change.queryProp("@to")]);
+                }
+                else if (!streq(ATTRCHANGE_TAG, tag) && !streq(ATTRDELETE_TAG, tag)) // the root node is always rewritten
+                {
+                    setAllDirty();
+                    return;
+                }
+            }
+            return;
+        }
+        const char *end = path;
+        while (*end && '/' != *end && '[' != *end)
+            end++;
+        std::string branchName(path, end-path);
+        if (isWild(branchName))
+        {
+            setAllDirty();
+            return;
+        }
+        DirtyBranch &branch = dirtyBranches[branchName];
+        if (branch.whole)
+            return;
+        if (!*end)
+        {
+            // change made via a connection to the branch
+            if (changeTree.getPropBool("@new") || changeTree.getPropBool("@replace"))
+                setWholeDirty(branch);
+            else
+                noteChildChanges(branch, changeTree);
+            return;
+        }
+        if ('[' == *end) // one of several branches of the same name, which are never split
+        {
+            setWholeDirty(branch);
+            return;
+        }
+        path = end+1;
+        end = path;
+        while (*end && '/' != *end && '[' != *end)
+            end++;
+        std::string childName(path, end-path);
+        if (isWild(childName))
+            setWholeDirty(branch);
+        else
+            branch.children.insert(childName);
+    }
+    void save(IPropertyTree &root, unsigned edition, unsigned storeCrc)
+    {
+        CCycleTimer timer;
+        std::unordered_map<std::string, DirtyBranch> dirty;
+        bool all;
+        {
+            CriticalBlock b(crit);
+            all = allDirty;
+            dirty.swap(dirtyBranches);
+            allDirty = false;
+        }
+        try
+        {
+            if (!manifest)
+                manifest.setown(readManifest());
+            std::atomic<unsigned> nextChunk{manifest ? (unsigned)manifest->getPropInt("@nextChunk") : 0};
+            std::atomic<unsigned> chunksWritten{0};
+
+            // group the top-level branches by name, preserving their order
+            StringArray names;
+            UnsignedArray counts;
+            Owned<IPropertyTreeIterator> iter = root.getElements("*");
+            ForEach(*iter)
+            {
+                const char *name = iter->query().queryName();
+                aindex_t pos = names.find(name);
+                if (NotFound == pos)
+                {
+                    names.append(name);
+                    counts.append(1);
+                }
+                else
+                    counts.replace(counts.item(pos)+1, pos);
+            }
+            iter.clear();
+
+            Owned<IPropertyTree> newManifest = createPTree(SNAPSHOTNAME);
+            IArrayOf<IPropertyTree> toWrite;
+            std::vector<std::vector<bool>> toWriteBuckets;
+            IPropertyTree *rootEntry = newManifest->addPropTree("Root");
+            StringBuffer chunkName;
+            rootEntry->setProp("@file", getChunkName(chunkName, nextChunk++));
+            ForEachItemIn(n, names)
+            {
+                const char *name = names.item(n);
+                IPropertyTree *existing = nullptr;
+                const DirtyBranch *dirtyBranch = nullptr;
+                if (manifest && !all)
+                {
+                    VStringBuffer xpath("Branch[@name=\"%s\"]", name);
+                    existing = manifest->queryPropTree(xpath);
+                    if (existing && ((unsigned)existing->getPropInt("@count") != counts.item(n)))
+                        existing = nullptr;
+                    auto it = dirty.find(name);
+                    if (it != dirty.end())
+                        dirtyBranch = &it->second;
+                }
+                if (existing && !dirtyBranch)
+                    newManifest->addPropTree("Branch", createPTreeFromIPT(existing));
+                else if (existing && !dirtyBranch->whole && existing->hasProp("@buckets"))
+                {
+                    IPropertyTree *entry = newManifest->addPropTree("Branch", createPTreeFromIPT(existing));
+                    std::vector<bool> dirtyBuckets(entry->getPropInt("@buckets"), false);
+                    for (const std::string &child : dirtyBranch->children)
+                        dirtyBuckets[getBucket(child.c_str(), dirtyBuckets.size())] = true;
+                    toWrite.append(*LINK(entry));
+                    toWriteBuckets.push_back(std::move(dirtyBuckets));
+                }
+                else
+                {
+                    IPropertyTree *entry = newManifest->addPropTree("Branch");
+                    entry->setProp("@name", name);
+                    entry->setPropInt("@count", counts.item(n));
+                    entry->setProp("@file", getChunkName(chunkName.clear(), nextChunk++));
+                    toWrite.append(*LINK(entry));
+                    toWriteBuckets.emplace_back(); // whole branch
+                }
+            }
+
+            MemoryBuffer rootMb;
+            static_cast<PTree &>(root).serializeSelf(rootMb);
+            writeChunk(*rootEntry, rootMb);
+            chunksWritten++;
+            asyncFor(toWrite.ordinality(), maxThreads, true, [&](unsigned i)
+            {
+                BoolSetBlock transientBlock(transientPackedAccess); // flag is per thread
+                writeBranch(root, toWrite.item(i), toWriteBuckets[i], nextChunk, chunksWritten);
+            });
+
+            newManifest->setPropInt("@edition", edition);
+            newManifest->setPropInt64("@storeCrc", storeCrc);
+            newManifest->setPropInt("@nextChunk", nextChunk);
+            StringBuffer tmpFilename, filename;
+            getFilename(tmpFilename, SNAPSHOTNAME ".tmp");
+            getFilename(filename, SNAPSHOTNAME ".xml");
+            saveXML(tmpFilename, newManifest);
+            renameFile(filename, tmpFilename, true);
+            manifest.setown(newManifest.getClear());
+            removeUnreferencedChunks(*manifest);
+            PROGLOG("SDS snapshot for store %u saved, %u chunks written, %u of %u branches changed (%u ms)", edition, (unsigned)chunksWritten, toWrite.ordinality(), names.ordinality(), timer.elapsedMs());
+        }
+        catch (IException *e)
+        {
+            EXCLOG(e, "Failed to save SDS snapshot");
+            e->Release();
+            CriticalBlock b(crit);
+            setAllDirty();
+        }
+    }
+    IPropertyTree *load(unsigned edition, unsigned storeCrc, ICopyArrayOf<IPropertyTree> &externalCandidates)
+    {
+        CCycleTimer timer;
+        IArrayOf<IPropertyTree> entries;
+        std::unique_ptr<MemoryBuffer[]> chunks;
+        try
+        {
+            Owned<IPropertyTree> current = readManifest();
+            if (!current)
+                return nullptr;
+            if (((unsigned)current->getPropInt("@edition") != edition) || ((unsigned)current->getPropInt64("@storeCrc") != storeCrc))
+            {
+                PROGLOG("SDS snapshot (store %u) does not match current store %u, loading XML store", current->getPropInt("@edition"), edition);
+                return nullptr;
+            }
+            IPropertyTree *rootEntry = current->queryPropTree("Root");
+            if (!rootEntry)
+                throw MakeStringException(0, "SDS snapshot manifest has no root entry");
+            entries.append(*LINK(rootEntry));
+            Owned<IPropertyTreeIterator> iter = current->getElements("Branch");
+            ForEach(*iter)
+            {
+                IPropertyTree &entry = iter->query();
+                entries.append(*LINK(&entry));
+                if (entry.hasProp("@buckets"))
+                {
+                    unsigned buckets = entry.getPropInt("@buckets");
+                    if ((0 == buckets) || (entry.getCount("Bucket") != buckets))
+                        throw MakeStringException(0, "SDS snapshot manifest has inconsistent buckets for branch '%s'", entry.queryProp("@name"));
+                    Owned<IPropertyTreeIterator> bucketIter = entry.getElements("Bucket");
+                    ForEach(*bucketIter)
+                        entries.append(*LINK(&bucketIter->query()));
+                }
+            }
+            chunks.reset(new MemoryBuffer[entries.ordinality()]);
+            asyncFor(entries.ordinality(), maxThreads, true, [&](unsigned i)
+            {
+                readChunk(entries.item(i), chunks[i]);
+            });
+            manifest.setown(current.getClear());
+        }
+        catch (IException *e)
+        {
+            EXCLOG(e, "SDS snapshot invalid, loading XML store");
+            e->Release();
+            return nullptr;
+        }
+
+        // All chunks verified. NB: partially built trees are never released on failure, as releasing nodes deletes their externals.
+        PTree *root = createNode();
+        root->deserializeSelf(chunks[0]);
+        unsigned numChunks = entries.ordinality();
+        std::vector<ICopyArrayOf<IPropertyTree>> trees(numChunks), candidates(numChunks);
+        asyncFor(numChunks-1, maxThreads, true, [&](unsigned i)
+        {
+            deserializeChunk(entries.item(i+1), chunks[i+1], trees[i+1], candidates[i+1]);
+            chunks[i+1].clear();
+        });
+        unsigned numBranches = 0;
+        for (unsigned c=1; c<numChunks; c++)
+        {
+            IPropertyTree &entry = entries.item(c);
+            ForEachItemIn(t, candidates[c])
+                externalCandidates.append(candidates[c].item(t));
+            if (entry.hasProp("@buckets"))
+            {
+                // the branch node, followed by the chunks of its children
+                IPropertyTree &branch = trees[c].item(0);
+                unsigned buckets = entry.getPropInt("@buckets");
+                for (unsigned b=0; b<buckets; b++)
+                {
+                    c++;
+                    ForEachItemIn(t, trees[c])
+                    {
+                        IPropertyTree &child = trees[c].item(t);
+                        branch.addPropTree(child.queryName(), &child);
+                    }
+                    ForEachItemIn(t2, candidates[c])
+                        externalCandidates.append(candidates[c].item(t2));
+                }
+                root->addPropTree(branch.queryName(), &branch);
+                numBranches++;
+            }
+            else
+            {
+                ForEachItemIn(t, trees[c])
+                {
+                    IPropertyTree &tree = trees[c].item(t);
+                    root->addPropTree(tree.queryName(), &tree);
+                }
+                numBranches += trees[c].ordinality();
+            }
+        }
+        PROGLOG("SDS snapshot for store %u loaded, %u branches from %u chunks (%u ms)", edition, numBranches, numChunks, timer.elapsedMs());
+        return root;
+    }
+};
+
+class CServerStoreSnapshot : public CStoreSnapshot
+{
+protected:
+    virtual PTree *createNode() const override { return new CServerRemoteTree(); }
+    virtual bool isExternalCandidate(PTree &node) const override { return static_cast<CServerRemoteTree &>(node).testExternalCandidate(); }
+public:
+    using CStoreSnapshot::CStoreSnapshot;
+
+    CServerRemoteTree *load(unsigned edition, unsigned storeCrc, ICopyArrayOf<CServerRemoteTree> &externalCandidates)
+    {
+        ICopyArrayOf<IPropertyTree> candidates;
+        IPropertyTree *root = CStoreSnapshot::load(edition, storeCrc, candidates);
+        ForEachItemIn(c, candidates)
+            externalCandidates.append(static_cast<CServerRemoteTree &>(candidates.item(c)));
+        return static_cast<CServerRemoteTree *>(root);
+    }
+};
+
 // JCSMORE - these should be error conditions, for consistency with previous release not so for now.
 #define consistencyCheck(TEXT, IDTREE, LOCALTREE, PATH, PARENTNAME, ID)                                                                     \
     if (!IDTREE)                                                                                                            \
@@ -3773,6 +4651,7 @@ int CSDSTransactionServer::run()
                             mb.clear();
                             if (root)
                             {
+                                BoolSetBlock transientBlock(transientPackedAccess); // serialize packed subtrees without expanding them
                                 mb.append(DAMP_SDSREPLY_OK);
                                 root->serializeCutOffRT(mb);
                             }
@@ -4105,7 +4984,7 @@ void CSDSTransactionServer::processMessage(CMessageBuffer &mb)
                 if (queryTransactionLogging())
                     transactionLog.log("xpath='%s' mode=%d", xpath.get(), (unsigned)mode);
                 Owned<LinkingCriticalBlock> connectCritBlock = new LinkingCriticalBlock(manager.connectCrit, __FILE__, __LINE__);
-                if (RTM_CREATE == (mode & RTM_CREATE_MASK) || RTM_CREATE_QUERY == (mode & RTM_CREATE_MASK))
+                if (RTM_CREATE == (mode & RTM_CREATE_MASK) || RTM_CREATE_QUERY == (mode & RTM_CREATE_MASK) || numPackedSubtrees)
                     lockBlock.setown(new CLCLockBlock(manager.dataRWLock, false, readWriteTimeout, __FILE__, __LINE__));
                 else
                     lockBlock.setown(new CLCLockBlock(manager.dataRWLock, true, readWriteTimeout, __FILE__, __LINE__));
@@ -4152,7 +5031,7 @@ void CSDSTransactionServer::processMessage(CMessageBuffer &mb)
                 Owned<IMultipleConnector> mConnect = deserializeIMultipleConnector(mb);
                 mb.clear();
 
-                lockBlock.setown(new CLCLockBlock(manager.dataRWLock, true, readWriteTimeout, __FILE__, __LINE__));
+                lockBlock.setown(new CLCLockBlock(manager.dataRWLock, 0 == numPackedSubtrees, readWriteTimeout, __FILE__, __LINE__));
 
                 try
                 {
@@ -4500,7 +5379,7 @@ void CSDSTransactionServer::processMessage(CMessageBuffer &mb)
                         ascending?"true":"false", from, limit);
                 }
                 mb.clear();
-                CHECKEDDALIREADLOCKBLOCK(manager.dataRWLock, readWriteTimeout);
+                CHECKEDDALIPACKEDLOCKBLOCK(manager.dataRWLock, readWriteTimeout);
                 Owned<IPropertyTree> matchTree = SDSManager->getXPathsSortLimitMatchTree(xpath, matchXPath, sortBy, caseinsensitive, ascending, from, limit);
                 if (matchTree)
                 {
@@ -4526,7 +5405,7 @@ void CSDSTransactionServer::processMessage(CMessageBuffer &mb)
             }
             case DAMP_SDSCMD_GETELEMENTSRAW:
             {
-                CHECKEDDALIREADLOCKBLOCK(manager.dataRWLock, readWriteTimeout);
+                CHECKEDDALIPACKEDLOCKBLOCK(manager.dataRWLock, readWriteTimeout);
                 StringAttr _xpath;
                 mb.read(_xpath);
                 if (queryTransactionLogging())
@@ -4556,7 +5435,7 @@ void CSDSTransactionServer::processMessage(CMessageBuffer &mb)
                 mb.read(xpath);
                 if (queryTransactionLogging())
                     transactionLog.log("xpath='%s'", xpath.get());
-                CHECKEDDALIREADLOCKBLOCK(manager.dataRWLock, readWriteTimeout);
+                CHECKEDDALIPACKEDLOCKBLOCK(manager.dataRWLock, readWriteTimeout);
                 mb.clear();
                 mb.append((int)DAMP_SDSREPLY_OK);
                 mb.append(manager.queryCount(xpath));
@@ -5853,6 +6732,11 @@ CCovenSDSManager::CCovenSDSManager(ICoven &_coven, IPropertyTree &_config, const
     doTimeComparison = false;
     if (config.getPropBool("@lightweightCoalesce", true))
         coalesce.setown(new CLightCoalesceThread(config, iStoreHelper));
+    if (config.getPropBool("@experimentalBinarySnapshot"))
+    {
+        IWARNLOG("@experimentalBinarySnapshot is enabled - EXPERIMENTAL: a binary snapshot is written in addition to the XML store on every save");
+        snapshot.setown(new CServerStoreSnapshot(dataPath, config.getPropInt("@experimentalBinarySnapshotThreads", DEFAULT_SNAPSHOT_THREADS)));
+    }
 }
 
 #ifdef _MSC_VER
@@ -6025,7 +6909,9 @@ void CCovenSDSManager::loadStore(const char *storeName, const bool *abort)
         iStoreHelper->getCurrentStoreFilename(storeFilename, &crc);
 
         LOG(MCdebugInfo, unknownJob, "loading store %d, storedCrc=%x", iStoreHelper->queryCurrentEdition(), crc);
-        root = (CServerRemoteTree *)::loadStore(storeFilename.str(), &treeMaker, crc, false, abort);
+        root = snapshot ? snapshot->load(iStoreHelper->queryCurrentEdition(), crc, treeMaker.convertQueue) : nullptr;
+        if (!root)
+            root = (CServerRemoteTree *)::loadStore(storeFilename.str(), &treeMaker, crc, false, abort);
         if (!root)
         {
             StringBuffer s(storeName);
@@ -6395,6 +7281,10 @@ void CCovenSDSManager::loadStore(const char *storeName, const bool *abort)
     conn.clear();
     bool forceGroupUpdate = config.getPropBool("DFS/@forceGroupUpdate");
     initClusterAndStoragePlaneGroups(forceGroupUpdate, oldEnvironment);
+
+    const char *compactSubtrees = config.queryProp("@compactSubtrees");
+    if (!isEmptyString(compactSubtrees))
+        packServerSubtrees(*root, compactSubtrees);
 }
 
 void CCovenSDSManager::saveStore(const char *storeName, bool currentEdition)
@@ -6404,7 +7294,15 @@ void CCovenSDSManager::saveStore(const char *storeName, bool currentEdition)
         CIgnore() { SDSManager->ignoreExternals=true; }
         ~CIgnore() { SDSManager->ignoreExternals=false; }
     } ignore;
+    BoolSetBlock transientBlock(transientPackedAccess); // write packed subtrees without expanding them
     iStoreHelper->saveStore(root, NULL, currentEdition);
+    if (snapshot) // experimental, costs a second write of the store on top of the XML above
+    {
+        StringBuffer storeFilename;
+        unsigned crc = 0;
+        iStoreHelper->getCurrentStoreFilename(storeFilename, &crc);
+        snapshot->save(*root, iStoreHelper->queryCurrentEdition(), crc);
+    }
     unsigned initNodeTableSize = allNodes.maxElements()+OVERFLOWSIZE;
     queryCoven().setInitSDSNodes(initNodeTableSize>INIT_NODETABLE_SIZE?initNodeTableSize:INIT_NODETABLE_SIZE);
 }
@@ -6493,6 +7391,8 @@ void CCovenSDSManager::saveDelta(const char *path, IPropertyTree &changeTree)
             return;
         }
     }
+    if (snapshot)
+        snapshot->noteChange(path, changeTree);
     cleanChangeTree(changeTree);
     // write out with header details (e.g. path)
     Owned<IPropertyTree> header = createPTree("Header");
@@ -6688,7 +7588,8 @@ StringBuffer &getMConnectString(IMultipleConnector *mConnect, StringBuffer &s)
 IRemoteConnections *CCovenSDSManager::connect(IMultipleConnector *mConnect, SessionId id, unsigned timeout)
 {
     Owned<CLCLockBlock> lockBlock;
-    lockBlock.setown(new CLCLockBlock(dataRWLock, true, readWriteTimeout, __FILE__, __LINE__));
+    if (0 == numPackedSubtrees) // else each connect takes the write lock itself
+        lockBlock.setown(new CLCLockBlock(dataRWLock, true, readWriteTimeout, __FILE__, __LINE__));
 
     Owned<CRemoteConnections> remoteConnections = new CRemoteConnections;
     unsigned c;
@@ -6711,7 +7612,7 @@ IRemoteConnection *CCovenSDSManager::connect(const char *xpath, SessionId id, un
     if (!RTM_MODE(mode, RTM_INTERNAL))
     {
         connectCritBlock.setown(new LinkingCriticalBlock(connectCrit, __FILE__, __LINE__));
-        if (RTM_CREATE == (mode & RTM_CREATE_MASK) || RTM_CREATE_QUERY == (mode & RTM_CREATE_MASK))
+        if (RTM_CREATE == (mode & RTM_CREATE_MASK) || RTM_CREATE_QUERY == (mode & RTM_CREATE_MASK) || numPackedSubtrees)
             lockBlock.setown(new CLCLockBlock(dataRWLock, false, readWriteTimeout, __FILE__, __LINE__));
         else
             lockBlock.setown(new CLCLockBlock(dataRWLock, true, readWriteTimeout, __FILE__, __LINE__));
@@ -6786,14 +7687,17 @@ bool CCovenSDSManager::removeNotifyHandler(const char *handlerKey)
 IPropertyTree *CCovenSDSManager::lockStoreRead() const
 {
     PROGLOG("lockStoreRead() called");
-    CHECKEDREADLOCKENTER(dataRWLock, readWriteTimeout);
+    if (numPackedSubtrees) // accessing a packed subtree expands it
+        CHECKEDWRITELOCKENTER(dataRWLock, readWriteTimeout);
+    else
+        CHECKEDREADLOCKENTER(dataRWLock, readWriteTimeout);
     return root;
 }
 
 void CCovenSDSManager::unlockStoreRead() const
 {
     PROGLOG("unlockStoreRead() called");
-    dataRWLock.unlockRead();
+    dataRWLock.unlock();
 }
 
 bool CCovenSDSManager::setSDSDebug(StringArray &params, StringBuffer &reply)
@@ -6834,6 +7738,29 @@ bool CCovenSDSManager::setSDSDebug(StringArray &params, StringBuffer &reply)
 
         PROGLOG("datalock, readWriteTimeout timing set to %s", readWriteStackTracing?"on":"off");
     }
+    else if (0 == stricmp("packSubtrees", params.item(0)))
+    {
+        if (params.ordinality()<2)
+        {
+            reply.append("packSubtrees <xpath>[,<xpath>...] expected");
+            return false;
+        }
+        CHECKEDDALIWRITELOCKBLOCK(dataRWLock, readWriteTimeout);
+        std::unordered_set<const IPropertyTree *> connected;
+        {
+            CHECKEDCRITICALBLOCK(cTableCrit, fakeCritTimeout);
+            SuperHashIteratorOf<CServerConnection> iter(connections.queryBaseTable());
+            ForEach(iter)
+            {
+                IPropertyTree *connRoot = iter.query().queryRootUnvalidated();
+                if (connRoot)
+                    noteConnectedSubtree(*connRoot, connected);
+            }
+        }
+        unsigned packed = packServerSubtrees(*root, params.item(1), &connected);
+        reply.append("packed ").append(packed).append(" subtrees");
+        PROGLOG("packSubtrees '%s', packed %u subtrees", params.item(1), packed);
+    }
     else if (0 == stricmp("fakecritTiming", params.item(0)))
     {
         if (params.ordinality()<2)
@@ -7129,7 +8056,7 @@ void CCovenSDSManager::getExternalValueFromServerId(__int64 serverId, MemoryBuff
 IPropertyTreeIterator *CCovenSDSManager::getElementsRaw(const char *xpath,INode *remotedali, unsigned timeout)
 {
     assertex(!remotedali); // only client side 
-    CHECKEDDALIREADLOCKBLOCK(dataRWLock, readWriteTimeout);
+    CHECKEDDALIPACKEDLOCKBLOCK(dataRWLock, readWriteTimeout);
     return root->getElements(xpath);
 }
 
@@ -7805,6 +8732,9 @@ void CCovenSDSManager::createConnection(SessionId sessionId, unsigned mode, unsi
         connectionId = 0;
         throw MakeSDSException(SDSExcpt_AbortDuringConnection, " during connect");
     }
+    // Requests made through the connection only take a read lock, so expand any packed subtrees beneath it now
+    if (numPackedSubtrees && dataRWLock.queryWriteLocked())
+        ((CServerRemoteTree *)_tree)->expandPackedSubtrees();
     connection->setEstablished();
 
     tree = (CServerRemoteTree *) LINK(_tree);
@@ -9149,3 +10079,268 @@ MODULE_EXIT()
 }
 
 #endif
+
+#ifdef _USE_CPPUNIT
+
+// Packed subtrees are expanded into registered nodes, which needs a running SDS server, so only the packed format is tested here
+// (testSDSPackedSubtree in dalitests.cpp tests connecting to and changing a packed subtree)
+class DaliPackedTreeTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(DaliPackedTreeTest);
+        CPPUNIT_TEST(testPackRoundTrip);
+        CPPUNIT_TEST(testPackEmpty);
+        CPPUNIT_TEST(testTransientSerialize);
+    CPPUNIT_TEST_SUITE_END();
+
+    IPropertyTree *createTestTree()
+    {
+        Owned<IPropertyTree> tree = createPTreeFromXMLString(
+            "<Files>"
+             "<Scope name='a'><File name='f1' size='10'><Part num='1'/><Part num='2'/></File></Scope>"
+             "<Scope name='b'><SuperFile name='s1'>text</SuperFile></Scope>"
+             "<Empty/>"
+            "</Files>");
+        byte bin[64];
+        for (unsigned i=0; i<sizeof(bin); i++)
+            bin[i] = (byte)i;
+        tree->queryPropTree("Scope[@name='b']")->setPropBin("Bin", sizeof(bin), bin);
+        return tree.getClear();
+    }
+    // Reads the format written by serializeTransientRT, checking that no node claims to be registered
+    IPropertyTree *deserializeTransientRT(MemoryBuffer &src)
+    {
+        Owned<IPropertyTree> tree = createPTree();
+        static_cast<PTree *>(tree.get())->deserializeSelf(src);
+        __int64 serverId;
+        byte STIInfo;
+        src.read(serverId).read(STIInfo);
+        CPPUNIT_ASSERT_EQUAL((__int64)0, serverId);
+        StringAttr eName;
+        for (;;)
+        {
+            size32_t pos = src.getPos();
+            src.read(eName);
+            if (eName.isEmpty())
+                break;
+            src.reset(pos);
+            tree->addPropTree(eName, deserializeTransientRT(src));
+        }
+        CPPUNIT_ASSERT_EQUAL(0 != (STIInfo & STI_HaveChildren), tree->hasChildren());
+        return tree.getClear();
+    }
+    void unpack(MemoryBuffer &packed, MemoryBuffer &unpacked)
+    {
+        fastLZDecompressToBuffer(unpacked, packed.toByteArray());
+    }
+public:
+    void testPackRoundTrip()
+    {
+        Owned<IPropertyTree> tree = createTestTree();
+        MemoryBuffer packed, unpacked;
+        size32_t unpackedSize = packTreeChildren(*tree, packed);
+        unpack(packed, unpacked);
+        CPPUNIT_ASSERT_EQUAL(unpackedSize, unpacked.length());
+        Owned<IPropertyTree> copy = createTransientChildren(tree->queryName(), unpacked);
+        CPPUNIT_ASSERT_EQUAL(unpacked.length(), unpacked.getPos());
+        CPPUNIT_ASSERT(areMatchingPTrees(tree, copy));
+        // multi-valued children keep their order
+        CPPUNIT_ASSERT(streq("a", copy->queryProp("Scope[1]/@name")));
+        CPPUNIT_ASSERT(streq("b", copy->queryProp("Scope[2]/@name")));
+    }
+    void testPackEmpty()
+    {
+        Owned<IPropertyTree> tree = createPTree("Empty");
+        MemoryBuffer packed, unpacked;
+        packTreeChildren(*tree, packed);
+        unpack(packed, unpacked);
+        Owned<IPropertyTree> copy = createTransientChildren(tree->queryName(), unpacked);
+        CPPUNIT_ASSERT(!copy->hasChildren());
+        CPPUNIT_ASSERT(areMatchingPTrees(tree, copy));
+    }
+    void testTransientSerialize()
+    {
+        Owned<IPropertyTree> tree = createTestTree();
+        MemoryBuffer mb;
+        serializeTransientRT(*tree, mb);
+        Owned<IPropertyTree> copy = deserializeTransientRT(mb);
+        CPPUNIT_ASSERT_EQUAL(mb.length(), mb.getPos());
+        CPPUNIT_ASSERT(areMatchingPTrees(tree, copy));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DaliPackedTreeTest);
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(DaliPackedTreeTest, "DaliPackedTreeTest");
+
+class DaliSnapshotTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(DaliSnapshotTest);
+        CPPUNIT_TEST(testSaveLoad);
+        CPPUNIT_TEST(testIncrementalSave);
+        CPPUNIT_TEST(testCorruptChunk);
+    CPPUNIT_TEST_SUITE_END();
+
+    StringBuffer dataPath;
+
+    IPropertyTree *createStore()
+    {
+        Owned<IPropertyTree> root = createPTree("SDS");
+        root->setProp("@version", "2");
+        IPropertyTree *wus = root->addPropTree("WorkUnits");
+        wus->setProp("@note", "original");
+        for (unsigned i=1; i<=40; i++)
+        {
+            VStringBuffer wuid("W%u", i);
+            IPropertyTree *wu = wus->addPropTree(wuid);
+            wu->setProp("@state", "completed");
+            wu->setPropInt("Statistics/@count", i);
+        }
+        IPropertyTree *files = root->addPropTree("Files");
+        for (unsigned i=0; i<5; i++)
+            files->addPropTree("Scope")->setPropInt("@name", i);
+        root->addPropTree("Queues")->setProp("@n", "1");
+        root->addPropTree("Queues")->setProp("@n", "2");
+        return root.getClear();
+    }
+    // Splits branches with at least 10 children into 8 buckets, so that WorkUnits is split, but not Files
+    CStoreSnapshot *createSnapshot()
+    {
+        return new CStoreSnapshot(dataPath, 4, 8, 10);
+    }
+    IPropertyTree *readManifest()
+    {
+        VStringBuffer filename("%s" SNAPSHOTNAME ".xml", dataPath.str());
+        return createPTreeFromXMLFile(filename);
+    }
+    IPropertyTree *loadSnapshot(unsigned edition, unsigned storeCrc)
+    {
+        Owned<CStoreSnapshot> snapshot = createSnapshot(); // as a restarted server would
+        ICopyArrayOf<IPropertyTree> externalCandidates;
+        return snapshot->load(edition, storeCrc, externalCandidates);
+    }
+    void clearDataPath()
+    {
+        Owned<IDirectoryIterator> di = createDirectoryIterator(dataPath, "*");
+        ForEach(*di)
+            di->query().remove();
+    }
+public:
+    virtual void setUp() override
+    {
+        dataPath.clear().append("dasds_snapshot_test").append(PATHSEPCHAR);
+        recursiveCreateDirectory(dataPath);
+        clearDataPath();
+    }
+    virtual void tearDown() override
+    {
+        clearDataPath();
+        OwnedIFile dir = createIFile(dataPath);
+        dir->remove();
+    }
+    void testSaveLoad()
+    {
+        Owned<IPropertyTree> store = createStore();
+        Owned<CStoreSnapshot> snapshot = createSnapshot();
+        snapshot->save(*store, 1, 0x1234);
+
+        Owned<IPropertyTree> manifest = readManifest();
+        CPPUNIT_ASSERT_EQUAL(8U, manifest->getCount("Branch[@name=\"WorkUnits\"]/Bucket"));
+        CPPUNIT_ASSERT(!manifest->hasProp("Branch[@name=\"Files\"]/@buckets"));
+        CPPUNIT_ASSERT_EQUAL(2, manifest->getPropInt("Branch[@name=\"Queues\"]/@count"));
+
+        Owned<IPropertyTree> loaded = loadSnapshot(1, 0x1234);
+        CPPUNIT_ASSERT(loaded);
+        CPPUNIT_ASSERT(areMatchingPTrees(store, loaded));
+
+        // a snapshot of a different store is ignored
+        Owned<IPropertyTree> other = loadSnapshot(2, 0x1234);
+        CPPUNIT_ASSERT(!other);
+        other.setown(loadSnapshot(1, 0x4321));
+        CPPUNIT_ASSERT(!other);
+    }
+    void testIncrementalSave()
+    {
+        Owned<IPropertyTree> store = createStore();
+        Owned<CStoreSnapshot> snapshot = createSnapshot();
+        snapshot->save(*store, 1, 1);
+        Owned<IPropertyTree> before = readManifest();
+
+        // a change via a connection to a workunit, and one to the WorkUnits node itself
+        store->setProp("WorkUnits/W7/@state", "archived");
+        Owned<IPropertyTree> change = createPTreeFromXMLString("<T><AC state='archived'/></T>");
+        snapshot->noteChange("/WorkUnits/W7", *change);
+        store->setProp("WorkUnits/@note", "changed");
+        change.setown(createPTreeFromXMLString("<T><AC note='changed'/></T>"));
+        snapshot->noteChange("/WorkUnits", *change);
+        snapshot->save(*store, 2, 2);
+        Owned<IPropertyTree> after = readManifest();
+
+        // only the WorkUnits node and the bucket holding W7 are rewritten
+        IPropertyTree *wusBefore = before->queryPropTree("Branch[@name=\"WorkUnits\"]");
+        IPropertyTree *wusAfter = after->queryPropTree("Branch[@name=\"WorkUnits\"]");
+        CPPUNIT_ASSERT(!streq(wusBefore->queryProp("@file"), wusAfter->queryProp("@file")));
+        unsigned changedBuckets = 0;
+        for (unsigned b=1; b<=8; b++)
+        {
+            VStringBuffer xpath("Bucket[%u]/@file", b);
+            if (!streq(wusBefore->queryProp(xpath), wusAfter->queryProp(xpath)))
+                changedBuckets++;
+        }
+        CPPUNIT_ASSERT_EQUAL(1U, changedBuckets);
+        CPPUNIT_ASSERT(streq(before->queryProp("Branch[@name=\"Files\"]/@file"), after->queryProp("Branch[@name=\"Files\"]/@file")));
+        Owned<IPropertyTree> loaded = loadSnapshot(2, 2);
+        CPPUNIT_ASSERT(loaded);
+        CPPUNIT_ASSERT(areMatchingPTrees(store, loaded));
+
+        // a change via a connection to the root rewrites the (unsplit) branch it names
+        store->setProp("Files/Scope[1]/@x", "1");
+        change.setown(createPTreeFromXMLString("<T><T name='Files' pos='1'><T name='Scope' pos='1'><AC x='1'/></T></T></T>"));
+        snapshot->noteChange("/", *change);
+        snapshot->save(*store, 3, 3);
+        before.setown(after.getClear());
+        after.setown(readManifest());
+        CPPUNIT_ASSERT(!streq(before->queryProp("Branch[@name=\"Files\"]/@file"), after->queryProp("Branch[@name=\"Files\"]/@file")));
+        CPPUNIT_ASSERT(streq(before->queryProp("Branch[@name=\"WorkUnits\"]/@file"), after->queryProp("Branch[@name=\"WorkUnits\"]/@file")));
+        loaded.setown(loadSnapshot(3, 3));
+        CPPUNIT_ASSERT(loaded);
+        CPPUNIT_ASSERT(areMatchingPTrees(store, loaded));
+    }
+    void testCorruptChunk()
+    {
+        Owned<IPropertyTree> store = createStore();
+        Owned<CStoreSnapshot> snapshot = createSnapshot();
+        snapshot->save(*store, 1, 1);
+        Owned<IPropertyTree> manifest = readManifest();
+
+        // a missing chunk means the XML store is loaded instead (load returns null)
+        VStringBuffer chunkName("%s%s", dataPath.str(), manifest->queryProp("Branch[@name=\"Files\"]/@file"));
+        OwnedIFile chunk = createIFile(chunkName);
+        chunk->remove();
+        Owned<IPropertyTree> loaded = loadSnapshot(1, 1);
+        CPPUNIT_ASSERT(!loaded);
+
+        // a restarted server rewrites every chunk on its first save
+        snapshot.setown(createSnapshot());
+        snapshot->save(*store, 2, 2);
+        loaded.setown(loadSnapshot(2, 2));
+        CPPUNIT_ASSERT(loaded);
+        CPPUNIT_ASSERT(areMatchingPTrees(store, loaded));
+
+        // a chunk that fails its crc check also means the XML store is loaded
+        manifest.setown(readManifest());
+        chunkName.clear().append(dataPath).append(manifest->queryProp("Branch[@name=\"WorkUnits\"]/Bucket[1]/@file"));
+        chunk.setown(createIFile(chunkName));
+        OwnedIFileIO io = chunk->open(IFOreadwrite);
+        byte b;
+        CPPUNIT_ASSERT_EQUAL((size32_t)1, io->read(0, 1, &b));
+        b ^= 0xff;
+        io->write(0, 1, &b);
+        io->close();
+        loaded.setown(loadSnapshot(2, 2));
+        CPPUNIT_ASSERT(!loaded);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DaliSnapshotTest);
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(DaliSnapshotTest, "DaliSnapshotTest");
+
+#endif // _USE_CPPUNIT
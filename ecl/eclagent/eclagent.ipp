@@ -767,6 +767,7 @@ public:
     void createFromXGMML(ILoadedDllEntry * dll, IPropertyTree * xgmml);
     void executeDependentActions(IAgentContext & agent, const byte * parentExtract, int controlId);
     void extractResult(size32_t & retSize, void * & ret);
+    void gatherDependencies(CICopyArrayOf<EclSubGraph> & dependencies);
 
     bool prepare(IAgentContext & agent, const byte * parentExtract, bool checkDependencies);
     IHThorInput * queryOutput(unsigned idx);
@@ -956,6 +957,7 @@ public:
     void updateProgress();
     void doExecuteChild(const byte * parentExtract);
     IEclLoopGraph * resolveLoopGraph(unsigned id);
+    void gatherDependencies(CICopyArrayOf<EclSubGraph> & dependencies);
 
 //interface IEclGraphResults
     virtual IHThorGraphResult * queryResult(unsigned id);
@@ -1071,6 +1073,9 @@ public:
     inline bool queryLibrary() const { return isLibrary; }
     inline unsigned queryWfid() const { return wfid; }
 
+protected:
+    void executeSinksInParallel(const byte * parentExtract);
+
 protected:
     IAgentContext * agent;
     CIArrayOf<EclSubGraph> graphs;
@@ -37,10 +37,12 @@
 #include "thorfile.hpp"
 #include "commonext.hpp"
 #include "thorcommon.hpp"
+#include "jthread.hpp"
 
 #include <list>
 #include <string>
 #include <algorithm>
+#include <vector>
 
 using roxiemem::OwnedRoxieString;
 
@@ -580,6 +582,15 @@ void EclGraphElement::executeDependentActions(IAgentContext & agent, const byte
     }
 }
 
+// Gather every subgraph this activity could cause to be executed, whichever branches are taken
+void EclGraphElement::gatherDependencies(CICopyArrayOf<EclSubGraph> & dependencies)
+{
+    ForEachItemIn(i, dependentOn)
+        dependentOn.item(i).gatherDependencies(dependencies);
+    ForEachItemIn(i2, branches)
+        branches.item(i2).gatherDependencies(dependencies);
+}
+
 bool EclGraphElement::prepare(IAgentContext & agent, const byte * parentExtract, bool checkDependencies)
 {
     alreadyUpdated = false;
@@ -1145,6 +1156,17 @@ EclGraphElement * EclSubGraph::idToActivity(unsigned id)
     return NULL;
 }
 
+void EclSubGraph::gatherDependencies(CICopyArrayOf<EclSubGraph> & dependencies)
+{
+    if (dependencies.contains(*this))
+        return;
+    dependencies.append(*this);
+    ForEachItemIn(i, elements)
+        elements.item(i).gatherDependencies(dependencies);
+    ForEachItemIn(i2, subgraphs)
+        subgraphs.item(i2).gatherDependencies(dependencies);
+}
+
 void EclSubGraph::reset()
 {
     executed = false;
@@ -1254,11 +1276,16 @@ void EclGraph::execute(const byte * parentExtract)
     try
     {
         unsigned startTime = msTick();
-        ForEachItemIn(idx, graphs)
+        if (!debugContext && !probeManager && wu->getDebugValueBool("parallelSubgraphs", false))
+            executeSinksInParallel(parentExtract);
+        else
         {
-            EclSubGraph & cur = graphs.item(idx);
-            if (cur.isSink)
-                cur.execute(parentExtract);
+            ForEachItemIn(idx, graphs)
+            {
+                EclSubGraph & cur = graphs.item(idx);
+                if (cur.isSink)
+                    cur.execute(parentExtract);
+            }
         }
 
         {
@@ -1294,6 +1321,142 @@ void EclGraph::execute(const byte * parentExtract)
     }
 }
 
+// A sink subgraph, together with every subgraph it could execute whichever conditional branches are taken
+class EclSinkDependencies : public CInterface
+{
+public:
+    EclSinkDependencies(EclSubGraph & _sink) : sink(_sink)
+    {
+        sink.gatherDependencies(dependencies);
+        ForEachItemIn(i, dependencies)
+        {
+            EclSubGraph & cur = dependencies.item(i);
+            if (cur.isChildGraph || cur.subgraphs.ordinality())
+                callsSharedGraphs = true;
+            ForEachItemIn(i2, cur.elements)
+            {
+                if (cur.elements.item(i2).kind == TAKlibrarycall)
+                    callsSharedGraphs = true;
+            }
+        }
+    }
+
+    bool sharesDependencies(const EclSinkDependencies & other) const
+    {
+        //Libraries are loaded and executed via the agent (EclAgent::loadEclLibrary updates queryLibraries unlocked, and
+        //a library graph has a single instance), and child queries are evaluated via graph level state, so any sinks
+        //that can call either are treated as sharing a dependency.
+        if (callsSharedGraphs && other.callsSharedGraphs)
+            return true;
+        ForEachItemIn(i, dependencies)
+        {
+            if (other.dependencies.contains(dependencies.item(i)))
+                return true;
+        }
+        return false;
+    }
+
+    EclSubGraph & sink;
+    unsigned group = 0;
+
+protected:
+    CICopyArrayOf<EclSubGraph> dependencies;
+    bool callsSharedGraphs = false;
+};
+
+// Sinks are normally executed in the order they appear, each executing the subgraphs it depends on as it goes.
+// Sinks that could execute a common subgraph (directly, or via another sink) form a group and keep that order.
+// Groups have no subgraphs in common, so each is executed on its own thread - subgraphs can run for a long time, so
+// they are not run on the shared task scheduler, where they would hold up its workers.
+void EclGraph::executeSinksInParallel(const byte * parentExtract)
+{
+    CIArrayOf<EclSinkDependencies> sinks;
+    ForEachItemIn(idx, graphs)
+    {
+        EclSubGraph & cur = graphs.item(idx);
+        if (!cur.isSink)
+            continue;
+
+        EclSinkDependencies * sink = new EclSinkDependencies(cur);
+        sink->group = sinks.ordinality();
+        ForEachItemIn(prev, sinks)
+        {
+            EclSinkDependencies & other = sinks.item(prev);
+            if ((other.group != sink->group) && sink->sharesDependencies(other))
+            {
+                //Merge the earlier sink's group into this one
+                unsigned oldGroup = other.group;
+                ForEachItemIn(i, sinks)
+                {
+                    if (sinks.item(i).group == oldGroup)
+                        sinks.item(i).group = sink->group;
+                }
+            }
+        }
+        sinks.append(*sink);
+    }
+
+    std::vector<std::vector<EclSubGraph *>> groups;
+    std::vector<unsigned> groupIndex(sinks.ordinality(), NotFound);
+    ForEachItemIn(i, sinks)
+    {
+        EclSinkDependencies & cur = sinks.item(i);
+        if (groupIndex[cur.group] == NotFound)
+        {
+            groupIndex[cur.group] = groups.size();
+            groups.emplace_back();
+        }
+        groups[groupIndex[cur.group]].push_back(&cur.sink);
+    }
+
+    PROGLOG("Executing %u sink subgraphs of %s as %u parallel groups", sinks.ordinality(), queryGraphName(), (unsigned)groups.size());
+
+    //The first failure aborts the subgraphs that are still running and stops any more from starting, and is rethrown
+    //once all the groups have finished.
+    CriticalSection crit;
+    Owned<IException> failure;
+    std::atomic<bool> failed{false};
+    auto noteFailure = [&](IException * e)
+    {
+        {
+            CriticalBlock block(crit);
+            if (failure)
+            {
+                e->Release();
+                return;
+            }
+            failure.setown(e);
+            failed = true;
+        }
+        abort();
+    };
+
+    unsigned numGroups = groups.size();
+    asyncFor(numGroups, numGroups, [&](unsigned i)
+    {
+        for (EclSubGraph * sink : groups[i])
+        {
+            if (failed)
+                break;
+            try
+            {
+                sink->execute(parentExtract);
+            }
+            catch (IException * e)
+            {
+                noteFailure(e);
+            }
+            catch (...)
+            {
+                noteFailure(MakeStringException(0, "Unknown exception executing subgraph %u of %s", sink->id, queryGraphName()));
+            }
+        }
+    });
+
+    if (failure)
+        throw failure.getClear();
+}
+
 void EclGraph::executeLibrary(const byte * parentExtract, IHThorGraphResults * results)
 {
     assertex(graphs.ordinality() == 1);
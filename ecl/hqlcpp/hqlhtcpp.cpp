@@ -5752,14 +5752,17 @@ static void buildCompareMemberFunction(HqlCppTranslator & translator, BuildCtx &
     translator.buildReturnOrder(func.ctx, sortList, dataset);
 }
 
-void HqlCppTranslator::buildCompareClass(BuildCtx & ctx, const char * name, IHqlExpression * sortList, const DatasetReference & dataset, StringBuffer & compareFuncName)
+void HqlCppTranslator::buildCompareClass(BuildCtx & ctx, const char * name, IHqlExpression * sortList, const DatasetReference & dataset, StringBuffer & compareFuncName, bool allowNormalizedKey)
 {
+    size32_t normalizedKeySize = 0;
+    bool normalizedKey = allowNormalizedKey && canBuildNormalizedKey(sortList, normalizedKeySize);
+    const char * compareInterface = normalizedKey ? "ICompareNormalizedKey" : "ICompare";
     if (options.useGlobalCompareClass)
     {
         BuildCtx buildctx(*code, declareAtom);
 
         // stop duplicate classes being generated.
-        OwnedHqlExpr searchKey = createAttribute(noSortAtom, LINK(sortList), LINK(dataset.queryDataset()->queryRecord()));
+        OwnedHqlExpr searchKey = createAttribute(noSortAtom, LINK(sortList), LINK(dataset.queryDataset()->queryRecord()), normalizedKey ? createConstant(true) : nullptr);
         HqlExprAssociation * match = buildctx.queryMatchExpr(searchKey);
         if (match)
         {
@@ -5772,7 +5775,7 @@ void HqlCppTranslator::buildCompareClass(BuildCtx & ctx, const char * name, IHql
         // Create global compare class
         unsigned id = getNextGlobalCompareId();
         instanceName.append("compare").append(id);
-        startText.append("struct Compare").append(id).append(" : public ICompare");
+        startText.append("struct Compare").append(id).append(" : public ").append(compareInterface);
         endText.append(" ").append(instanceName).append(";");
         classctx.addQuotedCompound(startText,endText);
 
@@ -5787,14 +5790,18 @@ void HqlCppTranslator::buildCompareClass(BuildCtx & ctx, const char * name, IHql
             compareFuncName.set(instanceName);
 
         buildCompareMemberFunction(*this, classctx, sortList, dataset);
+        if (normalizedKey)
+            buildNormalizedKeyMembers(classctx, sortList, dataset, normalizedKeySize);
         OwnedHqlExpr temp = createVariable(compareFuncName, makeVoidType());
         buildctx.associateExpr(searchKey, temp);
     }
     else
     {
         BuildCtx comparectx(ctx);
-        IHqlStmt * classStmt = beginNestedClass(comparectx, name, "ICompare");
+        IHqlStmt * classStmt = beginNestedClass(comparectx, name, compareInterface);
         buildCompareMemberFunction(*this, comparectx, sortList, dataset);
+        if (normalizedKey)
+            buildNormalizedKeyMembers(comparectx, sortList, dataset, normalizedKeySize);
         endNestedClass(classStmt);
         compareFuncName.set(name);
     }
@@ -16545,6 +16552,100 @@ void HqlCppTranslator::buildReturnOrder(BuildCtx & ctx, IHqlExpression *sortList
     doBuildReturnCompare(ctx, order, no_order, false, false);
 }
 
+//A normalized key can be generated if all the components of the sort are fixed size integers, or fixed length strings
+//that are compared with memcmp().
+bool HqlCppTranslator::canBuildNormalizedKey(IHqlExpression * sortList, size32_t & keySize)
+{
+    keySize = 0;
+    ForEachChild(i, sortList)
+    {
+        IHqlExpression * cur = sortList->queryChild(i);
+        if (cur->getOperator() == no_negate)
+            cur = cur->queryChild(0);
+
+        ITypeInfo * type = cur->queryType();
+        size32_t size = type->getSize();
+        switch (type->getTypeCode())
+        {
+        case type_int:
+        case type_swapint:
+            if ((size == 0) || (size > sizeof(__int64)))
+                return false;
+            break;
+        case type_data:
+            if (size == UNKNOWN_LENGTH)
+                return false;
+            break;
+        case type_string:
+            if ((size == UNKNOWN_LENGTH) || (type->queryCharset()->queryName() != asciiAtom))
+                return false;
+            break;
+        default:
+            return false;
+        }
+        keySize += size;
+    }
+    return keySize != 0;
+}
+
+void HqlCppTranslator::buildNormalizedKeyMembers(BuildCtx & ctx, IHqlExpression * sortList, const DatasetReference & dataset, size32_t keySize)
+{
+    StringBuffer s;
+    s.append("virtual size32_t getNormalizedKeySize() const override { return ").append(keySize).append("; }");
+    ctx.addQuoted(s);
+
+    MemberFunction func(*this, ctx, "virtual void getNormalizedKey(byte * key, const void * _left) const override", MFoptimize);
+    func.ctx.addQuotedLiteral("const unsigned char * left = (const unsigned char *) _left;");
+    func.ctx.associateExpr(constantMemberMarkerExpr, constantMemberMarkerExpr);
+
+    OwnedHqlExpr selSeq = createDummySelectorSequence();
+    OwnedHqlExpr leftSelect = dataset.getSelector(no_left, selSeq);
+    bindTableCursor(func.ctx, dataset.queryDataset(), "left", no_left, selSeq);
+
+    size32_t offset = 0;
+    ForEachChild(i, sortList)
+    {
+        IHqlExpression * cur = sortList->queryChild(i);
+        bool invert = false;
+        if (cur->getOperator() == no_negate)
+        {
+            invert = true;
+            cur = cur->queryChild(0);
+        }
+
+        ITypeInfo * type = cur->queryType();
+        size32_t size = type->getSize();
+        OwnedHqlExpr resolved = dataset.mapScalar(cur, leftSelect);
+        CHqlBoundExpr bound;
+        buildExpr(func.ctx, resolved, bound);
+
+        s.clear();
+        switch (type->getTypeCode())
+        {
+        case type_int:
+        case type_swapint:
+            s.append(type->isSigned() ? "rtlWriteNormalizedInt(key+" : "rtlWriteNormalizedUInt(key+").append(offset).append(",");
+            generateExprCpp(s, bound.expr).append(",").append(size).append(");");
+            break;
+        default:
+            {
+                OwnedHqlExpr address = getPointer(bound.expr);
+                s.append("memcpy(key+").append(offset).append(",");
+                generateExprCpp(s, address).append(",").append(size).append(");");
+                break;
+            }
+        }
+        func.ctx.addQuoted(s);
+
+        if (invert)
+        {
+            s.clear().append("rtlInvertNormalizedKey(key+").append(offset).append(",").append(size).append(");");
+            func.ctx.addQuoted(s);
+        }
+        offset += size;
+    }
+}
+
 void HqlCppTranslator::doBuildFuncIsSameGroup(BuildCtx & ctx, IHqlExpression * dataset, IHqlExpression * sortlist)
 {
     MemberFunction func(*this, ctx, "virtual bool isSameGroup(const void * _left, const void * _right) override");
@@ -17031,7 +17132,7 @@ ABoundActivity * HqlCppTranslator::doBuildActivitySort(BuildCtx & ctx, IHqlExpre
     buildInstancePrefix(instance);
 
 //  sortlist.setown(spotScalarCSE(sortlist));
-    buildCompareFuncHelper(*this, *instance, "compare", sortlist, DatasetReference(dataset));
+    buildCompareFuncHelper(*this, *instance, "compare", sortlist, DatasetReference(dataset), options.normalizedSortKey && (actKind == TAKsort));
 
     IHqlExpression * record = dataset->queryRecord();
     IAtom * serializeType = diskAtom; //MORE: Does this place a dependency on the implementation?
@@ -19994,11 +20095,11 @@ unsigned getVirtualFieldSize(IHqlExpression * record)
 // 2) create an ICompare derived class and object
 //    - within the nested class (when useGlobalCompareClass=false) or
 //    - as a global class (when useGlobalCompareClass=true)
-void buildCompareFuncHelper(HqlCppTranslator & translator, ActivityInstance & instance, const char * compareFuncName, IHqlExpression * sortList, const DatasetReference & dsRef)
+void buildCompareFuncHelper(HqlCppTranslator & translator, ActivityInstance & instance, const char * compareFuncName, IHqlExpression * sortList, const DatasetReference & dsRef, bool allowNormalizedKey)
 {
     assertex(compareFuncName[0]); // make sure func name is at least 1 char
     StringBuffer compareClassInstance;
-    translator.buildCompareClass(instance.nestedctx, compareFuncName, sortList, dsRef, compareClassInstance);
+    translator.buildCompareClass(instance.nestedctx, compareFuncName, sortList, dsRef, compareClassInstance, allowNormalizedKey);
 
     StringBuffer s;
     s.set("virtual ICompare * query").append(static_cast<char>(toupper(compareFuncName[0]))).append(compareFuncName+1).append("() override");
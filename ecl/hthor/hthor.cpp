@@ -1179,6 +1179,7 @@ void CHThorIndexWriteActivity::execute()
         buildUserMetadata(metadata);
         buildLayoutMetadata(metadata);
         unsigned nodeSize = metadata->getPropInt("_nodeSize", NODESIZE);
+        flags = applyLeafCompression(flags, metadata->queryProp("_leafCompression"));
         if (metadata->getPropBool("_noSeek", defaultNoSeek))
         {
             flags |= TRAILING_HEADER_ONLY;
@@ -5587,6 +5588,13 @@ bool CHThorSelfJoinActivity::isGrouped()
 
 //=====================================================================================================
 
+// The tag of a slot holds the top byte of the entry's hash, so most mismatches are rejected without touching the row
+static inline byte getLookupHashTag(unsigned hv)
+{
+    byte tag = (byte)(hv >> 24);
+    return tag ? tag : 1;
+}
+
 CHThorLookupJoinActivity::LookupTable::LookupTable(unsigned _size, ICompare * _leftRightCompare, ICompare * _rightCompare, IHash * _leftHash, IHash * _rightHash, bool _dedupOnAdd)
     : leftRightCompare(_leftRightCompare), rightCompare(_rightCompare), leftHash(_leftHash), rightHash(_rightHash), dedupOnAdd(_dedupOnAdd)
 {
@@ -5596,23 +5604,29 @@ CHThorLookupJoinActivity::LookupTable::LookupTable(unsigned _size, ICompare * _l
         size <<= 1;
     mask = size - 1;
     table = new OwnedConstRoxieRow[size];
+    tags = new byte[size];
+    memset(tags, 0, size);
     findex = BadIndex;
+    ftag = 0;
 }
 
 CHThorLookupJoinActivity::LookupTable::~LookupTable()
 {
     delete [] table;
+    delete [] tags;
 }
 
 bool CHThorLookupJoinActivity::LookupTable::add(const void * _right)
 {
     OwnedConstRoxieRow right(_right);
     findex = BadIndex;
-    unsigned start = rightHash->hash(right) & mask;
+    unsigned hv = rightHash->hash(right);
+    byte tag = getLookupHashTag(hv);
+    unsigned start = hv & mask;
     unsigned index = start;
-    while(table[index])
+    while(tags[index])
     {
-        if(dedupOnAdd && (rightCompare->docompare(table[index], right) == 0))
+        if(dedupOnAdd && (tags[index] == tag) && (rightCompare->docompare(table[index], right) == 0))
             return false;
         index++;
         if(index==size)
@@ -5621,12 +5635,15 @@ bool CHThorLookupJoinActivity::LookupTable::add(const void * _right)
             return false; //table is full, should never happen
     }
     table[index].setown(right.getClear());
+    tags[index] = tag;
     return true;
 }
 
 const void * CHThorLookupJoinActivity::LookupTable::find(const void * left) const
 {
-    fstart = leftHash->hash(left) & mask;
+    unsigned hv = leftHash->hash(left);
+    ftag = getLookupHashTag(hv);
+    fstart = hv & mask;
     findex = fstart;
     return doFind(left);
 }
@@ -5650,9 +5667,9 @@ void CHThorLookupJoinActivity::LookupTable::advance() const
 
 const void * CHThorLookupJoinActivity::LookupTable::doFind(const void * left) const
 {
-    while(table[findex])
+    while(tags[findex])
     {
-        if(leftRightCompare->docompare(left, table[findex]) == 0)
+        if((tags[findex] == ftag) && (leftRightCompare->docompare(left, table[findex]) == 0))
             return table[findex];
         advance();
     }
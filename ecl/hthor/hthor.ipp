@@ -1474,8 +1474,10 @@ private:
         unsigned size;
         unsigned mask;
         OwnedConstRoxieRow * table;
+        byte * tags; // per-slot hash fingerprint, 0 marks an empty slot
         unsigned mutable fstart;
         unsigned mutable findex;
+        byte mutable ftag;
         static unsigned const BadIndex;
     };
 
@@ -22,6 +22,8 @@
 //Jlib
 #include "jliball.hpp"
 
+#include <vector>
+
 //SCM Interface definition includes:
 #include "esp.hpp"
 #include "espthread.hpp"
@@ -41,6 +43,187 @@
 IThreadPool* http_thread_pool;
 CHttpThreadPoolFactory* http_pool_factory;
 
+/**************************************************************************
+ *  CHttpRequestCollector                                                 *
+ *                                                                        *
+ *  Gathers incoming requests for the http thread pool.  Sockets are      *
+ *  watched by a select handler (epoll where available) and data is       *
+ *  read as it arrives, so a pooled thread is only used once a request    *
+ *  can be processed without waiting on the client.                       *
+ **************************************************************************/
+class CHttpRequestCollector : public Thread, implements ISocketSelectNotify
+{
+    class CPendingRequest : public CInterface
+    {
+    public:
+        CPendingRequest(ISocket *_sock, CHttpProtocol *_protocol, CEspApplicationPort *_apport, IPersistentHandler *_persistentHandler, bool _shouldClose)
+            : sock(_sock), protocol(_protocol), apport(_apport), persistentHandler(_persistentHandler), shouldClose(_shouldClose), startTime(msTick())
+        {
+        }
+
+        Linked<ISocket> sock;
+        CHttpProtocol *protocol;
+        CEspApplicationPort *apport;
+        IPersistentHandler *persistentHandler;
+        bool shouldClose;
+        unsigned startTime;
+        CHttpRequestScanner scanner;
+    };
+
+    Owned<ISocketSelectHandler> m_selectHandler;
+    std::map<ISocket *, Linked<CPendingRequest>> m_pending;
+    CriticalSection m_crit;
+    Semaphore m_waitsem;
+    std::atomic<bool> m_stopping{false};
+
+public:
+    IMPLEMENT_IINTERFACE_USING(Thread);
+
+    CHttpRequestCollector() : Thread("CHttpRequestCollector")
+    {
+        m_selectHandler.setown(createSocketSelectHandler());
+    }
+
+    virtual void start() override
+    {
+        m_selectHandler->start();
+        Thread::start();
+    }
+
+    void stop()
+    {
+        m_stopping = true;
+        m_waitsem.signal();
+        join();
+        m_selectHandler->stop(true);
+        CriticalBlock block(m_crit);
+        for (auto &entry : m_pending)
+            abandon(entry.second);
+        m_pending.clear();
+    }
+
+    void add(ISocket *sock, CHttpProtocol *protocol, CEspApplicationPort *apport, IPersistentHandler *persistentHandler, bool shouldClose)
+    {
+        Owned<CPendingRequest> pending = new CPendingRequest(sock, protocol, apport, persistentHandler, shouldClose);
+        CriticalBlock block(m_crit);
+        m_pending[sock].set(pending);
+        m_selectHandler->add(sock, SELECTMODE_READ, this);
+    }
+
+    //ISocketSelectNotify
+    virtual bool notifySelected(ISocket *sock, unsigned selected) override
+    {
+        Linked<CPendingRequest> pending;
+        {
+            CriticalBlock block(m_crit);
+            auto match = m_pending.find(sock);
+            if (match == m_pending.end())
+                return false;
+            pending.set(match->second);
+        }
+
+        bool ready = false;
+        bool closed = false;
+        try
+        {
+            size32_t avail = sock->avail_read();
+            if (avail == 0)
+                closed = true;  // closed by the other end
+            else
+            {
+                MemoryAttr buf(avail);
+                size32_t lenread = 0;
+                sock->read(buf.bufferBase(), 1, avail, lenread);
+                ready = pending->scanner.append(buf.get(), lenread);
+            }
+        }
+        catch (IException *e)
+        {
+            StringBuffer estr;
+            ESPLOG(LogMax, "Exception(%d, %s) reading request from socket %d", e->errorCode(), e->errorMessage(estr).str(), sock->OShandle());
+            e->Release();
+            closed = true;
+        }
+
+        if (closed || ready)
+        {
+            //The expiry pass (or stop) may have claimed the request while it was being read, in which case it has
+            //already been abandoned and the socket closed - only the caller that removes the entry may act on it.
+            {
+                CriticalBlock block(m_crit);
+                auto match = m_pending.find(sock);
+                if (match == m_pending.end() || match->second != pending)
+                    return false;
+                m_pending.erase(match);
+                m_selectHandler->remove(sock);
+            }
+            if (closed)
+                abandon(pending);
+            else
+            {
+                try
+                {
+                    pending->protocol->startPooledThread(sock, pending->apport, pending->persistentHandler, pending->shouldClose, &pending->scanner.queryData());
+                }
+                catch (IException *e)
+                {
+                    StringBuffer estr;
+                    IERRLOG("Exception(%d, %s) in CHttpRequestCollector::notifySelected()", e->errorCode(), e->errorMessage(estr).str());
+                    e->Release();
+                }
+                catch(...)
+                {
+                    IERRLOG("Unknown Exception in CHttpRequestCollector::notifySelected()");
+                }
+            }
+        }
+        return false;
+    }
+
+    //Thread - closes connections that have not delivered a complete request in time
+    virtual int run() override
+    {
+        while (!m_stopping)
+        {
+            m_waitsem.wait(1000);
+            if (m_stopping)
+                break;
+            unsigned now = msTick();
+            std::vector<Linked<CPendingRequest>> expired;
+            {
+                CriticalBlock block(m_crit);
+                for (auto iter = m_pending.begin(); iter != m_pending.end();)
+                {
+                    if (now - iter->second->startTime > BSOCKET_READ_TIMEOUT * 1000)
+                    {
+                        m_selectHandler->remove(iter->first);
+                        expired.push_back(iter->second);
+                        iter = m_pending.erase(iter);
+                    }
+                    else
+                        ++iter;
+                }
+            }
+            for (auto &pending : expired)
+            {
+                ESPLOG(LogNormal, "Request on socket %d not received within %d seconds, closing connection", pending->sock->OShandle(), BSOCKET_READ_TIMEOUT);
+                abandon(pending);
+            }
+        }
+        return 0;
+    }
+
+private:
+    static void abandon(CPendingRequest *pending)
+    {
+        if (pending->persistentHandler)
+            pending->persistentHandler->doneUsing(pending->sock, false);
+        shutdownAndCloseNoThrow(pending->sock);
+    }
+};
+
+static CHttpRequestCollector* http_request_collector;
+
 /**************************************************************************
  *  CHttpProtocol Implementation                                          *
  **************************************************************************/
@@ -51,6 +234,13 @@ CHttpProtocol::CHttpProtocol()
 
 CHttpProtocol::~CHttpProtocol()
 {
+    if(http_request_collector)
+    {
+        http_request_collector->stop();
+        http_request_collector->Release();
+        http_request_collector = NULL;
+    }
+
     if(http_thread_pool)
     {
         http_thread_pool->Release();
@@ -90,6 +280,12 @@ void CHttpProtocol::init(IPropertyTree * cfg, const char * process, const char *
                 http_pool_factory = new CHttpThreadPoolFactory();
             if(!http_thread_pool)
                 http_thread_pool = createThreadPool("Http Thread", http_pool_factory, NULL, m_maxConcurrentThreads, INFINITE);
+            // Read requests asynchronously, so idle or slow clients do not tie up pooled threads
+            if(!http_request_collector && proc_cfg->getPropBool("@asyncRequestRead", false))
+            {
+                http_request_collector = new CHttpRequestCollector();
+                http_request_collector->start();
+            }
         }
     }
 
@@ -106,6 +302,40 @@ void CHttpProtocol::init(IPropertyTree * cfg, const char * process, const char *
     }
 }
 
+void CHttpProtocol::startPooledThread(ISocket *accepted, CEspApplicationPort *apport, IPersistentHandler* persistentHandler, bool shouldClose, MemoryBuffer *prefetched)
+{
+    // Using Threading pool instead of generating one thread per request.
+    void ** holder = new void*[8];
+    holder[0] = (void*)(LINK(accepted));
+    holder[1] = (void*)apport;
+    int maxEntityLength = getMaxRequestEntityLength();
+    holder[2] = (void*)&maxEntityLength;
+    bool useSSL = false;
+    holder[3] = (void*)&useSSL;
+    ISecureSocketContext* ctx = NULL;
+    holder[4] = (void*)ctx;
+    holder[5] = (void*)persistentHandler;
+    holder[6] = (void*)&shouldClose;
+    holder[7] = (void*)prefetched;
+    try
+    {
+        http_thread_pool->start((void*)holder, "", m_threadCreateTimeout > 0?m_threadCreateTimeout*1000:0);
+    }
+    catch(...)
+    {
+        IERRLOG("Error starting thread from http thread pool.");
+        accepted->close();
+        //Assumption here is that if start() throws exception, that means the new
+        //thread hasn't been started, so there's no other thread holding a link.
+        CInterface* ci = dynamic_cast<CInterface*>(accepted);
+        if(ci && ci->IsShared())
+            accepted->Release();
+        delete [] holder;
+        throw;
+    }
+    delete [] holder;
+}
+
 bool CHttpProtocol::notifySelected(ISocket *sock,unsigned selected, IPersistentHandler* persistentHandler, bool shouldClose)
 {
     try
@@ -136,38 +366,10 @@ bool CHttpProtocol::notifySelected(ISocket *sock,unsigned selected, IPersistentH
 
                 if(m_maxConcurrentThreads > 0)
                 {
-                    // Using Threading pool instead of generating one thread per request.
-                    void ** holder = new void*[7];
-                    holder[0] = (void*)(accepted.getLink());
-                    holder[1] = (void*)apport;
-                    int maxEntityLength = getMaxRequestEntityLength();
-                    holder[2] = (void*)&maxEntityLength;
-                    bool useSSL = false;
-                    holder[3] = (void*)&useSSL;
-                    ISecureSocketContext* ctx = NULL;
-                    holder[4] = (void*)ctx;
-                    holder[5] = (void*)persistentHandler;
-                    holder[6] = (void*)&shouldClose;
-                    try
-                    {
-                        http_thread_pool->start((void*)holder, "", m_threadCreateTimeout > 0?m_threadCreateTimeout*1000:0);
-                    }
-                    catch(...)
-                    {
-                        IERRLOG("Error starting thread from http thread pool.");
-                        if(accepted.get())
-                        {
-                            accepted->close();
-                            //Assumption here is that if start() throws exception, that means the new 
-                            //thread hasn't been started, so there's no other thread holding a link.
-                            CInterface* ci = dynamic_cast<CInterface*>(accepted.get());
-                            if(ci && ci->IsShared())
-                                accepted->Release();
-                        }
-                        delete [] holder;
-                        throw;
-                    }
-                    delete [] holder;
+                    if(http_request_collector)
+                        http_request_collector->add(accepted, this, apport, persistentHandler, shouldClose);
+                    else
+                        startPooledThread(accepted, apport, persistentHandler, shouldClose, nullptr);
                 }
                 else
                 {
@@ -323,7 +525,7 @@ bool CSecureHttpProtocol::notifySelected(ISocket *sock,unsigned selected, IPersi
                     if(m_maxConcurrentThreads > 0)
                     {
                         // Using Threading pool instead of generating one thread per request.
-                        void ** holder = new void*[7];
+                        void ** holder = new void*[8];
                         holder[0] = (void*)accepted.getLink();
                         holder[1] = (void*)apport;
                         int maxEntityLength = getMaxRequestEntityLength();
@@ -333,6 +535,7 @@ bool CSecureHttpProtocol::notifySelected(ISocket *sock,unsigned selected, IPersi
                         holder[4] = (void*)m_ssctx.get();
                         holder[5] = (void*)persistentHandler;
                         holder[6] = (void*)&shouldClose;
+                        holder[7] = nullptr;
                         http_thread_pool->start((void*)holder);
                         delete [] holder;
                     }
@@ -516,6 +719,11 @@ void CPooledHttpThread::init(void *param)
     m_ssctx = (ISecureSocketContext*)(((void**)param)[4]);
     m_persistentHandler = (IPersistentHandler*)(((void**)param)[5]);
     m_shouldClose = *(bool*)(((void**)param)[6]);
+    MemoryBuffer *prefetched = (MemoryBuffer*)(((void**)param)[7]);
+    if (prefetched)
+        m_prefetched.swapWith(*prefetched);
+    else
+        m_prefetched.clear();
     m_httpserver = nullptr;
     m_processAborted = false;
     m_socketReturned = false;
@@ -567,7 +775,10 @@ void CPooledHttpThread::threadmain()
     else
     {
         httpserver.setown(new CEspHttpServer(*m_socket, m_apport, false, getMaxRequestEntityLength()));
+        if (m_prefetched.length())
+            httpserver->setPrefetchedData(m_prefetched);
     }
+    m_prefetched.clear();
     m_httpserver = httpserver;
     httpserver->setShouldClose(m_shouldClose);
     httpserver->setSocketReturner(this);
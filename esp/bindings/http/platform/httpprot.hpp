@@ -52,6 +52,7 @@ private:
     IHttpServerService* m_httpserver = nullptr;
     bool m_socketReturned = false;
     bool m_processAborted = false;
+    MemoryBuffer m_prefetched;
 public:
     IMPLEMENT_IINTERFACE;
 
@@ -116,6 +117,9 @@ class esp_http_decl CHttpProtocol : public CEspProtocol
 private:
     int m_maxConcurrentThreads;
     int m_threadCreateTimeout;
+
+    void startPooledThread(ISocket *accepted, CEspApplicationPort *apport, IPersistentHandler* persistentHandler, bool shouldClose, MemoryBuffer *prefetched);
+    friend class CHttpRequestCollector;
 public:
     CHttpProtocol();
     virtual ~CHttpProtocol();
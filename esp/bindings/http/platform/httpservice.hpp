@@ -162,6 +162,7 @@ public:
     bool persistentEligible();
     void setIsSSL(bool _isSSL) { isSSL = _isSSL; };
     void setShouldClose(bool should) { shouldClose = should; }
+    void setPrefetchedData(const MemoryBuffer &data) { m_request->setPrefetchedData(data); }
     void setSocketReturner(ISocketReturner* returner)
     {
         m_socketReturner = returner;
@@ -1294,6 +1294,79 @@ bool CHttpMessage::checkPersistentEligible()
     return isHttpPersistable(m_version.str() + verOffset, conHeader.str());
 }
 
+void CHttpMessage::setPrefetchedData(const MemoryBuffer &data)
+{
+    m_bufferedsocket.setown(createBufferedSocket(&m_socket, data.toByteArray(), data.length()));
+}
+
+/******************************************************************************
+              CHttpRequestScanner Implementation
+*******************************************************************************/
+
+bool CHttpRequestScanner::append(const void *data, size32_t len)
+{
+    m_data.append(len, data);
+    if (!m_headersComplete)
+    {
+        const char *text = (const char *) m_data.toByteArray();
+        size32_t available = m_data.length();
+        // Resume scanning just before the previous end, in case the terminator was split between reads
+        size32_t pos = m_scanned > 3 ? m_scanned - 3 : 0;
+        for (; pos < available; pos++)
+        {
+            if (text[pos] != '\n')
+                continue;
+            if ((pos + 1 < available) && (text[pos+1] == '\n'))
+            {
+                m_required = pos + 2;
+                m_headersComplete = true;
+                break;
+            }
+            if ((pos + 2 < available) && (text[pos+1] == '\r') && (text[pos+2] == '\n'))
+            {
+                m_required = pos + 3;
+                m_headersComplete = true;
+                break;
+            }
+        }
+        m_scanned = available;
+        if (!m_headersComplete)
+            return available > maxHeaderBlock;
+        processHeaders();
+    }
+    return m_data.length() >= m_required;
+}
+
+void CHttpRequestScanner::processHeaders()
+{
+    const char *text = (const char *) m_data.toByteArray();
+    const char *end = text + m_required;
+    const char *line = (const char *) memchr(text, '\n', m_required);
+    __int64 contentLength = 0;
+    bool expectContinue = false;    // the client will not send the body until it is told to
+    while (line && ++line < end)
+    {
+        const char *next = (const char *) memchr(line, '\n', end - line);
+        if (!next)
+            break;
+        if (strnicmp(line, "Content-Length:", 15) == 0)
+            contentLength = _atoi64(line + 15);
+        else if (strnicmp(line, "Expect:", 7) == 0)
+            expectContinue = true;
+        line = next;
+    }
+    if (!expectContinue && (contentLength > 0) && (contentLength <= maxPrefetchedContent))
+        m_required += (size32_t) contentLength;
+}
+
+void CHttpRequestScanner::clear()
+{
+    m_data.clear();
+    m_scanned = 0;
+    m_required = 0;
+    m_headersComplete = false;
+}
+
 /******************************************************************************
               CHttpRequest Implementation
 *******************************************************************************/
@@ -2968,3 +3041,110 @@ bool CHttpResponse::checkPersistentEligible()
 
     return CHttpMessage::checkPersistentEligible();
 }
+
+#ifdef _USE_CPPUNIT
+#include <cppunit/extensions/HelperMacros.h>
+
+class HttpRequestScannerTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(HttpRequestScannerTest);
+        CPPUNIT_TEST(testHeadersOnly);
+        CPPUNIT_TEST(testSplitTerminator);
+        CPPUNIT_TEST(testBareNewlines);
+        CPPUNIT_TEST(testContentLength);
+        CPPUNIT_TEST(testExpectContinue);
+        CPPUNIT_TEST(testLargeContent);
+        CPPUNIT_TEST(testOversizedHeaders);
+        CPPUNIT_TEST(testClear);
+    CPPUNIT_TEST_SUITE_END();
+
+    static bool append(CHttpRequestScanner &scanner, const char *text)
+    {
+        return scanner.append(text, strlen(text));
+    }
+
+protected:
+    void testHeadersOnly()
+    {
+        CHttpRequestScanner scanner;
+        CPPUNIT_ASSERT(!append(scanner, "GET /WsSMC/Activity HTTP/1.1\r\nHost: localhost\r\n"));
+        CPPUNIT_ASSERT(append(scanner, "\r\n"));
+        CPPUNIT_ASSERT_EQUAL((size32_t) 49, scanner.queryData().length());
+    }
+
+    void testSplitTerminator()
+    {
+        // Feed the request a byte at a time so the blank line is split across every possible boundary
+        const char *request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        size32_t len = strlen(request);
+        CHttpRequestScanner scanner;
+        for (size32_t i = 0; i < len - 1; i++)
+            CPPUNIT_ASSERT(!scanner.append(request + i, 1));
+        CPPUNIT_ASSERT(scanner.append(request + len - 1, 1));
+        CPPUNIT_ASSERT(memcmp(scanner.queryData().toByteArray(), request, len) == 0);
+    }
+
+    void testBareNewlines()
+    {
+        CHttpRequestScanner scanner;
+        CPPUNIT_ASSERT(!append(scanner, "GET / HTTP/1.0\nHost: localhost\n"));
+        CPPUNIT_ASSERT(append(scanner, "\n"));
+    }
+
+    void testContentLength()
+    {
+        CHttpRequestScanner scanner;
+        CPPUNIT_ASSERT(!append(scanner, "POST /WsWorkunits/WUQuery HTTP/1.1\r\ncontent-length: 10\r\nHost: localhost\r\n\r\n"));
+        CPPUNIT_ASSERT(!append(scanner, "01234"));
+        CPPUNIT_ASSERT(!append(scanner, "5678"));
+        CPPUNIT_ASSERT(append(scanner, "9"));
+
+        // The body may arrive in the same read as the headers
+        scanner.clear();
+        CPPUNIT_ASSERT(append(scanner, "POST / HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc"));
+
+        // A zero length body is complete with the headers
+        scanner.clear();
+        CPPUNIT_ASSERT(append(scanner, "POST / HTTP/1.1\r\nContent-Length: 0\r\n\r\n"));
+    }
+
+    void testExpectContinue()
+    {
+        // The client waits for a 100 Continue before sending the body, so the request must be dispatched without it
+        CHttpRequestScanner scanner;
+        CPPUNIT_ASSERT(append(scanner, "POST / HTTP/1.1\r\nContent-Length: 100\r\nExpect: 100-continue\r\n\r\n"));
+    }
+
+    void testLargeContent()
+    {
+        // Bodies too large to prefetch are left for the worker thread to read
+        VStringBuffer request("POST / HTTP/1.1\r\nContent-Length: %u\r\n\r\n", CHttpRequestScanner::maxPrefetchedContent + 1);
+        CHttpRequestScanner scanner;
+        CPPUNIT_ASSERT(append(scanner, request.str()));
+    }
+
+    void testOversizedHeaders()
+    {
+        // A header block that never terminates is handed on once it exceeds the limit, rather than buffered forever
+        CHttpRequestScanner scanner;
+        StringBuffer header("GET / HTTP/1.1\r\nX-Filler: ");
+        CPPUNIT_ASSERT(!append(scanner, header.str()));
+        header.clear().appendN(CHttpRequestScanner::maxHeaderBlock, 'x');
+        CPPUNIT_ASSERT(append(scanner, header.str()));
+    }
+
+    void testClear()
+    {
+        CHttpRequestScanner scanner;
+        CPPUNIT_ASSERT(append(scanner, "GET / HTTP/1.1\r\n\r\n"));
+        scanner.clear();
+        CPPUNIT_ASSERT_EQUAL((size32_t) 0, scanner.queryData().length());
+        CPPUNIT_ASSERT(!append(scanner, "GET / HTTP/1.1\r\n"));
+        CPPUNIT_ASSERT(append(scanner, "\r\n"));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HttpRequestScannerTest);
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(HttpRequestScannerTest, "HttpRequestScannerTest");
+
+#endif // _USE_CPPUNIT
@@ -115,6 +115,8 @@ public:
     virtual ~CHttpMessage();
 
     virtual ISocket* getSocket() {return &m_socket;};
+    // Supply data that has already been read from the socket.  Must be called before anything is received.
+    void setPrefetchedData(const MemoryBuffer &data);
 
     StringArray &queryHeaders(){return m_headers;}
 
@@ -439,6 +441,29 @@ public:
     virtual bool decompressContent(StringBuffer* originalContent, int compressType);
 };
 
+// Incrementally checks whether enough of a request has arrived for it to be processed without waiting on the client.
+// That is the case once the headers, and any body of a known length up to maxPrefetchedContent, have been received.
+// Chunked bodies, "Expect: 100-continue", large bodies and malformed requests are treated as ready as soon as the
+// headers are complete (or are too long), leaving CHttpRequest to read or reject the rest as it does today.
+class esp_http_decl CHttpRequestScanner
+{
+public:
+    static constexpr size32_t maxPrefetchedContent = 0x100000;
+    static constexpr size32_t maxHeaderBlock = 0x10000;
+
+    bool append(const void *data, size32_t len); // returns true once the request is ready
+    MemoryBuffer &queryData() { return m_data; }
+    void clear();
+
+private:
+    void processHeaders();
+
+    MemoryBuffer m_data;
+    size32_t m_scanned = 0;
+    size32_t m_required = 0;    // total length needed once the headers have been seen
+    bool m_headersComplete = false;
+};
+
 inline bool canRedirect(CHttpRequest &req)
 {
     if (req.queryParameters()->hasProp("rawxml_"))
@@ -17,6 +17,7 @@
 
 // todo look at IRemoteFileServer stop
 
+#include <memory>
 #include <vector>
 
 #include "platform.h"
@@ -31,6 +32,7 @@
 #include "jthread.hpp"
 #include "jqueue.tpp"
 #include "jsecrets.hpp"
+#include "jmetrics.hpp"
 
 #include "securesocket.hpp"
 #include "portlist.h"
@@ -94,6 +96,8 @@ enum OutputFormat:byte { outFmt_Binary, outFmt_Xml, outFmt_Json };
 
 
 static unsigned maxConnectTime = 0;
+// Time taken to process and reply to a request, 10us up to ~5s
+static auto pRequestLatency = hpccMetrics::registerHistogramMetric("dafilesrv.request.latency", "Distribution of request processing times", SMeasureTimeNs, hpccMetrics::createExponentialBuckets(10000, 2, 20));
 static unsigned maxReceiveTime = 0;
 
 #ifndef _CONTAINERIZED
@@ -1523,7 +1527,26 @@ protected:
     Owned<const IDynamicFieldValueFetcher> fieldFetcher;
     Owned<const IDynamicTransform> translator;
     bool postProject = false;
+    /* If filtering, the leading fields that the filter needs are translated on their own first,
+     * so that rows that fail the filter are never fully materialized.
+     */
+    std::vector<const RtlFieldInfo *> filterFields;
+    std::unique_ptr<RtlRecord> filterRecord;
+    Owned<const IDynamicTransform> filterTranslator;
+    MemoryBuffer filterRowMb;
 
+    inline bool preFilterMatch()
+    {
+        if (!filterTranslator)
+            return true;
+        MemoryBufferBuilder filterBuilder(filterRowMb.clear(), 0);
+        filterTranslator->translate(filterBuilder, *this, *fieldFetcher);
+        return fieldFilterMatch(filterBuilder.getSelf());
+    }
+    inline bool postFilterMatch(const void *row)
+    {
+        return filterTranslator || fieldFilterMatch(row); // already checked if pre-filtered
+    }
 public:
     CRemoteExternalFormatReadActivity(IPropertyTree &config, IFileDescriptor *fileDesc) : PARENT(config, fileDesc)
     {
@@ -1544,6 +1567,18 @@ public:
                 outMeta.set(inMeta);
         }
         translator.setown(createRecordTranslatorViaCallback(*outRecord, *record, type_utf8));
+        if (filterRow && !record->hasNested() && !record->getNumIfBlocks())
+        {
+            unsigned numFilterFields = filters.getNumFieldsRequired();
+            if (numFilterFields < numInputFields)
+            {
+                for (unsigned f=0; f<numFilterFields; f++)
+                    filterFields.push_back(record->queryField(f));
+                filterFields.push_back(nullptr);
+                filterRecord.reset(new RtlRecord(filterFields.data(), false));
+                filterTranslator.setown(createRecordTranslatorViaCallback(*filterRecord, *record, type_utf8));
+            }
+        }
     }
     virtual bool requiresPostProject() const override
     {
@@ -1665,10 +1700,16 @@ public:
             if (!lineLength)
                 break;
 
+            if (!preFilterMatch())
+            {
+                if (!fetching) // harmless, but pointless to skip if fetching
+                    inputStream->skip(lineLength);
+                continue;
+            }
             retSz = translator->translate(outBuilder, *this, *fieldFetcher);
             dbgassertex(retSz);
             const void *ret = outBuilder.getSelf();
-            if (fieldFilterMatch(ret))
+            if (postFilterMatch(ret))
             {
                 outBuilder.finishRow(retSz);
                 ++processed;
@@ -1941,12 +1982,17 @@ public:
             if (lastMatch)
             {
                 ((CFieldFetcher *)fieldFetcher.get())->setCurrentMatch(lastMatch);
+                if (!preFilterMatch())
+                {
+                    lastMatch.clear();
+                    continue;
+                }
                 retSz = translator->translate(outBuilder, *this, *fieldFetcher);
                 dbgassertex(retSz);
 
                 lastMatch.clear();
                 const void *ret = outBuilder.getSelf();
-                if (fieldFilterMatch(ret))
+                if (postFilterMatch(ret))
                 {
                     outBuilder.finishRow(retSz);
                     ++processed;
@@ -3022,12 +3068,14 @@ class CRemoteFileServer : implements IRemoteFileServer, public CInterface
 
         void processCommand(RemoteFileCommandType cmd, MemoryBuffer &msg, CThrottler *throttler)
         {
+            CCycleTimer requestTimer;
             MemoryBuffer reply;
             CommandRetFlags cmdFlags = parent->processCommand(cmd, msg, initSendBuffer(reply), this, throttler);
 
             // some commands (i.e. RFCFtSlaveCmd), reply early, so should not reply again here.
             if (!hasMask(cmdFlags, CommandRetFlags::replyHandled))
                 sendDaFsBuffer(socket, reply, hasMask(cmdFlags, CommandRetFlags::testSocket));
+            pRequestLatency->recordMeasurement(requestTimer.elapsedNs());
         }
 
         bool immediateCommand() // returns false if socket closed or failure
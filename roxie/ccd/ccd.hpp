@@ -411,6 +411,7 @@ extern unsigned udpMulticastBufferSize;
 extern unsigned nodeCacheMB;
 extern unsigned leafCacheMB;
 extern unsigned blobCacheMB;
+extern unsigned resultCacheMB;
 
 extern Owned<IPerfMonHook> perfMonHook;
 
@@ -434,6 +435,7 @@ extern unsigned defaultKeyedJoinPreload;
 extern unsigned defaultPrefetchProjectPreload;
 extern unsigned defaultStrandBlockSize;
 extern unsigned defaultForceNumStrands;
+extern unsigned defaultAutoStrandThreshold;
 extern unsigned defaultHeapFlags;
 
 extern bool defaultCheckingHeap;
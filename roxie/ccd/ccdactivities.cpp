@@ -371,6 +371,15 @@ protected:
     {
     }
 
+    IMessagePacker *createResultStream()
+    {
+        // Replies can only be shared between queries if they depend on nothing but the packet and the query's files
+        Owned<IMessagePacker> output = ROQ->createOutputStream(packet->queryHeader(), false, logctx);
+        if (resultCache && !variableFileName && !logctx.queryDebuggerActive())
+            return resultCache->createRecorder(packet, output);
+        return output.getClear();
+    }
+
     CRoxieAgentActivity(AgentContextLogger &_logctx, IRoxieQueryPacket *_packet, HelperFactory *_hFactory, const CAgentActivityFactory *_factory)
         : logctx(_logctx), packet(_packet), basefactory(_factory)
     {
@@ -2867,7 +2876,7 @@ public:
         }
         unsigned __int64 stopAfter = readHelper->getChooseNLimit();
 
-        Owned<IMessagePacker> output = ROQ->createOutputStream(packet->queryHeader(), false, logctx);
+        Owned<IMessagePacker> output = createResultStream();
         OptimizedRowBuilder rowBuilder(rowAllocator, meta, output, serializer);
 
         unsigned totalSizeSent = 0;
@@ -3697,8 +3706,11 @@ protected:
     Linked<IFileIOArray> files;
     const IDynamicTransform *translator = nullptr;
     bool needsRHS;
+    Owned<IPrefetchFileIO> prefetchFile;
+    const char *prefetchLimit = nullptr;
 
     virtual size32_t doFetch(ARowBuilder & rowBuilder, offset_t pos, offset_t rawpos, void *inputData) = 0;
+    const char *prefetchRows(const char *next);
 
 public:
     CRoxieFetchActivityBase(AgentContextLogger &_logctx, IRoxieQueryPacket *_packet,  HelperFactory *_hFactory,
@@ -3749,6 +3761,8 @@ IMessagePacker *CRoxieFetchActivityBase::process()
     while (!aborted && inputData < inputLimit)
     {
         checkPartChanged(*(PartNoType *) inputData);
+        if (inputData >= prefetchLimit)
+            prefetchLimit = prefetchRows(inputData);
         inputData += sizeof(PartNoType);
         offset_t rp = *(offset_t *)inputData;
         inputData += sizeof(offset_t);
@@ -3796,6 +3810,46 @@ IMessagePacker *CRoxieFetchActivityBase::process()
         return output.getClear();
 }
 
+static constexpr unsigned fetchPrefetchRows = 64;
+static constexpr size32_t fetchPrefetchSize = 0x1000;      // matches the buffer size of the stream the rows are read from
+
+//The rows are read one at a time, and each read is a random seek.  If the file supports it, read the start of the
+//following rows for the same part as a single batch of concurrent reads.  The fetches then read the rows from the
+//prefetched blocks.  Returns the position of the first row that was not prefetched.
+const char *CRoxieFetchActivityBase::prefetchRows(const char *next)
+{
+    const PartNoType part = *(const PartNoType *)next;
+    if (!prefetchFile)
+        return inputLimit;
+
+    offset_t positions[fetchPrefetchRows];
+    unsigned num = 0;
+    while ((next < inputLimit) && (num < fetchPrefetchRows))
+    {
+        const PartNoType &thisPart = *(const PartNoType *)next;
+        if ((thisPart.partNo != part.partNo) || (thisPart.fileNo != part.fileNo))
+            break;
+        const char *cur = next + sizeof(PartNoType);
+        offset_t rp = *(const offset_t *)cur;
+        cur += sizeof(offset_t);
+        unsigned rhsSize = 0;
+        if (needsRHS)
+        {
+            rhsSize = *(const unsigned *)cur;
+            cur += sizeof(unsigned);
+        }
+        next = cur + rhsSize;
+
+        positions[num++] = isLocalFpos(rp) ? getLocalFposOffset(rp) : rp-base;
+    }
+
+    if (num > 1)
+        prefetchFile->prefetch(num, positions, fetchPrefetchSize);
+    else
+        prefetchFile->clearPrefetched();
+    return next;
+}
+
 class CRoxieFetchActivity : public CRoxieFetchActivityBase
 {
     Owned<IEngineRowAllocator> diskAllocator;
@@ -3984,6 +4038,14 @@ void CRoxieFetchActivityBase::setPartNo(bool filechanged)
     rawFile.setown(files->getFilePart(lastPartNo.partNo, base)); // MORE - superfiles
     translator = translators->queryTranslator(0);                // MORE - superfiles
     assertex(rawFile != NULL);
+    if (canReadFileConcurrently(rawFile))
+    {
+        prefetchFile.setown(createPrefetchFileIO(rawFile));
+        rawFile.set(prefetchFile);
+    }
+    else
+        prefetchFile.clear();
+    prefetchLimit = nullptr;
     rawStream.setown(createFileSerialStream(rawFile, 0, -1, 0));
 }
 
@@ -4258,7 +4320,7 @@ IRoxieAgentActivity *CRoxieKeyedJoinIndexActivityFactory::createActivity(AgentCo
 IMessagePacker *CRoxieKeyedJoinIndexActivity::process()
 {
     MTIME_SECTION(queryActiveTimer(), "CRoxieKeyedJoinIndexActivity::process");
-    Owned<IMessagePacker> output = ROQ->createOutputStream(packet->queryHeader(), false, logctx);
+    Owned<IMessagePacker> output = createResultStream();
     CachedOutputMetaData joinFieldsMeta(helper->queryJoinFieldsRecordSize());
     Owned<IEngineRowAllocator> joinFieldsAllocator = getRowAllocator(joinFieldsMeta, basefactory->queryId());
     OptimizedKJRowBuilder rowBuilder(joinFieldsAllocator, joinFieldsMeta, output);
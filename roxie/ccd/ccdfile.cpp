@@ -83,7 +83,7 @@ public:
     virtual unsigned __int64 getStatistic(StatisticKind kind) { return 0; }
 } failure;
 
-class CRoxieLazyFileIO : implements ILazyFileIO, implements IDelayedFile, public CInterface
+class CRoxieLazyFileIO : implements ILazyFileIO, implements IDelayedFile, implements IBatchReadFileIO, public CInterface
 {
 protected:
     IArrayOf<IFile> sources;
@@ -382,6 +382,45 @@ public:
         }
     }
 
+    virtual bool canReadConcurrently() override
+    {
+        try
+        {
+            unsigned activeIdx;
+            Owned<IFileIO> active = getCheckOpen(activeIdx);
+            return !remote && canReadFileConcurrently(active);
+        }
+        catch (IException *E)
+        {
+            E->Release();
+            return false;
+        }
+    }
+
+    virtual void readBatch(unsigned num, FileReadRequest * requests) override
+    {
+        unsigned activeIdx;
+        Owned<IFileIO> active = getCheckOpen(activeIdx);
+        try
+        {
+            readFileBatch(active, num, requests);
+        }
+        catch (IException *E)
+        {
+            //read() takes care of retrying and failing over to another source
+            E->Release();
+            for (unsigned i=0; i < num; i++)
+                requests[i].numRead = read(requests[i].pos, requests[i].len, requests[i].data);
+            return;
+        }
+        lastAccess = msTick();
+        if (cached && !remote)
+        {
+            for (unsigned i=0; i < num; i++)
+                cached->noteRead(fileIdx, requests[i].pos, requests[i].numRead);
+        }
+    }
+
     virtual void flush()
     {
         Linked<IFileIO> active;
@@ -826,15 +865,23 @@ public:
             // Round startOffset up to nearest multiple of index node size
             unsigned nodeSize = keyIndex->getNodeSize();
             startOffset = ((startOffset+nodeSize-1)/nodeSize)*nodeSize;
+            if (traceLevel > 8)
+                DBGLOG("prewarming index pages %u %s %" I64F "x-%" I64F "x", (int) nodeType, filename, startOffset, endOffset);
+            // Load the pages in batches so that several reads are outstanding at once
+            constexpr unsigned maxBatch = 64;
+            offset_t pages[maxBatch];
             do
             {
-                if (traceLevel > 8)
-                    DBGLOG("prewarming index page %u %s %" I64F "x-%" I64F "x", (int) nodeType, filename, startOffset, endOffset);
-                bool loaded = keyIndex->prewarmPage(startOffset, nodeType);
-                if (!loaded)
+                unsigned numPages = 0;
+                while ((numPages < maxBatch) && (startOffset < endOffset || numPages == 0))
+                {
+                    pages[numPages++] = startOffset;
+                    startOffset += nodeSize;
+                }
+                unsigned loaded = keyIndex->prewarmPages(numPages, pages, nodeType);
+                pagesPreloaded += loaded;
+                if (loaded != numPages)
                     break;
-                pagesPreloaded++;
-                startOffset += nodeSize;
             }
             while (startOffset < endOffset);
         }
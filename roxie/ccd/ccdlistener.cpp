@@ -19,6 +19,7 @@
 #include "jlib.hpp"
 #include "jthread.hpp"
 #include "jregexp.hpp"
+#include "jmetrics.hpp"
 #include "securesocket.hpp"
 
 #include "wujobq.hpp"
@@ -38,6 +39,9 @@
 
 //======================================================================================================================
 
+// Query latencies from 1ms up to ~33s
+static auto pQueryLatency = hpccMetrics::registerHistogramMetric("roxie.query.latency", "Distribution of completed query elapsed times", SMeasureTimeNs, hpccMetrics::createExponentialBuckets(1000000, 2, 16));
+
 static void controlException(StringBuffer &response, IException *E, const IRoxieContextLogger &logctx)
 {
     try
@@ -1153,6 +1157,7 @@ class RoxieWorkUnitWorker : public RoxieQueryWorker
         now->getLocalDate(y, mo, d);
         lastQueryTime = h*10000 + m * 100 + s;
         lastQueryDate = y*10000 + mo * 100 + d;
+        pQueryLatency->recordMeasurement((__uint64)elapsedTime * 1000000);
 
         switch(priority)
         {
@@ -1595,6 +1600,7 @@ public:
         now->getLocalDate(y, mo, d);
         lastQueryTime = h*10000 + m * 100 + s;
         lastQueryDate = y*10000 + mo * 100 + d;
+        pQueryLatency->recordMeasurement((__uint64)elapsedTime * 1000000);
         if (!notedActive)
         {
             unknownQueryStats.noteQuery(failed, elapsedTime);
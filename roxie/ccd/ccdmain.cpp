@@ -170,6 +170,7 @@ bool defaultCheckingHeap = false;
 bool defaultDisableLocalOptimizations = false;
 unsigned defaultStrandBlockSize = 512;
 unsigned defaultForceNumStrands = 0;
+unsigned defaultAutoStrandThreshold = 0;
 unsigned defaultHeapFlags = roxiemem::RHFnone;
 
 unsigned agentQueryReleaseDelaySeconds = 60;
@@ -218,6 +219,7 @@ bool inMemoryKeysEnabled = true;
 unsigned nodeCacheMB = 100;
 unsigned leafCacheMB = 50;
 unsigned blobCacheMB = 0;
+unsigned resultCacheMB = 0;
 
 unsigned roxiePort = 0;
 IPropertyTree *roxiePortTlsClientConfig = nullptr;
@@ -962,6 +964,7 @@ int CCD_API roxie_main(int argc, const char *argv[], const char * defaultYaml)
         traceStrands = topology->getPropBool("@traceStrands", false);
 
         useMemoryMappedIndexes = topology->getPropBool("@useMemoryMappedIndexes", false);
+        useKeyPrefixSearch = topology->getPropBool("@useKeyPrefixSearch", false);
         flushJHtreeCacheOnOOM = topology->getPropBool("@flushJHtreeCacheOnOOM", true);
         fastLaneQueue = topology->getPropBool("@fastLaneQueue", true);
         udpOutQsPriority = topology->getPropInt("@udpOutQsPriority", 0);
@@ -1066,6 +1069,7 @@ int CCD_API roxie_main(int argc, const char *argv[], const char * defaultYaml)
         defaultPrefetchProjectPreload = topology->getPropInt("@defaultPrefetchProjectPreload", 10);
         defaultStrandBlockSize = topology->getPropInt("@defaultStrandBlockSize", 512);
         defaultForceNumStrands = topology->getPropInt("@defaultForceNumStrands", 0);
+        defaultAutoStrandThreshold = topology->getPropInt("@defaultAutoStrandThreshold", 0);
         defaultCheckingHeap = topology->getPropBool("@checkingHeap", false);  // NOTE - not in configmgr - too dangerous!
         defaultDisableLocalOptimizations = topology->getPropBool("@disableLocalOptimizations", false);  // NOTE - not in configmgr - too dangerous!
 
@@ -1189,7 +1193,12 @@ int CCD_API roxie_main(int argc, const char *argv[], const char * defaultYaml)
         setLeafCacheMem(leafCacheMB * 0x100000);
         blobCacheMB = topology->getPropInt("@blobCacheMem", 0);
         setBlobCacheMem(blobCacheMB * 0x100000);
+        resultCacheMB = topology->getPropInt("@resultCacheMem", 0);
         setLegacyNodeCache(topology->getPropBool("@legacyNodeCache", false));
+        setNodeCacheShards(topology->getPropInt("@nodeCacheShards", 1));
+        unsigned nodeMemoryArenaMB = topology->getPropInt("@nodeMemoryArenaMem", 0);
+        if (nodeMemoryArenaMB)
+            setNodeMemoryArena((memsize_t) nodeMemoryArenaMB * 0x100000, allowHugePages, allowTransparentHugePages, topology->getPropBool("@nodeMemoryArenaPreFault", false));
 
         unsigned __int64 affinity = topology->getPropInt64("@affinity", 0);
         updateAffinity(affinity);
@@ -1323,6 +1332,8 @@ int CCD_API roxie_main(int argc, const char *argv[], const char * defaultYaml)
         ROQ = createOutputQueueManager(numAgentThreads, encryptInTransit);
         ROQ->setHeadRegionSize(headRegionSize);
         ROQ->start();
+        if (resultCacheMB)
+            resultCache = createResultCache((memsize_t) resultCacheMB * 0x100000);
         Owned<IPacketDiscarder> packetDiscarder = createPacketDiscarder();
 #if defined(WIN32) && defined(_DEBUG) && defined(_DEBUG_HEAP_FULL)
         int tmpFlag = _CrtSetDbgFlag( _CRTDBG_REPORT_FLAG );
@@ -1539,6 +1550,8 @@ int CCD_API roxie_main(int argc, const char *argv[], const char * defaultYaml)
         ROQ->join();
         ROQ->Release();
         ROQ = NULL;
+        ::Release(resultCache);
+        resultCache = nullptr;
         stopDelayedReleaser();
         closedDown.signal();
     }
@@ -331,6 +331,7 @@ QueryOptions::QueryOptions()
     bindCores = coresPerQuery;
     strandBlockSize = defaultStrandBlockSize;
     forceNumStrands = defaultForceNumStrands;
+    autoStrandThreshold = defaultAutoStrandThreshold;
     heapFlags = defaultHeapFlags;
 
     checkingHeap = defaultCheckingHeap;
@@ -370,6 +371,7 @@ QueryOptions::QueryOptions(const QueryOptions &other)
     bindCores = other.bindCores;
     strandBlockSize = other.strandBlockSize;
     forceNumStrands = other.forceNumStrands;
+    autoStrandThreshold = other.autoStrandThreshold;
     heapFlags = other.heapFlags;
 
     checkingHeap = other.checkingHeap;
@@ -419,6 +421,7 @@ void QueryOptions::setFromWorkUnit(IConstWorkUnit &wu, const IPropertyTree *stat
     updateFromWorkUnit(bindCores, wu, "bindCores");
     updateFromWorkUnit(strandBlockSize, wu, "strandBlockSize");
     updateFromWorkUnit(forceNumStrands, wu, "forceNumStrands");
+    updateFromWorkUnit(autoStrandThreshold, wu, "autoStrandThreshold");
     updateFromWorkUnit(heapFlags, wu, "heapFlags");
 
     updateFromWorkUnit(checkingHeap, wu, "checkingHeap");
@@ -494,6 +497,7 @@ void QueryOptions::setFromContext(const IPropertyTree *ctx)
         updateFromContext(bindCores, ctx, "@bindCores", "_bindCores");
         updateFromContext(strandBlockSize, ctx, "@strandBlockSize", "_strandBlockSize");
         updateFromContext(forceNumStrands, ctx, "@forceNumStrands", "_forceNumStrands");
+        updateFromContext(autoStrandThreshold, ctx, "@autoStrandThreshold", "_autoStrandThreshold");
         updateFromContext(heapFlags, ctx, "@heapFlags", "_HeapFlags");
 
         updateFromContext(checkingHeap, ctx, "@checkingHeap", "_CheckingHeap");
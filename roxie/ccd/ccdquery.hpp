@@ -97,6 +97,7 @@ public:
     int bindCores;
     unsigned strandBlockSize;
     unsigned forceNumStrands;
+    unsigned autoStrandThreshold;   // cpu ms per execution above which activities without a PARALLEL hint are stranded (0 = never)
     unsigned heapFlags;
 
     bool checkingHeap;
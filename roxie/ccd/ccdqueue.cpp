@@ -16,9 +16,11 @@
 ############################################################################## */
 
 #include <platform.h>
+#include <unordered_map>
 #include <jlib.hpp>
 #include <jio.hpp>
 #include <jqueue.tpp>
+#include <jqueue.hpp>
 #include <jsocket.hpp>
 #include <jlog.hpp>
 #include "jisem.hpp"
@@ -1091,14 +1093,220 @@ private:
     unsigned numOrphans = 0;
 };
 
+//=================================================================================
+//
+// RoxiePacketRing - a bounded multi-producer, multi-consumer ring of queued packets, using the same per-slot
+// sequence scheme as the ReaderWriterQueue in jqueue.hpp.
+// Each cell also holds a copy of the fields that RoxiePacketHeader::matchPacket compares, so that retry deduplication
+// and IBYTI removal can scan the queued packets without dereferencing them (a worker may be releasing them at the
+// same time). A packet belongs to whoever exchanges it out of its cell, so a packet taken from within the head
+// region, or removed by an IBYTI, leaves an empty cell that is skipped when the head reaches it.
+
+class RoxiePacketRing
+{
+    struct Cell
+    {
+        std::atomic<unsigned __int64> sequence;
+        std::atomic<unsigned __int64> key[2];
+        std::atomic<ISerializedRoxieQueryPacket *> packet;
+    };
+
+    Cell *cells;
+    unsigned __int64 cellMask;
+    char headPadding[CACHE_LINE_SIZE];
+    std::atomic<unsigned __int64> head{0};
+    char tailPadding[CACHE_LINE_SIZE - sizeof(std::atomic<unsigned __int64>)];
+    std::atomic<unsigned __int64> tail{0};
+    char endPadding[CACHE_LINE_SIZE - sizeof(std::atomic<unsigned __int64>)];
+
+    static inline void getKey(const RoxiePacketHeader &header, unsigned __int64 *key)
+    {
+        key[0] = ((unsigned __int64) header.uid << 32) | ((unsigned __int64) (header.overflowSequence & ~OUTOFBAND_SEQUENCE) << 16) | header.continueSequence;
+        key[1] = ((unsigned __int64) header.serverId.getIp4() << 16) | header.channel;
+    }
+
+    // Returns the cell at pos if it currently holds a published packet whose key matches
+    Cell *matchCell(unsigned __int64 pos, const unsigned __int64 *key, ISerializedRoxieQueryPacket * &packet) const
+    {
+        Cell &cell = cells[pos & cellMask];
+        unsigned __int64 seq = cell.sequence.load(std::memory_order_acquire);
+        if (seq != pos+1)
+            return nullptr;  // not yet published, or already consumed
+        packet = cell.packet.load(std::memory_order_acquire);
+        if (!packet)
+            return nullptr;
+        bool matched = (cell.key[0].load(std::memory_order_relaxed) == key[0]) && (cell.key[1].load(std::memory_order_relaxed) == key[1]);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (cell.sequence.load(std::memory_order_relaxed) != seq)
+            return nullptr;  // recycled while the key was being read
+        return matched ? &cell : nullptr;
+    }
+
+public:
+    RoxiePacketRing(unsigned numCells)
+    {
+        assertex(numCells && ((numCells & (numCells-1)) == 0));
+        cells = new Cell[numCells];
+        cellMask = numCells-1;
+        for (unsigned i = 0; i < numCells; i++)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+            cells[i].packet.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~RoxiePacketRing()
+    {
+        for (unsigned __int64 i = 0; i <= cellMask; i++)
+            ::Release(cells[i].packet.load(std::memory_order_relaxed));
+        delete [] cells;
+    }
+
+    bool enqueue(ISerializedRoxieQueryPacket *packet)
+    {
+        unsigned __int64 key[2];
+        getKey(packet->queryHeader(), key);
+        unsigned __int64 pos = tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[pos & cellMask];
+            unsigned __int64 seq = cell.sequence.load(std::memory_order_acquire);
+            __int64 diff = (__int64) (seq - pos);
+            if (diff == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed))
+                {
+                    std::atomic_thread_fence(std::memory_order_release); // pairs with the fence in matchCell
+                    cell.key[0].store(key[0], std::memory_order_relaxed);
+                    cell.key[1].store(key[1], std::memory_order_relaxed);
+                    cell.packet.store(packet, std::memory_order_release);
+                    cell.sequence.store(pos+1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false; // full
+            else
+                pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    ISerializedRoxieQueryPacket *dequeue()
+    {
+        unsigned __int64 pos = head.load(std::memory_order_relaxed);
+        unsigned spins = 0;
+        for (;;)
+        {
+            Cell &cell = cells[pos & cellMask];
+            unsigned __int64 seq = cell.sequence.load(std::memory_order_acquire);
+            __int64 diff = (__int64) (seq - (pos+1));
+            if (diff == 0)
+            {
+                if (head.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed))
+                {
+                    ISerializedRoxieQueryPacket *packet = cell.packet.exchange(nullptr, std::memory_order_acq_rel);
+                    cell.sequence.store(pos+cellMask+1, std::memory_order_release);
+                    if (packet)
+                        return packet;
+                    pos = head.load(std::memory_order_relaxed); // already taken from within the ring - skip it
+                }
+            }
+            else if (diff < 0)
+            {
+                // Only empty if no producer has claimed the cell.  Otherwise the producer is about to publish it, and may
+                // already have signalled for a later cell, so returning nullptr here would lose that wakeup.
+                if (pos == tail.load(std::memory_order_acquire))
+                    return nullptr;
+                if (++spins < 100)
+                    spinPause();
+                else
+                    ThreadYield();
+                pos = head.load(std::memory_order_relaxed);
+            }
+            else
+                pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Take a random packet from the first headRegionSize entries, so that one slow query cannot block a channel
+    ISerializedRoxieQueryPacket *dequeue(unsigned headRegionSize)
+    {
+        if (headRegionSize > 1)
+        {
+            unsigned __int64 first = head.load(std::memory_order_acquire);
+            unsigned __int64 last = tail.load(std::memory_order_acquire);
+            if (last > first+1)
+            {
+                unsigned __int64 lim = last - first;
+                if (lim > headRegionSize)
+                    lim = headRegionSize;
+                unsigned __int64 pos = first + (unsigned) fastRand() % lim;
+                if (pos != first)
+                {
+                    Cell &cell = cells[pos & cellMask];
+                    if (cell.sequence.load(std::memory_order_acquire) == pos+1)
+                    {
+                        ISerializedRoxieQueryPacket *packet = cell.packet.exchange(nullptr, std::memory_order_acq_rel);
+                        if (packet)
+                            return packet;
+                    }
+                }
+            }
+        }
+        return dequeue();
+    }
+
+    bool contains(const RoxiePacketHeader &header) const
+    {
+        unsigned __int64 key[2];
+        getKey(header, key);
+        unsigned __int64 last = tail.load(std::memory_order_acquire);
+        ISerializedRoxieQueryPacket *packet;
+        for (unsigned __int64 pos = head.load(std::memory_order_acquire); pos < last; pos++)
+        {
+            if (matchCell(pos, key, packet))
+                return true;
+        }
+        return false;
+    }
+
+    // NB: in the unlikely event that the cell was recycled (and the packet address reused) between matching and taking
+    // it, the packet returned may not match - caller must check.
+    ISerializedRoxieQueryPacket *remove(const RoxiePacketHeader &header, unsigned &scanLength)
+    {
+        unsigned __int64 key[2];
+        getKey(header, key);
+        unsigned __int64 last = tail.load(std::memory_order_acquire);
+        for (unsigned __int64 pos = head.load(std::memory_order_acquire); pos < last; pos++)
+        {
+            scanLength++;
+            ISerializedRoxieQueryPacket *packet;
+            Cell *cell = matchCell(pos, key, packet);
+            if (cell && cell->packet.compare_exchange_strong(packet, nullptr, std::memory_order_acq_rel))
+                return packet;
+        }
+        return nullptr;
+    }
+
+    unsigned ordinality() const
+    {
+        unsigned __int64 first = head.load(std::memory_order_acquire);
+        unsigned __int64 last = tail.load(std::memory_order_acquire);
+        return last > first ? (unsigned) (last - first) : 0;
+    }
+};
+
 //=================================================================================
 //
 // RoxieQueue - holds pending transactions on a roxie agent
 
 class RoxieQueue : public CInterface, implements IThreadFactory
 {
+    static constexpr unsigned ringSize = 0x2000; // packets queued beyond this spill into the (locked) overflow queue
     Owned <IThreadPool> workers;
+    RoxiePacketRing ring;
     QueueOf<ISerializedRoxieQueryPacket, true> waiting;
+    std::atomic<unsigned> overflowed{0};
     Semaphore available;
     CriticalSection qcrit;
     unsigned headRegionSize;
@@ -1107,6 +1315,17 @@ class RoxieQueue : public CInterface, implements IThreadFactory
     std::atomic<unsigned> idle;
     IBYTIbuffer *myIBYTIbuffer = nullptr;
 
+    void push(ISerializedRoxieQueryPacket *x)
+    {
+        // Once anything has overflowed, keep adding to the overflow queue until it drains, to preserve ordering
+        if (overflowed || !ring.enqueue(x))
+        {
+            CriticalBlock qc(qcrit);
+            waiting.enqueue(x);
+            overflowed++;
+        }
+    }
+
     void noteQueued()
     {
         maxQueueLength.store_max(++queueLength);
@@ -1124,7 +1343,7 @@ class RoxieQueue : public CInterface, implements IThreadFactory
 public:
     IMPLEMENT_IINTERFACE;
 
-    RoxieQueue(unsigned _headRegionSize, unsigned _numWorkers)
+    RoxieQueue(unsigned _headRegionSize, unsigned _numWorkers) : ring(ringSize)
     {
         headRegionSize = _headRegionSize;
         numWorkers = _numWorkers;
@@ -1175,13 +1394,10 @@ public:
 
     void enqueue(ISerializedRoxieQueryPacket *x)
     {
-        {
 #ifdef TIME_PACKETS
-            x->queryHeader().tick = msTick();
+        x->queryHeader().tick = msTick();
 #endif
-            CriticalBlock qc(qcrit);
-            waiting.enqueue(x);
-        }
+        push(x);
         noteQueued();
         available.signal();
     }
@@ -1192,22 +1408,28 @@ public:
 #ifdef TIME_PACKETS
         header.tick = msTick();
 #endif
-        bool found = false;
+        bool found;
         {
+            // The check and the push must be atomic, otherwise two copies of the same retry could both be queued.
+            // Only retries take this path, first time packets are pushed without the lock.
             CriticalBlock qc(qcrit);
-            unsigned len = waiting.ordinality();
-            unsigned i;
-            for (i = 0; i < len; i++)
+            found = ring.contains(header);
+            if (!found && overflowed)
             {
-                ISerializedRoxieQueryPacket *queued = waiting.item(i);
-                if (queued && queued->queryHeader().matchPacket(header))
+                unsigned len = waiting.ordinality();
+                unsigned i;
+                for (i = 0; i < len; i++)
                 {
-                    found = true;
-                    break;
+                    ISerializedRoxieQueryPacket *queued = waiting.item(i);
+                    if (queued && queued->queryHeader().matchPacket(header))
+                    {
+                        found = true;
+                        break;
+                    }
                 }
             }
             if (!found)
-                waiting.enqueue(x);
+                push(x); // NB: qcrit is reentrant, push takes it again if the ring is full
         }
         if (found)
         {
@@ -1239,7 +1461,13 @@ public:
     bool remove(RoxiePacketHeader &x)
     {
         unsigned scanLength = 0;
-        ISerializedRoxieQueryPacket *found = nullptr;
+        ISerializedRoxieQueryPacket *found = ring.remove(x, scanLength);
+        if (found && !found->queryHeader().matchPacket(x))
+        {
+            push(found); // its cell was reused while it was being matched, so not the packet we were looking for
+            found = nullptr;
+        }
+        if (!found && overflowed)
         {
             CriticalBlock qc(qcrit);
             unsigned len = waiting.ordinality();
@@ -1293,10 +1521,14 @@ public:
 
     ISerializedRoxieQueryPacket *dequeue()
     {
+        ISerializedRoxieQueryPacket *ret = ring.dequeue(headRegionSize);
+        if (ret || !overflowed)
+            return ret;
         CriticalBlock qc(qcrit);
         unsigned lim = waiting.ordinality();
         if (lim)
         {
+            overflowed--;
             if (headRegionSize)
             {
                 if (lim > headRegionSize)
@@ -1640,7 +1872,15 @@ public:
             }
 
             if (!debugging)
+            {
                 ROQ->sendIbyti(header, logctx, mySubChannel);
+                if (resultCache && resultCache->replay(packet, logctx))
+                {
+                    resultCacheHits++;
+                    busy = false;
+                    return;
+                }
+            }
 
             activitiesStarted++;
             unsigned activityId = packet->queryHeader().activityId & ~ROXIE_PRIORITY_MASK;
@@ -3329,6 +3569,231 @@ extern IRoxieOutputQueueManager *createOutputQueueManager(unsigned numWorkers, b
 
 //================================================================================================================================
 
+// The result cache remembers the complete reply an agent sent for an index read or keyed join, so that an identical
+// request from any query can be answered without repeating the lookups. A reply is recorded as the sequence of calls
+// made on the output IMessagePacker, and replayed onto a fresh output stream for the requesting packet. Replies are
+// only cached once they have been flushed - aborted activities and those that fail never flush their output.
+
+IRoxieResultCache *resultCache = nullptr;
+
+class CRoxieResultCache : public CInterfaceOf<IRoxieResultCache>
+{
+    enum : byte { OpFixed, OpVariable, OpMeta };
+
+    class CachedResult : public CInterface
+    {
+    public:
+        CachedResult(hash64_t _hash, MemoryBuffer &_key, MemoryBuffer &_reply) : hash(_hash)
+        {
+            key.swapWith(_key);
+            reply.swapWith(_reply);
+        }
+        inline memsize_t getMemoryUsage() const { return sizeof(CachedResult) + key.length() + reply.length(); }
+
+        CachedResult *next = nullptr;
+        CachedResult *prev = nullptr;
+        hash64_t hash;
+        MemoryBuffer key;
+        MemoryBuffer reply;
+    };
+
+    class CResultRecorder : public CInterfaceOf<IMessagePacker>
+    {
+    public:
+        CResultRecorder(CRoxieResultCache &_cache, IMessagePacker *_output, hash64_t _hash, MemoryBuffer &_key)
+            : cache(&_cache), output(_output), hash(_hash)
+        {
+            key.swapWith(_key);
+        }
+
+        virtual void *getBuffer(unsigned len, bool variable) override
+        {
+            return output->getBuffer(len, variable);
+        }
+        virtual void putBuffer(const void *buf, unsigned len, bool variable) override
+        {
+            record(variable ? OpVariable : OpFixed, buf, len);   // before forwarding - buf belongs to the output
+            output->putBuffer(buf, len, variable);
+        }
+        virtual void flush() override
+        {
+            output->flush();
+            if (!oversized && !flushed)
+                cache->add(hash, key, reply);   // takes the contents of key and reply, so only ever add once
+            flushed = true;
+        }
+        virtual void sendMetaInfo(const void *buf, unsigned len) override
+        {
+            record(OpMeta, buf, len);
+            output->sendMetaInfo(buf, len);
+        }
+        virtual unsigned size() const override
+        {
+            return output->size();
+        }
+
+    private:
+        void record(byte op, const void *buf, unsigned len)
+        {
+            if (oversized)
+                return;
+            if (reply.length() + len + key.length() > cache->maxEntrySize)
+            {
+                oversized = true;
+                reply.clear();
+                return;
+            }
+            reply.append(op).append(len).append(len, buf);
+        }
+
+        Linked<CRoxieResultCache> cache;
+        Linked<IMessagePacker> output;
+        hash64_t hash;
+        MemoryBuffer key;
+        MemoryBuffer reply;
+        bool oversized = false;
+        bool flushed = false;
+    };
+
+public:
+    CRoxieResultCache(memsize_t _memoryLimit) : memoryLimit(_memoryLimit), maxEntrySize(_memoryLimit / 16)
+    {
+    }
+    ~CRoxieResultCache()
+    {
+        clear();
+    }
+
+    virtual bool replay(IRoxieQueryPacket *packet, const IRoxieContextLogger &logctx) override
+    {
+        Owned<CachedResult> match = lookup(packet);
+        if (!match)
+            return false;
+        if (logctx.queryTraceLevel() > 5)
+        {
+            StringBuffer x;
+            logctx.CTXLOG("Replaying cached result for %s", packet->queryHeader().toString(x).str());
+        }
+        Owned<IMessagePacker> output = ROQ->createOutputStream(packet->queryHeader(), false, logctx);
+        replayReply(*match, output);
+        return true;
+    }
+
+    virtual IMessagePacker *createRecorder(IRoxieQueryPacket *packet, IMessagePacker *output) override
+    {
+        MemoryBuffer key;
+        hash64_t hash = getKey(key, packet);
+        return new CResultRecorder(*this, output, hash, key);
+    }
+
+    virtual void clear() override
+    {
+        CriticalBlock b(crit);
+        for (;;)
+        {
+            CachedResult *entry = lru.dequeueTail();
+            if (!entry)
+                break;
+            entry->Release();
+        }
+        entries.clear();
+        memoryUsed = 0;
+    }
+
+private:
+    friend class RoxieResultCacheTest;
+
+    CachedResult *lookup(IRoxieQueryPacket *packet)
+    {
+        MemoryBuffer key;
+        hash64_t hash = getKey(key, packet);
+        CriticalBlock b(crit);
+        auto it = entries.find(hash);
+        if (it == entries.end())
+            return nullptr;
+        CachedResult *entry = it->second;
+        if (entry->key.length() != key.length() || memcmp(entry->key.toByteArray(), key.toByteArray(), key.length()) != 0)
+            return nullptr;
+        lru.remove(entry);
+        lru.enqueueHead(entry);
+        return LINK(entry);
+    }
+
+    static void replayReply(CachedResult &match, IMessagePacker *output)
+    {
+        MemoryBuffer in;
+        in.setBuffer(match.reply.length(), const_cast<byte *>(match.reply.bytes()), false);
+        while (in.remaining())
+        {
+            byte op;
+            unsigned len;
+            in.read(op).read(len);
+            const void *data = in.readDirect(len);
+            if (op == OpMeta)
+                output->sendMetaInfo(data, len);
+            else
+            {
+                bool variable = (op == OpVariable);
+                void *buf = output->getBuffer(len, variable);
+                memcpy(buf, data, len);
+                output->putBuffer(buf, len, variable);
+            }
+        }
+        output->flush();
+    }
+
+    static hash64_t getKey(MemoryBuffer &key, IRoxieQueryPacket *packet)
+    {
+        // The query hash covers the package and the versions of the files the query uses, so no file details are needed here
+        const RoxiePacketHeader &header = packet->queryHeader();
+        key.append(header.queryHash).append(header.activityId & ~ROXIE_PRIORITY_MASK).append(header.channel).append(header.continueSequence);
+        unsigned len = packet->getContinuationLength();
+        key.append(len).append(len, packet->queryContinuationData());
+        len = packet->getSmartStepInfoLength();
+        key.append(len).append(len, packet->querySmartStepInfoData());
+        len = packet->getContextLength();
+        key.append(len).append(len, packet->queryContextData());
+        return rtlHash64Data(key.length(), key.toByteArray(), HASH64_INIT);
+    }
+
+    void add(hash64_t hash, MemoryBuffer &key, MemoryBuffer &reply)
+    {
+        Owned<CachedResult> entry = new CachedResult(hash, key, reply);
+        memsize_t size = entry->getMemoryUsage();
+        CriticalBlock b(crit);
+        auto it = entries.find(hash);
+        if (it != entries.end())
+            return;     // Another worker got there first
+        while (memoryUsed + size > memoryLimit)
+        {
+            CachedResult *victim = lru.dequeueTail();
+            if (!victim)
+                return;
+            entries.erase(victim->hash);
+            memoryUsed -= victim->getMemoryUsage();
+            victim->Release();
+        }
+        memoryUsed += size;
+        entries.emplace(hash, entry.get());
+        lru.enqueueHead(entry.getClear());   // the lru list owns the entries
+        resultCacheAdds++;
+    }
+
+    CriticalSection crit;
+    std::unordered_map<hash64_t, CachedResult *> entries;
+    DListOf<CachedResult> lru;      // most recently used at the head
+    memsize_t memoryLimit;
+    memsize_t maxEntrySize;
+    memsize_t memoryUsed = 0;
+};
+
+extern IRoxieResultCache *createResultCache(memsize_t memoryLimit)
+{
+    return new CRoxieResultCache(memoryLimit);
+}
+
+//================================================================================================================================
+
 class PacketDiscarder : public Thread, implements IPacketDiscarder
 {
     bool aborted;
@@ -3570,3 +4035,432 @@ extern void stopPingTimer()
     }
 }
 
+
+#ifdef _USE_CPPUNIT
+
+static ISerializedRoxieQueryPacket *createTestPacket(unsigned uid)
+{
+    RoxiePacketHeader header;
+    header.activityId = ROXIE_FILECALLBACK;
+    header.uid = uid;
+    MemoryBuffer mb;
+    mb.append(sizeof(header), &header);
+    return createSerializedRoxiePacket(mb);
+}
+
+class RoxiePacketRingTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(RoxiePacketRingTest);
+        CPPUNIT_TEST(testOrdering);
+        CPPUNIT_TEST(testRemove);
+        CPPUNIT_TEST(testHeadRegion);
+        CPPUNIT_TEST(testSignalledDequeue);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testOrdering()
+    {
+        RoxiePacketRing ring(4);
+        for (unsigned i = 0; i < 4; i++)
+            CPPUNIT_ASSERT(ring.enqueue(createTestPacket(i+RUID_FIRST)));
+        Owned<ISerializedRoxieQueryPacket> extra = createTestPacket(99);
+        CPPUNIT_ASSERT(!ring.enqueue(extra));
+        CPPUNIT_ASSERT_EQUAL(4U, ring.ordinality());
+        for (unsigned i = 0; i < 4; i++)
+        {
+            Owned<ISerializedRoxieQueryPacket> packet = ring.dequeue();
+            CPPUNIT_ASSERT(packet);
+            CPPUNIT_ASSERT_EQUAL(i+RUID_FIRST, packet->queryHeader().uid);
+        }
+        CPPUNIT_ASSERT(!ring.dequeue());
+        CPPUNIT_ASSERT(ring.enqueue(extra.getLink())); // cells are reusable once consumed
+    }
+    void testRemove()
+    {
+        RoxiePacketRing ring(8);
+        for (unsigned i = 0; i < 5; i++)
+            ring.enqueue(createTestPacket(i+RUID_FIRST));
+        Owned<ISerializedRoxieQueryPacket> probe = createTestPacket(2+RUID_FIRST);
+        CPPUNIT_ASSERT(ring.contains(probe->queryHeader()));
+        unsigned scanLength = 0;
+        Owned<ISerializedRoxieQueryPacket> removed = ring.remove(probe->queryHeader(), scanLength);
+        CPPUNIT_ASSERT(removed);
+        CPPUNIT_ASSERT(removed->queryHeader().matchPacket(probe->queryHeader()));
+        CPPUNIT_ASSERT(!ring.contains(probe->queryHeader()));
+        CPPUNIT_ASSERT(!ring.remove(probe->queryHeader(), scanLength));
+
+        // The removed packet's cell is skipped when dequeuing
+        unsigned expected[] = { 0, 1, 3, 4 };
+        for (unsigned i = 0; i < 4; i++)
+        {
+            Owned<ISerializedRoxieQueryPacket> packet = ring.dequeue();
+            CPPUNIT_ASSERT(packet);
+            CPPUNIT_ASSERT_EQUAL(expected[i]+RUID_FIRST, packet->queryHeader().uid);
+        }
+        CPPUNIT_ASSERT(!ring.dequeue());
+    }
+    void testHeadRegion()
+    {
+        const unsigned numPackets = 64;
+        RoxiePacketRing ring(numPackets);
+        for (unsigned i = 0; i < numPackets; i++)
+            ring.enqueue(createTestPacket(i+RUID_FIRST));
+        bool seen[numPackets] = { false };
+        for (unsigned i = 0; i < numPackets; i++)
+        {
+            Owned<ISerializedRoxieQueryPacket> packet = ring.dequeue(8);
+            CPPUNIT_ASSERT(packet);
+            unsigned idx = packet->queryHeader().uid-RUID_FIRST;
+            CPPUNIT_ASSERT(idx < numPackets && !seen[idx]);
+            CPPUNIT_ASSERT(idx < i+8); // always taken from within the head region
+            seen[idx] = true;
+        }
+        CPPUNIT_ASSERT(!ring.dequeue(8));
+    }
+    void testSignalledDequeue()
+    {
+        // Each enqueue is signalled, as the agent queue does, so every dequeue following a wait must find a packet -
+        // even when it reaches a cell that a producer has claimed but not yet published.
+        const unsigned numProducers = 4;
+        const unsigned numConsumers = 4;
+        const unsigned numPackets = 20000; // per producer
+        RoxiePacketRing ring(64);
+        Semaphore available;
+        std::atomic<unsigned> missed{0};
+        asyncFor(numProducers+numConsumers, numProducers+numConsumers, [&](unsigned i)
+        {
+            if (i < numProducers)
+            {
+                for (unsigned n = 0; n < numPackets; n++)
+                {
+                    ISerializedRoxieQueryPacket *packet = createTestPacket(n+RUID_FIRST);
+                    while (!ring.enqueue(packet))
+                        ThreadYield();
+                    available.signal();
+                }
+            }
+            else
+            {
+                for (unsigned n = 0; n < numPackets * numProducers / numConsumers; n++)
+                {
+                    available.wait();
+                    Owned<ISerializedRoxieQueryPacket> packet = ring.dequeue(8);
+                    if (!packet)
+                        missed++;
+                }
+            }
+        });
+        CPPUNIT_ASSERT_EQUAL(0U, missed.load());
+        CPPUNIT_ASSERT(!ring.dequeue());
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RoxiePacketRingTest);
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(RoxiePacketRingTest, "RoxiePacketRingTest");
+
+class RoxiePacketRingTiming : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(RoxiePacketRingTiming);
+        CPPUNIT_TEST(testThroughput);
+    CPPUNIT_TEST_SUITE_END();
+
+    class LockedQueue
+    {
+        QueueOf<ISerializedRoxieQueryPacket, true> waiting;
+        CriticalSection qcrit;
+    public:
+        bool enqueue(ISerializedRoxieQueryPacket *x)
+        {
+            CriticalBlock qc(qcrit);
+            waiting.enqueue(x);
+            return true;
+        }
+        ISerializedRoxieQueryPacket *dequeue(unsigned headRegionSize)
+        {
+            CriticalBlock qc(qcrit);
+            unsigned lim = waiting.ordinality();
+            if (!lim)
+                return nullptr;
+            if (lim > headRegionSize)
+                lim = headRegionSize;
+            return waiting.dequeue(fastRand() % lim);
+        }
+    };
+
+    static constexpr unsigned numIterations = 200000; // per producer
+    static constexpr unsigned headRegionSize = 50;
+
+    // Half the threads enqueue, half dequeue; returns the elapsed time in ms
+    template <class QUEUE>
+    unsigned __int64 timeQueue(QUEUE &queue, unsigned numThreads)
+    {
+        unsigned numProducers = numThreads / 2;
+        Owned<ISerializedRoxieQueryPacket> packet = createTestPacket(RUID_FIRST);
+        std::atomic<unsigned __int64> remaining{(unsigned __int64) numProducers * numIterations};
+        CCycleTimer timer;
+        asyncFor(numThreads, numThreads, [&](unsigned i)
+        {
+            if (i < numProducers)
+            {
+                for (unsigned n = 0; n < numIterations; n++)
+                {
+                    while (!queue.enqueue(packet))
+                        ThreadYield();
+                }
+            }
+            else
+            {
+                while (remaining.load(std::memory_order_relaxed))
+                {
+                    if (queue.dequeue(headRegionSize))
+                        remaining--;
+                    else
+                        spinPause();
+                }
+            }
+        });
+        return timer.elapsedMs();
+    }
+
+protected:
+    void testThroughput()
+    {
+        const unsigned threadCounts[] = { 2, 8, 64, 128 };
+        for (unsigned numThreads : threadCounts)
+        {
+            unsigned __int64 ops = (unsigned __int64) (numThreads / 2) * numIterations * 2;
+            LockedQueue locked;
+            unsigned __int64 lockedMs = timeQueue(locked, numThreads);
+            RoxiePacketRing ring(0x2000);
+            unsigned __int64 ringMs = timeQueue(ring, numThreads);
+            DBGLOG("RoxiePacketRing %3u threads: locked %" I64F "u ms (%" I64F "u ops/ms), ring %" I64F "u ms (%" I64F "u ops/ms)",
+                   numThreads, lockedMs, ops / (lockedMs ? lockedMs : 1), ringMs, ops / (ringMs ? ringMs : 1));
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(RoxiePacketRingTiming, "RoxiePacketRingTiming");
+
+class RoxieResultCacheTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(RoxieResultCacheTest);
+        CPPUNIT_TEST(testHit);
+        CPPUNIT_TEST(testMiss);
+        CPPUNIT_TEST(testFlushTwice);
+        CPPUNIT_TEST(testEviction);
+        CPPUNIT_TEST(testOversized);
+        CPPUNIT_TEST(testClear);
+    CPPUNIT_TEST_SUITE_END();
+
+    class TestPacket : public CInterfaceOf<IRoxieQueryPacket>
+    {
+    public:
+        TestPacket(unsigned activityId, const char *context)
+        {
+            header.queryHash = 0x1234;
+            header.activityId = activityId;
+            header.channel = 1;
+            contextData.append(context);
+        }
+        virtual RoxiePacketHeader &queryHeader() const override { return header; }
+        virtual const void *queryContinuationData() const override { return nullptr; }
+        virtual unsigned getContinuationLength() const override { return 0; }
+        virtual const byte *querySmartStepInfoData() const override { return nullptr; }
+        virtual unsigned getSmartStepInfoLength() const override { return 0; }
+        virtual const byte *queryTraceInfo() const override { return nullptr; }
+        virtual unsigned getTraceLength() const override { return 0; }
+        virtual const void *queryContextData() const override { return contextData.toByteArray(); }
+        virtual unsigned getContextLength() const override { return contextData.length(); }
+        virtual IRoxieQueryPacket *clonePacket(unsigned channel) const override { UNIMPLEMENTED; }
+        virtual IRoxieQueryPacket *insertSkipData(size32_t skipDataLen, const void *skipData) const override { UNIMPLEMENTED; }
+        virtual ISerializedRoxieQueryPacket *serialize() const override { UNIMPLEMENTED; }
+    private:
+        mutable RoxiePacketHeader header;
+        MemoryBuffer contextData;
+    };
+
+    // Records everything written to it, tagging each buffer with how it was sent
+    class TestPacker : public CInterfaceOf<IMessagePacker>
+    {
+    public:
+        virtual void *getBuffer(unsigned len, bool variable) override
+        {
+            return pending.clear().reserve(len);
+        }
+        virtual void putBuffer(const void *buf, unsigned len, bool variable) override
+        {
+            written.append(variable ? 'V' : 'F').append(len).append(len, buf);
+        }
+        virtual void flush() override
+        {
+            flushes++;
+        }
+        virtual void sendMetaInfo(const void *buf, unsigned len) override
+        {
+            written.append('M').append(len).append(len, buf);
+        }
+        virtual unsigned size() const override
+        {
+            return written.length();
+        }
+
+        MemoryBuffer written;
+        unsigned flushes = 0;
+    private:
+        MemoryBuffer pending;
+    };
+
+    static void sendReply(IMessagePacker *output, const char *row, unsigned rowLen)
+    {
+        void *buf = output->getBuffer(rowLen, true);
+        memcpy(buf, row, rowLen);
+        output->putBuffer(buf, rowLen, true);
+        buf = output->getBuffer(sizeof(unsigned), false);
+        memcpy(buf, &rowLen, sizeof(unsigned));
+        output->putBuffer(buf, sizeof(unsigned), false);
+        output->sendMetaInfo("meta", 4);
+        output->flush();
+    }
+
+    // Records a reply for the packet through the cache and returns what the agent actually sent
+    static void record(CRoxieResultCache &cache, IRoxieQueryPacket *packet, MemoryBuffer &sent, unsigned rowLen = 10)
+    {
+        Owned<TestPacker> output = new TestPacker;
+        Owned<IMessagePacker> recorder = cache.createRecorder(packet, output);
+        std::string row(rowLen, 'x');
+        sendReply(recorder, row.c_str(), rowLen);
+        CPPUNIT_ASSERT_EQUAL(1U, output->flushes);
+        sent.swapWith(output->written);
+    }
+
+    static bool replay(CRoxieResultCache &cache, IRoxieQueryPacket *packet, MemoryBuffer *replayed = nullptr)
+    {
+        Owned<CRoxieResultCache::CachedResult> match = cache.lookup(packet);
+        if (!match)
+            return false;
+        Owned<TestPacker> output = new TestPacker;
+        CRoxieResultCache::replayReply(*match, output);
+        CPPUNIT_ASSERT_EQUAL(1U, output->flushes);
+        if (replayed)
+            replayed->swapWith(output->written);
+        return true;
+    }
+
+protected:
+    void testHit()
+    {
+        Owned<CRoxieResultCache> cache = new CRoxieResultCache(0x100000);
+        Owned<IRoxieQueryPacket> packet = new TestPacket(1, "context");
+        MemoryBuffer sent, replayed;
+        CPPUNIT_ASSERT(!replay(*cache, packet));
+        record(*cache, packet, sent);
+        CPPUNIT_ASSERT(replay(*cache, packet, &replayed));
+        CPPUNIT_ASSERT_EQUAL(sent.length(), replayed.length());
+        CPPUNIT_ASSERT(memcmp(sent.toByteArray(), replayed.toByteArray(), sent.length()) == 0);
+
+        // An identical request from a different packet is answered from the cache too
+        Owned<IRoxieQueryPacket> same = new TestPacket(1, "context");
+        CPPUNIT_ASSERT(replay(*cache, same));
+    }
+
+    void testMiss()
+    {
+        Owned<CRoxieResultCache> cache = new CRoxieResultCache(0x100000);
+        Owned<IRoxieQueryPacket> packet = new TestPacket(1, "context");
+        MemoryBuffer sent;
+        record(*cache, packet, sent);
+        Owned<IRoxieQueryPacket> otherContext = new TestPacket(1, "context2");
+        Owned<IRoxieQueryPacket> otherActivity = new TestPacket(2, "context");
+        CPPUNIT_ASSERT(!replay(*cache, otherContext));
+        CPPUNIT_ASSERT(!replay(*cache, otherActivity));
+
+        // A recorder that is released without a flush (an aborted activity) must not add an entry
+        Owned<TestPacker> output = new TestPacker;
+        Owned<IMessagePacker> recorder = cache->createRecorder(otherContext, output);
+        void *buf = recorder->getBuffer(4, false);
+        memcpy(buf, "abcd", 4);
+        recorder->putBuffer(buf, 4, false);
+        recorder.clear();
+        CPPUNIT_ASSERT(!replay(*cache, otherContext));
+    }
+
+    void testFlushTwice()
+    {
+        Owned<CRoxieResultCache> cache = new CRoxieResultCache(0x100000);
+        Owned<IRoxieQueryPacket> packet = new TestPacket(1, "context");
+        Owned<TestPacker> output = new TestPacker;
+        Owned<IMessagePacker> recorder = cache->createRecorder(packet, output);
+        sendReply(recorder, "row", 3);
+        memsize_t used = cache->memoryUsed;
+        cache->clear();
+        recorder->flush();      // must not add an entry with an empty key and reply
+        CPPUNIT_ASSERT_EQUAL((memsize_t) 0, cache->memoryUsed);
+        CPPUNIT_ASSERT(used != 0);
+        CPPUNIT_ASSERT_EQUAL(2U, output->flushes);
+    }
+
+    void testEviction()
+    {
+        // Size the cache so that exactly two entries fit
+        memsize_t entrySize;
+        {
+            Owned<CRoxieResultCache> probe = new CRoxieResultCache(0x100000);
+            Owned<IRoxieQueryPacket> packet = new TestPacket(1, "context");
+            MemoryBuffer sent;
+            record(*probe, packet, sent);
+            entrySize = probe->memoryUsed;
+        }
+        Owned<CRoxieResultCache> cache = new CRoxieResultCache(entrySize * 5 / 2);
+        Owned<IRoxieQueryPacket> p1 = new TestPacket(1, "context");
+        Owned<IRoxieQueryPacket> p2 = new TestPacket(2, "context");
+        Owned<IRoxieQueryPacket> p3 = new TestPacket(3, "context");
+        Owned<IRoxieQueryPacket> p4 = new TestPacket(4, "context");
+        MemoryBuffer sent;
+        record(*cache, p1, sent);
+        record(*cache, p2, sent);
+        CPPUNIT_ASSERT(replay(*cache, p1));     // p1 becomes the most recently used
+        record(*cache, p3, sent);               // evicts p2
+        CPPUNIT_ASSERT(!replay(*cache, p2));
+        CPPUNIT_ASSERT(replay(*cache, p1));
+        CPPUNIT_ASSERT(replay(*cache, p3));
+        record(*cache, p4, sent);               // evicts p1
+        CPPUNIT_ASSERT(!replay(*cache, p1));
+        CPPUNIT_ASSERT(replay(*cache, p3));
+        CPPUNIT_ASSERT(replay(*cache, p4));
+        CPPUNIT_ASSERT(cache->memoryUsed <= entrySize * 5 / 2);
+    }
+
+    void testOversized()
+    {
+        Owned<CRoxieResultCache> cache = new CRoxieResultCache(0x10000);
+        Owned<IRoxieQueryPacket> packet = new TestPacket(1, "context");
+        MemoryBuffer sent;
+        record(*cache, packet, sent, 0x2000);   // larger than the maximum entry size
+        CPPUNIT_ASSERT(sent.length() > 0x2000);  // but still sent in full
+        CPPUNIT_ASSERT(!replay(*cache, packet));
+        CPPUNIT_ASSERT_EQUAL((memsize_t) 0, cache->memoryUsed);
+    }
+
+    void testClear()
+    {
+        Owned<CRoxieResultCache> cache = new CRoxieResultCache(0x100000);
+        Owned<IRoxieQueryPacket> p1 = new TestPacket(1, "context");
+        Owned<IRoxieQueryPacket> p2 = new TestPacket(2, "context");
+        MemoryBuffer sent;
+        record(*cache, p1, sent);
+        record(*cache, p2, sent);
+        cache->clear();
+        CPPUNIT_ASSERT(!replay(*cache, p1));
+        CPPUNIT_ASSERT(!replay(*cache, p2));
+        CPPUNIT_ASSERT_EQUAL((memsize_t) 0, cache->memoryUsed);
+
+        // The cache is usable again after being cleared
+        record(*cache, p1, sent);
+        CPPUNIT_ASSERT(replay(*cache, p1));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RoxieResultCacheTest);
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(RoxieResultCacheTest, "RoxieResultCacheTest");
+
+#endif
@@ -84,6 +84,18 @@ interface IPacketDiscarder : public IInterface
     virtual void stop() = 0;
 };
 
+// Agent-side cache of complete replies from deterministic activities (index reads, keyed joins), shared between queries.
+// Keyed on the query hash - which covers the package and file versions - the activity, and the packet's parameters.
+interface IRoxieResultCache : extends IInterface
+{
+    virtual bool replay(IRoxieQueryPacket *packet, const IRoxieContextLogger &logctx) = 0;   // sends the cached reply, if present
+    virtual IMessagePacker *createRecorder(IRoxieQueryPacket *packet, IMessagePacker *output) = 0; // caches the reply when flushed
+    virtual void clear() = 0;
+};
+
+extern IRoxieResultCache *resultCache;  // null unless @resultCacheMem is set
+extern IRoxieResultCache *createResultCache(memsize_t memoryLimit);
+
 extern IRoxieOutputQueueManager *createOutputQueueManager(unsigned numWorkers, bool encrypted);
 extern IReceiveManager *createLocalReceiveManager();
 extern IPacketDiscarder *createPacketDiscarder();
@@ -416,7 +416,7 @@ static const StatisticsMapping indexStatistics({StNumServerCacheHits, StNumIndex
                                                 StNumIndexRowsRead, StSizeAgentReply, StTimeAgentWait}, actStatistics);
 static const StatisticsMapping diskStatistics({StNumServerCacheHits, StNumDiskRowsRead, StNumDiskSeeks, StNumDiskAccepted,
                                                StNumDiskRejected, StSizeAgentReply, StTimeAgentWait }, actStatistics);
-static const StatisticsMapping soapStatistics({ StTimeSoapcall }, actStatistics);
+static const StatisticsMapping soapStatistics({ StTimeSoapcall, StNumSoapcalls }, actStatistics);
 static const StatisticsMapping groupStatistics({ StNumGroups, StNumGroupMax }, actStatistics);
 static const StatisticsMapping sortStatistics({ StTimeSortElapsed }, actStatistics);
 static const StatisticsMapping indexWriteStatistics({ StNumDuplicateKeys }, actStatistics);
@@ -436,7 +436,7 @@ extern const StatisticsMapping accumulatedStatistics({StWhenFirstRow, StTimeLoca
                                                       StNumBlobCacheAdds, StNumLeafCacheAdds, StNumNodeCacheAdds,
                                                       StTimeBlobLoad, StCycleBlobLoadCycles, StTimeLeafLoad, StCycleLeafLoadCycles, StTimeNodeLoad, StCycleNodeLoadCycles,  // If time and cycles are not included they are not serialized from agents
                                                       StNumDiskRejected, StSizeAgentReply, StTimeAgentWait,
-                                                      StTimeSoapcall,
+                                                      StTimeSoapcall, StNumSoapcalls,
                                                       StNumGroups,
                                                       StTimeSortElapsed,
                                                       StNumDuplicateKeys});
@@ -2003,6 +2003,66 @@ public:
 
 //=================================================================================
 
+// Tracks the cpu cost of a factory's activities across executions, so that activities without an explicit PARALLEL hint
+// can be stranded automatically once they are seen to be expensive (see QueryOptions::autoStrandThreshold).
+// The decision is made once per factory, and only affects activities created after it has been made.
+
+class StrandCostTracker : public CInterface
+{
+    friend class StrandCostTrackerTest;
+    static constexpr unsigned minExecutions = 4;
+    static constexpr unsigned minBlockSize = 16;
+public:
+    void noteExecution(cycle_t cycles, unsigned rows, const QueryOptions &options)
+    {
+        if (decided.load(std::memory_order_acquire))
+            return;
+        totalCycles += cycles;
+        totalRows += rows;
+        unsigned numExecutions = ++executions;
+        if (numExecutions < minExecutions)
+            return;
+
+        unsigned __int64 averageMs = cycle_to_millisec(totalCycles) / numExecutions;
+        if (averageMs < options.autoStrandThreshold)
+            return;
+
+        CriticalBlock b(crit);
+        if (decided.load(std::memory_order_relaxed))
+            return;
+        unsigned __int64 averageRows = totalRows / numExecutions;
+        unsigned maxStrands = getAffinityCpus();
+        if (maxStrands > MAX_SENSIBLE_STRANDS)
+            maxStrands = MAX_SENSIBLE_STRANDS;
+        if (averageRows / minBlockSize < maxStrands)
+            maxStrands = (unsigned)(averageRows / minBlockSize);
+        if (maxStrands > 1)
+        {
+            // Aim for several blocks per strand so the work stays balanced, but never exceed the configured block size
+            unsigned __int64 size = averageRows / (maxStrands * 4);
+            if (size < minBlockSize)
+                size = minBlockSize;
+            else if (options.strandBlockSize && size > options.strandBlockSize)
+                size = options.strandBlockSize;
+            autoBlockSize = (unsigned) size;
+            autoStrands = maxStrands;
+        }
+        decided.store(true, std::memory_order_release);
+    }
+
+    inline unsigned queryAutoStrands() const { return decided.load(std::memory_order_acquire) ? autoStrands : 0; }
+    inline unsigned queryAutoBlockSize() const { return autoBlockSize; }
+
+private:
+    CriticalSection crit;
+    RelaxedAtomic<cycle_t> totalCycles{0};
+    RelaxedAtomic<unsigned __int64> totalRows{0};
+    RelaxedAtomic<unsigned> executions{0};
+    std::atomic<bool> decided{false};
+    unsigned autoStrands = 0;
+    unsigned autoBlockSize = 0;
+};
+
 class StrandOptions
 {
     // Typically set from hints, common to many stranded activities
@@ -2014,20 +2074,31 @@ public:
         if ((numStrands == minus1U) || (numStrands > MAX_SENSIBLE_STRANDS))
             numStrands = getAffinityCpus();
         blockSize = _graphNode.getPropInt("hint[@name='strandblocksize']/@value", 0);
+        if (numStrands == 0)
+            costs.setown(new StrandCostTracker);
     }
     StrandOptions(const StrandOptions &from, IRoxieAgentContext *ctx)
     {
         numStrands = from.numStrands;
         blockSize = from.blockSize;
 
+        const QueryOptions &options = ctx->queryOptions();
+        if ((numStrands == 0) && (options.forceNumStrands == 0) && options.autoStrandThreshold && from.costs)
+        {
+            costs.set(from.costs);
+            numStrands = costs->queryAutoStrands();
+            if (numStrands && !blockSize)
+                blockSize = costs->queryAutoBlockSize();
+        }
         if (!blockSize)
-            blockSize = ctx->queryOptions().strandBlockSize;
+            blockSize = options.strandBlockSize;
         if (numStrands == 0)
-            numStrands = ctx->queryOptions().forceNumStrands;
+            numStrands = options.forceNumStrands;
     }
 public:
     unsigned numStrands = 0; // if 1 it forces single-stranded operations.  (Useful for testing.)
     unsigned blockSize = 0;
+    Linked<StrandCostTracker> costs;    // only set if the number of strands may be chosen automatically
 };
 
 class StrandProcessor : public CInterfaceOf<IEngineRowStream>
@@ -2107,6 +2178,8 @@ protected:
     Owned<IStrandJunction> splitter;
     Owned<IStrandJunction> sourceJunction; // A junction applied to the output of a source activity
     std::atomic<unsigned> active;
+    cycle_t lastLocalCycles = 0;
+    unsigned lastTotalRows = 0;
 public:
     CRoxieServerStrandedActivity(IRoxieAgentContext *_ctx, const IRoxieServerActivityFactory *_factory, IProbeManager *_probeManager, const StrandOptions &_strandOptions)
         : CRoxieServerActivity(_ctx, _factory, _probeManager),
@@ -2136,6 +2209,16 @@ public:
     virtual void reset()
     {
         assertex(active==0);
+        if (strandOptions.costs)
+        {
+            // Only the time spent in this activity - the cost model is per activity, not for the whole input chain
+            cycle_t localCycles = queryLocalCycles();
+            unsigned totalRows = getTotalRowsProcessed();
+            cycle_t elapsed = (localCycles > lastLocalCycles) ? localCycles - lastLocalCycles : 0;
+            strandOptions.costs->noteExecution(elapsed, totalRows - lastTotalRows, ctx->queryOptions());
+            lastLocalCycles = localCycles;
+            lastTotalRows = totalRows;
+        }
         CRoxieServerActivity::reset();
 
         //Stats have already been merged into the stranded activity when the strands were stopped.
@@ -8594,6 +8677,8 @@ public:
             sortAlgorithm = (sortFlags & TAFspill) ? spillingMergeSortAlgorithm : mergeSortAlgorithm;
         else if (stricmp(algorithmName, "parmergesort")==0)
             sortAlgorithm = (sortFlags & TAFspill) ? spillingParallelMergeSortAlgorithm : parallelMergeSortAlgorithm;
+        else if (stricmp(algorithmName, "radixsort")==0)
+            sortAlgorithm = (sortFlags & TAFspill) ? stableSpillingQuickSortAlgorithm : radixSortAlgorithm;
 #ifdef _USE_TBB
         else if (stricmp(algorithmName, "tbbqsort")==0)
             sortAlgorithm = tbbQuickSortAlgorithm;
@@ -12568,6 +12653,7 @@ public:
             buildUserMetadata(metadata);
             buildLayoutMetadata(metadata);
             unsigned nodeSize = metadata->getPropInt("_nodeSize", NODESIZE);
+            flags = applyLeafCompression(flags, metadata->queryProp("_leafCompression"));
             if (metadata->getPropBool("_noSeek", ctx->queryOptions().noSeekBuildIndex))
             {
                 flags |= TRAILING_HEADER_ONLY;
@@ -29267,4 +29353,133 @@ protected:
 CPPUNIT_TEST_SUITE_REGISTRATION( CcdServerTest );
 CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( CcdServerTest, "CcdServerTest" );
 
+class StrandCostTrackerTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( StrandCostTrackerTest );
+        CPPUNIT_TEST(testThreshold);
+        CPPUNIT_TEST(testMinExecutions);
+        CPPUNIT_TEST(testFewRows);
+        CPPUNIT_TEST(testStrandLimit);
+        CPPUNIT_TEST(testBlockSize);
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr unsigned minExecutions = StrandCostTracker::minExecutions;
+    static constexpr unsigned minBlockSize = StrandCostTracker::minBlockSize;
+
+    static cycle_t ms(unsigned msecs) { return nanosec_to_cycle((__int64) msecs * 1000000); }
+
+    // The most strands that could be chosen for averageRows rows per execution on this machine
+    static unsigned expectedStrands(unsigned __int64 averageRows)
+    {
+        unsigned maxStrands = getAffinityCpus();
+        if (maxStrands > MAX_SENSIBLE_STRANDS)
+            maxStrands = MAX_SENSIBLE_STRANDS;
+        if (averageRows / minBlockSize < maxStrands)
+            maxStrands = (unsigned)(averageRows / minBlockSize);
+        return maxStrands > 1 ? maxStrands : 0;
+    }
+
+    static QueryOptions createOptions(unsigned threshold, unsigned blockSize)
+    {
+        QueryOptions options;
+        options.autoStrandThreshold = threshold;
+        options.strandBlockSize = blockSize;
+        return options;
+    }
+
+protected:
+    void testThreshold()
+    {
+        QueryOptions options = createOptions(50, 0);
+        Owned<StrandCostTracker> cheap = new StrandCostTracker;
+        for (unsigned i = 0; i < 100; i++)
+            cheap->noteExecution(ms(10), 100000, options);
+        ASSERT(cheap->queryAutoStrands() == 0);
+
+        Owned<StrandCostTracker> expensive = new StrandCostTracker;
+        for (unsigned i = 0; i < minExecutions; i++)
+            expensive->noteExecution(ms(100), 100000, options);
+        ASSERT(expensive->queryAutoStrands() == expectedStrands(100000));
+
+        // The threshold applies to the average, so a single expensive execution among cheap ones does not qualify
+        Owned<StrandCostTracker> mixed = new StrandCostTracker;
+        mixed->noteExecution(ms(120), 100000, options);
+        for (unsigned i = 1; i < minExecutions; i++)
+            mixed->noteExecution(ms(10), 100000, options);
+        ASSERT(mixed->queryAutoStrands() == 0);
+    }
+
+    void testMinExecutions()
+    {
+        if (expectedStrands(100000) == 0)
+            return;     // single cpu - stranding is never chosen
+        QueryOptions options = createOptions(50, 0);
+        Owned<StrandCostTracker> tracker = new StrandCostTracker;
+        for (unsigned i = 1; i < minExecutions; i++)
+        {
+            tracker->noteExecution(ms(1000), 100000, options);
+            ASSERT(tracker->queryAutoStrands() == 0);
+        }
+        tracker->noteExecution(ms(1000), 100000, options);
+        unsigned strands = tracker->queryAutoStrands();
+        ASSERT(strands == expectedStrands(100000));
+
+        // Once made, the decision does not change
+        for (unsigned i = 0; i < 10; i++)
+            tracker->noteExecution(ms(1000), 20, options);
+        ASSERT(tracker->queryAutoStrands() == strands);
+    }
+
+    void testFewRows()
+    {
+        // Too few rows per execution to give each strand a minimum sized block - stays single stranded
+        QueryOptions options = createOptions(50, 0);
+        Owned<StrandCostTracker> tracker = new StrandCostTracker;
+        for (unsigned i = 0; i < minExecutions; i++)
+            tracker->noteExecution(ms(1000), minBlockSize * 2 - 1, options);
+        ASSERT(tracker->queryAutoStrands() == 0);
+    }
+
+    void testStrandLimit()
+    {
+        // The number of strands is limited by the rows available, and the block size never falls below the minimum
+        QueryOptions options = createOptions(50, 0);
+        Owned<StrandCostTracker> tracker = new StrandCostTracker;
+        for (unsigned i = 0; i < minExecutions; i++)
+            tracker->noteExecution(ms(1000), minBlockSize * 3, options);
+        unsigned strands = tracker->queryAutoStrands();
+        ASSERT(strands == expectedStrands(minBlockSize * 3));
+        ASSERT(strands <= 3);
+        if (strands)
+            ASSERT(tracker->queryAutoBlockSize() == minBlockSize);
+    }
+
+    void testBlockSize()
+    {
+        const unsigned __int64 rows = 1000000;
+        unsigned strands = expectedStrands(rows);
+        if (!strands)
+            return;
+
+        // Several blocks per strand...
+        QueryOptions unlimited = createOptions(50, 0);
+        Owned<StrandCostTracker> tracker = new StrandCostTracker;
+        for (unsigned i = 0; i < minExecutions; i++)
+            tracker->noteExecution(ms(1000), rows, unlimited);
+        ASSERT(tracker->queryAutoStrands() == strands);
+        ASSERT(tracker->queryAutoBlockSize() == rows / (strands * 4));
+
+        // ...but never more than the configured block size
+        QueryOptions limited = createOptions(50, 512);
+        Owned<StrandCostTracker> capped = new StrandCostTracker;
+        for (unsigned i = 0; i < minExecutions; i++)
+            capped->noteExecution(ms(1000), rows, limited);
+        ASSERT(capped->queryAutoStrands() == strands);
+        ASSERT(capped->queryAutoBlockSize() == 512);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( StrandCostTrackerTest );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( StrandCostTrackerTest, "StrandCostTrackerTest" );
+
 #endif
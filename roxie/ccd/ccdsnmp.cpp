@@ -61,6 +61,8 @@ RelaxedAtomic<unsigned> postFiltered;
 RelaxedAtomic<unsigned> abortsSent;
 RelaxedAtomic<unsigned> activitiesStarted;
 RelaxedAtomic<unsigned> activitiesCompleted;
+RelaxedAtomic<unsigned> resultCacheHits;
+RelaxedAtomic<unsigned> resultCacheAdds;
 RelaxedAtomic<unsigned> diskReadStarted;
 RelaxedAtomic<unsigned> diskReadCompleted;
 RelaxedAtomic<unsigned> globalSignals;
@@ -375,6 +377,8 @@ CRoxieMetricsManager::CRoxieMetricsManager()
     addMetric(abortsSent, 0);
     addMetric(activitiesStarted, 1000);
     addMetric(activitiesCompleted, 1000);
+    addMetric(resultCacheHits, 1000);
+    addMetric(resultCacheAdds, 1000);
     addMetric(diskReadStarted, 0);
     addMetric(diskReadCompleted, 0);
     addMetric(globalSignals, 0);
@@ -394,6 +398,9 @@ CRoxieMetricsManager::CRoxieMetricsManager()
     addMetric(nodeCacheHits, 1000);
     addMetric(nodeCacheAdds, 1000);
     addMetric(nodeCacheDups, 1000);
+    addMetric(nodeCacheContention, 1000);
+    addMetric(leafCacheContention, 1000);
+    addMetric(blobCacheContention, 1000);
 
     addMetric(unwantedDiscarded, 1000);
 
@@ -108,6 +108,8 @@ extern RelaxedAtomic<unsigned> postFiltered;
 extern RelaxedAtomic<unsigned> abortsSent;
 extern RelaxedAtomic<unsigned> activitiesStarted;
 extern RelaxedAtomic<unsigned> activitiesCompleted;
+extern RelaxedAtomic<unsigned> resultCacheHits;
+extern RelaxedAtomic<unsigned> resultCacheAdds;
 extern RelaxedAtomic<unsigned> diskReadStarted;
 extern RelaxedAtomic<unsigned> diskReadCompleted;
 extern RelaxedAtomic<unsigned> globalSignals;
@@ -2211,6 +2211,8 @@ private:
         if (autoPending.load() == 0)
         {
             clearKeyStoreCache(false);   // Allows us to fully release files we no longer need because of unloaded queries
+            if (resultCache)
+                resultCache->clear();
             daliHelper->commitCache();
         }
     }
@@ -2318,6 +2320,8 @@ private:
             {
                 bool clearAll = control->getPropBool("@clearAll", true);
                 clearKeyStoreCache(clearAll);
+                if (resultCache)
+                    resultCache->clear();
             }
             else if (stricmp(queryName, "control:closedown")==0)
             {
@@ -2627,6 +2631,12 @@ private:
                 topology->setPropInt("@nodeCacheMem", nodeCacheMB);
                 setNodeCacheMem(nodeCacheMB * 0x100000);
             }
+            else if (stricmp(queryName, "control:nodeCacheShards")==0)
+            {
+                unsigned nodeCacheShards = control->getPropInt("@val", 1);
+                topology->setPropInt("@nodeCacheShards", nodeCacheShards);
+                setNodeCacheShards(nodeCacheShards);
+            }
             else if (stricmp(queryName, "control:numFilesToProcess")==0)
             { 
                 int numFiles = queryFileCache().numFilesToCopy();
@@ -2845,6 +2855,7 @@ private:
             {
                 StringBuffer memStats;
                 queryMemoryPoolStats(memStats);
+                getNodeMemoryStats(memStats);
                 reply.append("<MemoryStats>").append(memStats.str()).append("</MemoryStats>\n");
             }
             else
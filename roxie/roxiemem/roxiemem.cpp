@@ -35,6 +35,15 @@
 # endif
 #endif
 
+#ifdef _USE_NUMA
+#include <numa.h>
+#include <sched.h>
+#if defined(LIBNUMA_API_VERSION) && (LIBNUMA_API_VERSION>=2)
+//Partition the heap between the numa nodes the process can run on
+#define NUMA_AWARE_HEAP
+#endif
+#endif
+
 #if defined(_USE_TBB)
  //Only enable for TBB >=3 because code had problems with spawn as a non static function (see HPC-14588)
  #if defined(TBB_VERSION_MAJOR)
@@ -183,6 +192,25 @@ static unsigned heapAllocated;
 static std::atomic_uint dataBufferPages;
 static std::atomic_uint dataBuffersActive;
 
+//If the process can run on more than one numa node the heap is split into one region per node.  Each region is a whole
+//number of bitmap words, is bound to its node, and has its own low water mark.  Single page allocations (which supply
+//all the chunked heaplets) are satisfied from the region local to the allocating thread, falling back to the other
+//regions when it is exhausted.  Multi-page allocations ignore the regions.
+struct HeapNumaRegion
+{
+    unsigned node;
+    unsigned firstWord;
+    unsigned endWord;
+    unsigned lwm;
+};
+static unsigned heapNumaRegions = 1;
+static unsigned heapNumaWordsPerRegion;
+static HeapNumaRegion * heapRegions;
+#ifdef NUMA_AWARE_HEAP
+static unsigned heapNumCpus;
+static byte * heapCpuToRegion;
+#endif
+
 const unsigned HEAP_BITS = sizeof(heap_t) * 8;
 const heap_t HEAP_ALLBITS = (heap_t) -1;
 const heap_t TOPBITMASK = ((heap_t)1U)<<(HEAP_BITS-1);
@@ -308,6 +336,150 @@ extern bool getRoxieMemLocked()
 
 //---------------------------------------------------------------------------------------------------------------------
 
+static void releaseHeapNumaRegions()
+{
+    delete [] heapRegions;
+    heapRegions = nullptr;
+    heapNumaRegions = 1;
+    heapNumaWordsPerRegion = 0;
+#ifdef NUMA_AWARE_HEAP
+    delete [] heapCpuToRegion;
+    heapCpuToRegion = nullptr;
+    heapNumCpus = 0;
+#endif
+}
+
+static void initializeHeapNumaRegions(bool bindMemory)
+{
+    releaseHeapNumaRegions();
+#ifdef NUMA_AWARE_HEAP
+    if (numa_available() == -1)
+        return;
+
+    //Only use the nodes this process can both run on and allocate memory from - thor slaves may already have been
+    //bound to a single node, in which case there is nothing to partition.
+    unsigned numNodes = 0;
+    unsigned nodeMap[NUMA_NUM_NODES];
+    struct bitmask * runNodes = numa_get_run_node_mask();
+    struct bitmask * memNodes = numa_get_membind();
+    unsigned maxNode = numa_max_node();
+    for (unsigned node=0; node <= maxNode && node < NUMA_NUM_NODES; node++)
+    {
+        if (numa_bitmask_isbitset(runNodes, node) && numa_bitmask_isbitset(memNodes, node))
+            nodeMap[numNodes++] = node;
+    }
+    numa_bitmask_free(memNodes);
+    numa_bitmask_free(runNodes);
+
+    if (numNodes > heapBitmapSize)
+        numNodes = heapBitmapSize;
+    if (numNodes <= 1)
+        return;
+
+    heapNumaRegions = numNodes;
+    heapNumaWordsPerRegion = heapBitmapSize / numNodes;
+    heapRegions = new HeapNumaRegion[numNodes];
+    for (unsigned region=0; region < numNodes; region++)
+    {
+        HeapNumaRegion & cur = heapRegions[region];
+        cur.node = nodeMap[region];
+        cur.firstWord = region * heapNumaWordsPerRegion;
+        cur.endWord = (region+1 == numNodes) ? heapBitmapSize : cur.firstWord + heapNumaWordsPerRegion;
+        cur.lwm = cur.firstWord;
+        if (bindMemory)
+        {
+            //Called before any of the memory has been touched, so the pages will be faulted in on the correct node
+            char * start = heapBase + (memsize_t)cur.firstWord * heapBlockSize;
+            memsize_t len = (memsize_t)(cur.endWord - cur.firstWord) * heapBlockSize;
+            numa_tonode_memory(start, len, cur.node);
+        }
+    }
+
+    heapNumCpus = numa_num_configured_cpus();
+    heapCpuToRegion = new byte[heapNumCpus];
+    for (unsigned cpu=0; cpu < heapNumCpus; cpu++)
+    {
+        int node = numa_node_of_cpu(cpu);
+        byte match = 0;
+        for (unsigned region=0; region < numNodes; region++)
+        {
+            if ((int)heapRegions[region].node == node)
+            {
+                match = (byte)region;
+                break;
+            }
+        }
+        heapCpuToRegion[cpu] = match;
+    }
+
+    if (memTraceLevel)
+        DBGLOG("RoxieMemMgr: Heap partitioned between %u numa nodes", numNodes);
+#endif
+}
+
+#ifdef _USE_CPPUNIT
+static void clipHeapNumaRegions()
+{
+    //The region boundaries must not move - the memory has already been bound to the nodes - so drop any regions that
+    //are now beyond the end of the heap and adjust the end of the last one.
+    if (heapNumaRegions <= 1)
+        return;
+    while ((heapNumaRegions > 1) && (heapRegions[heapNumaRegions-1].firstWord >= heapBitmapSize))
+        heapNumaRegions--;
+    HeapNumaRegion & last = heapRegions[heapNumaRegions-1];
+    last.endWord = heapBitmapSize;
+    if (last.lwm > last.endWord)
+        last.lwm = last.endWord;
+}
+#endif
+
+static inline unsigned queryLocalHeapRegion()
+{
+#ifdef NUMA_AWARE_HEAP
+    int cpu = sched_getcpu();
+    if ((unsigned)cpu < heapNumCpus)
+        return heapCpuToRegion[cpu];
+#endif
+    return 0;
+}
+
+static inline unsigned getHeapRegion(unsigned wordOffset)
+{
+    unsigned region = wordOffset / heapNumaWordsPerRegion;
+    return (region < heapNumaRegions) ? region : heapNumaRegions-1;
+}
+
+static char * suballocRegionPage(HeapNumaRegion & region)
+{
+    // NOTE heapBitCrit MUST be held while here
+    for (unsigned i = region.lwm; i < region.endWord; i++)
+    {
+        heap_t hbi = heapBitmap[i];
+        if (hbi)
+        {
+            const unsigned pos = countTrailingUnsetBits(hbi);
+            hbi &= ~(((heap_t)1U) << pos);
+            heapBitmap[i] = hbi;
+            region.lwm = (hbi == 0) ? i+1 : i;
+            return heapBase + (i*HEAP_BITS + pos)*HEAP_ALIGNMENT_SIZE;
+        }
+    }
+    region.lwm = region.endWord;
+    return nullptr;
+}
+
+static void noteRegionPagesFreed(unsigned firstWord, unsigned lastWord)
+{
+    // NOTE heapBitCrit MUST be held while here
+    for (unsigned region = getHeapRegion(firstWord); region <= getHeapRegion(lastWord); region++)
+    {
+        HeapNumaRegion & cur = heapRegions[region];
+        unsigned word = (firstWord > cur.firstWord) ? firstWord : cur.firstWord;
+        if (word < cur.lwm)
+            cur.lwm = word;
+    }
+}
+
 typedef MapBetween<unsigned, unsigned, memsize_t, memsize_t> MapActivityToMemsize;
 
 static void initializeHeap(bool allowHugePages, bool allowTransparentHugePages, bool retainMemory, bool lockMemory, memsize_t pages, memsize_t largeBlockGranularity, ILargeMemCallback * largeBlockCallback)
@@ -472,6 +644,7 @@ static void initializeHeap(bool allowHugePages, bool allowTransparentHugePages,
     assertex(((memsize_t)heapBase & (HEAP_ALIGNMENT_SIZE-1)) == 0);
 
     heapEnd = heapBase + memsize;
+    initializeHeapNumaRegions(true);
 
     if (heapNotifyUnusedEachFree)
     {
@@ -520,6 +693,7 @@ static void adjustHeapSize(unsigned numPages)
     heapEnd = heapBase + memsize;
     heapBitmapSize = (unsigned)bitmapSize;
     heapTotalPages = (unsigned)totalPages;
+    clipHeapNumaRegions();
     if (wasLocked)
         lockRoxieMem(true);
 }
@@ -535,6 +709,7 @@ extern void releaseRoxieHeap()
             lockRoxieMem(false);
         delete [] heapBitmap;
         heapBitmap = NULL;
+        releaseHeapNumaRegions();
 #ifdef _WIN32
         VirtualFree(heapBase, 0, MEM_RELEASE);
 #else
@@ -675,7 +850,30 @@ extern StringBuffer &memstats(StringBuffer &stats)
     unsigned freePages;
     unsigned maxBlock;
     memstats(totalPages, freePages, maxBlock);
-    return stats.appendf("Heap size %u pages, %u free, largest block %u", heapTotalPages, freePages, maxBlock);
+    stats.appendf("Heap size %u pages, %u free, largest block %u", heapTotalPages, freePages, maxBlock);
+    if (heapNumaRegions > 1)
+    {
+        CriticalBlock b(heapBitCrit);
+        for (unsigned region = 0; region < heapNumaRegions; region++)
+        {
+            const HeapNumaRegion & cur = heapRegions[region];
+            unsigned regionFree = 0;
+            for (unsigned i = cur.firstWord; i < cur.endWord; i++)
+            {
+                heap_t t = heapBitmap[i];
+                if (t==HEAP_ALLBITS)
+                    regionFree += HEAP_BITS;
+                else
+                {
+                    for (; t; t &= (t-1))
+                        regionFree++;
+                }
+            }
+            unsigned regionPages = (cur.endWord - cur.firstWord) * HEAP_BITS;
+            stats.appendf(", node %u: %u/%u pages used", cur.node, regionPages - regionFree, regionPages);
+        }
+    }
+    return stats;
 }
 
 #ifdef _USE_CPPUNIT
@@ -813,6 +1011,7 @@ static void *suballoc_aligned(size32_t pages, bool returnNullWhenExhausted)
             DBGLOG("RoxieMemMgr: %s", s.str());
         }
     }
+    const unsigned localRegion = (pages == 1) ? queryLocalHeapRegion() : 0;
     CriticalBlock b(heapBitCrit);
     if (heapAllocated + pages > heapTotalPages) {
         if (returnNullWhenExhausted)
@@ -842,7 +1041,25 @@ static void *suballoc_aligned(size32_t pages, bool returnNullWhenExhausted)
         }
     }
 
-    if (pages == 1)
+    if ((pages == 1) && (heapNumaRegions > 1))
+    {
+        //Try the region local to this thread first, then the others
+        for (unsigned delta = 0; delta < heapNumaRegions; delta++)
+        {
+            unsigned region = localRegion + delta;
+            if (region >= heapNumaRegions)
+                region -= heapNumaRegions;
+            char *ret = suballocRegionPage(heapRegions[region]);
+            if (ret)
+            {
+                heapAllocated++;
+                if (memTraceLevel >= 2)
+                    DBGLOG("RoxieMemMgr: suballoc_aligned() 1 page ok - addr=%p node=%u", ret, heapRegions[region].node);
+                return ret;
+            }
+        }
+    }
+    else if (pages == 1)
     {
         unsigned i;
         for (i = heapLWM; i < heapBitmapSize; i++)
@@ -1028,6 +1245,9 @@ static bool subfree_aligned(void *ptr, unsigned pages = 1)
         if (wordOffset >= heapHWM)
             heapHWM = wordOffset+1;
 
+        if (heapNumaRegions > 1)
+            noteRegionPagesFreed((unsigned)(pageOffset / HEAP_BITS), wordOffset);
+
         if (firstReleaseBlock)
             notifyMemoryUnused(firstReleaseBlock, (lastReleaseBlock - firstReleaseBlock) + heapBlockSize);
     }
@@ -7157,6 +7377,7 @@ class RoxieMemTests : public CppUnit::TestFixture
         CPPUNIT_TEST(testRoundup);
         CPPUNIT_TEST(testCompressSize);
         CPPUNIT_TEST(testBitmap);
+        CPPUNIT_TEST(testNumaRegions);
         CPPUNIT_TEST(testAllocSize);
         CPPUNIT_TEST(testReleaseAll);
         CPPUNIT_TEST(testHuge);
@@ -7277,9 +7498,30 @@ protected:
             _heapUseHugePages = heapUseHugePages;
             _heapNotifyUnusedEachFree = heapNotifyUnusedEachFree;
             _heapNotifyUnusedEachBlock = heapNotifyUnusedEachBlock;
+            _heapNumaRegions = heapNumaRegions;
+            _heapNumaWordsPerRegion = heapNumaWordsPerRegion;
+            _heapRegions = heapRegions;
+#ifdef NUMA_AWARE_HEAP
+            _heapNumCpus = heapNumCpus;
+            _heapCpuToRegion = heapCpuToRegion;
+            heapNumCpus = 0;
+            heapCpuToRegion = nullptr;
+#endif
+            //Tests run with a single region unless they explicitly create their own
+            heapNumaRegions = 1;
+            heapNumaWordsPerRegion = 0;
+            heapRegions = nullptr;
         }
         ~HeapPreserver()
         {
+            releaseHeapNumaRegions();
+            heapNumaRegions = _heapNumaRegions;
+            heapNumaWordsPerRegion = _heapNumaWordsPerRegion;
+            heapRegions = _heapRegions;
+#ifdef NUMA_AWARE_HEAP
+            heapNumCpus = _heapNumCpus;
+            heapCpuToRegion = _heapCpuToRegion;
+#endif
             heapBase = _heapBase;
             heapEnd = _heapEnd;
             heapBitmap = _heapBitmap;
@@ -7303,6 +7545,13 @@ protected:
         bool _heapUseHugePages;
         bool _heapNotifyUnusedEachFree;
         bool _heapNotifyUnusedEachBlock;
+        unsigned _heapNumaRegions;
+        unsigned _heapNumaWordsPerRegion;
+        HeapNumaRegion * _heapRegions;
+#ifdef NUMA_AWARE_HEAP
+        unsigned _heapNumCpus;
+        byte * _heapCpuToRegion;
+#endif
     };
     void initBitmap(unsigned size)
     {
@@ -7414,6 +7663,65 @@ protected:
         delete[] heapBitmap;
     }
 
+    void testNumaRegions()
+    {
+        HeapPreserver preserver;
+
+        //Simulate a heap split between two numa nodes, each with two bitmap words
+        const unsigned bitmapSize = 4;
+        const unsigned wordsPerRegion = 2;
+        initBitmap(bitmapSize);
+        heapNumaRegions = 2;
+        heapNumaWordsPerRegion = wordsPerRegion;
+        heapRegions = new HeapNumaRegion[2];
+        for (unsigned region=0; region < 2; region++)
+        {
+            HeapNumaRegion & cur = heapRegions[region];
+            cur.node = region;
+            cur.firstWord = region * wordsPerRegion;
+            cur.endWord = cur.firstWord + wordsPerRegion;
+            cur.lwm = cur.firstWord;
+        }
+
+        //No cpu mapping, so single pages come from region 0 until it is exhausted, then from region 1
+        memsize_t minAddr = 0x80000000;
+        memsize_t maxAddr = minAddr + bitmapSize * HEAP_BITS * HEAP_ALIGNMENT_SIZE;
+        const unsigned regionPages = wordsPerRegion * HEAP_BITS;
+        unsigned i;
+        for (i=0; i < regionPages; i++)
+            ASSERT(suballoc_aligned(1, false)==(void *)(memsize_t)(minAddr + HEAP_ALIGNMENT_SIZE*i));
+        ASSERT(heapRegions[0].lwm == wordsPerRegion);
+        ASSERT(suballoc_aligned(1, false)==(void *)(memsize_t)(minAddr + HEAP_ALIGNMENT_SIZE*regionPages));
+        ASSERT(heapRegions[1].lwm == wordsPerRegion);
+
+        //Freeing a page lowers the low water mark of its own region only
+        subfree_aligned((void *)(memsize_t)(minAddr + HEAP_ALIGNMENT_SIZE*5), 1);
+        ASSERT(heapRegions[0].lwm == 0);
+        ASSERT(heapRegions[1].lwm == wordsPerRegion);
+        ASSERT(suballoc_aligned(1, false)==(void *)(memsize_t)(minAddr + HEAP_ALIGNMENT_SIZE*5));
+
+        //Multi-page allocations ignore the regions
+        ASSERT(suballoc_aligned(3, false)==(void *)(memsize_t)(maxAddr - 3*HEAP_ALIGNMENT_SIZE));
+        subfree_aligned((void *)(memsize_t)(maxAddr - 3*HEAP_ALIGNMENT_SIZE), 3);
+
+        //A page freed in the second region is found again once the first is full
+        subfree_aligned((void *)(memsize_t)(minAddr + HEAP_ALIGNMENT_SIZE*regionPages), 1);
+        ASSERT(heapRegions[1].lwm == wordsPerRegion);
+        ASSERT(suballoc_aligned(1, false)==(void *)(memsize_t)(minAddr + HEAP_ALIGNMENT_SIZE*regionPages));
+
+        //Shrinking the heap must keep the region boundaries and only clip the end of the heap
+        adjustHeapSize(3 * HEAP_BITS);
+        ASSERT(heapNumaRegions == 2);
+        ASSERT(heapRegions[0].firstWord == 0 && heapRegions[0].endWord == wordsPerRegion);
+        ASSERT(heapRegions[1].firstWord == wordsPerRegion && heapRegions[1].endWord == 3);
+        adjustHeapSize(HEAP_BITS);
+        ASSERT(heapNumaRegions == 1);
+        ASSERT(heapRegions[0].firstWord == 0 && heapRegions[0].endWord == 1);
+        ASSERT(heapRegions[0].lwm <= 1);
+
+        delete[] heapBitmap;
+    }
+
 #ifdef __64BIT__
     //Testing allocating bits that represent 1Tb of memory.  With 256K pages, that is simulating 4M pages.
     enum { maxBitmapThreads = 20, maxBitmapSize = (unsigned)(I64C(0xFFFFFFFFFF) / HEAP_ALIGNMENT_SIZE / HEAP_BITS) };      // Test larger range - in case we ever reduce the granularity
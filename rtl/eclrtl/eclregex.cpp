@@ -24,6 +24,10 @@
 #include "platform.h"
 #include "eclrtl.hpp"
 #include "eclrtl_imp.hpp"
+#include "jlib.hpp"
+#include "jmutex.hpp"
+#include <list>
+#include <unordered_map>
 #ifdef _USE_ICU
 #include "unicode/regex.h"
 #endif
@@ -49,6 +53,144 @@ using std::cmatch;
 using std::match_results;
 #endif
 
+//---------------------------------------------------------------------------
+
+// Compiled patterns are immutable, so they are shared between all the users of the same expression.  Generated
+// code recompiles a non-constant pattern each time it changes, so keep the most recently used ones around.
+
+#define REGEX_CACHE_SIZE 256
+
+template <class PATTERN>
+class CRegExprCache
+{
+    typedef std::list<std::pair<std::string, Linked<PATTERN>>> MruList;
+
+public:
+    PATTERN * lookup(const std::string & key)
+    {
+        CriticalBlock block(crit);
+        auto match = map.find(key);
+        if (match == map.end())
+            return nullptr;
+        mru.splice(mru.begin(), mru, match->second);
+        return match->second->second.getLink();
+    }
+
+    // Takes ownership of pattern, returns a link to the cached entry (which may have been added by another thread)
+    PATTERN * add(const std::string & key, PATTERN * pattern)
+    {
+        Owned<PATTERN> compiled(pattern);
+        CriticalBlock block(crit);
+        auto match = map.find(key);
+        if (match != map.end())
+        {
+            mru.splice(mru.begin(), mru, match->second);
+            return match->second->second.getLink();
+        }
+        mru.emplace_front(key, compiled);
+        map.emplace(key, mru.begin());
+        while (mru.size() > REGEX_CACHE_SIZE)
+        {
+            map.erase(mru.back().first);
+            mru.pop_back();
+        }
+        return compiled.getClear();
+    }
+
+private:
+    CriticalSection crit;
+    MruList mru;
+    std::unordered_map<std::string, typename MruList::iterator> map;
+};
+
+//---------------------------------------------------------------------------
+
+// A pattern that only contains literal characters can be matched with a simple substring search, avoiding the regex
+// engine entirely.  Escaped punctuation is allowed, anything else (classes, anchors, repeats, backreferences) is not.
+static bool extractRegExprLiteral(std::string & literal, const char * pattern, bool isCaseSensitive)
+{
+    for (const char * cur = pattern; *cur; cur++)
+    {
+        byte next = (byte)*cur;
+        switch (next)
+        {
+        case '.': case '[': case ']': case '{': case '}': case '(': case ')':
+        case '*': case '+': case '?': case '|': case '^': case '$':
+            return false;
+        case '\\':
+            next = (byte)cur[1];
+            if (!next || isalnum(next) || (next >= 0x80))
+                return false;
+            cur++;
+            break;
+        }
+        //Case insensitive matching only takes the fast path if case is irrelevant
+        if (!isCaseSensitive && (isalpha(next) || (next >= 0x80)))
+            return false;
+        literal += (char)next;
+    }
+    return !literal.empty();
+}
+
+static const char * findRegExprLiteral(const char * start, const char * end, const std::string & literal)
+{
+    const size_t litLen = literal.length();
+    const char * lit = literal.data();
+    while ((size_t)(end - start) >= litLen)
+    {
+        const char * next = (const char *)memchr(start, lit[0], (end - start) - litLen + 1);
+        if (!next)
+            return nullptr;
+        if (memcmp(next + 1, lit + 1, litLen - 1) == 0)
+            return next;
+        start = next + 1;
+    }
+    return nullptr;
+}
+
+class CStrRegExprPattern : public CInterface
+{
+public:
+    CStrRegExprPattern(const char * _regExp, bool _isCaseSensitive)
+    {
+        try
+        {
+#if defined(_USE_BOOST_REGEX)
+            if (_isCaseSensitive)
+                regEx.assign(_regExp, regex::perl);
+            else
+                regEx.assign(_regExp, regex::perl | regex::icase);
+#else
+            if (_isCaseSensitive)
+                regEx.assign(_regExp, regex::ECMAScript);
+            else
+                regEx.assign(_regExp, regex::ECMAScript | regex::icase);
+#endif
+        }
+#if defined(_USE_BOOST_REGEX)
+        catch(const boost::bad_expression & e)
+#else
+        catch(const std::regex_error & e)
+#endif
+        {
+            std::string msg = "Bad regular expression: ";
+            msg += e.what();
+            msg += ": ";
+            msg += _regExp;
+            rtlFail(0, msg.c_str());  //throws
+        }
+        isLiteral = extractRegExprLiteral(literal, _regExp, _isCaseSensitive);
+    }
+
+    regex regEx;
+    std::string literal;
+    bool isLiteral = false;
+};
+
+static CRegExprCache<CStrRegExprPattern> strRegExprCache;
+
+//---------------------------------------------------------------------------
+
 class CStrRegExprFindInstance : implements IStrRegExprFindInstance
 {
 private:
@@ -56,6 +198,8 @@ private:
     const regex * regEx;
     cmatch   subs;
     char *          sample; //only required if findstr/findvstr will be called
+    const char *    literalMatch = nullptr; //only used if the pattern is a simple literal
+    size32_t        literalLen = 0;
 
 public:
     CStrRegExprFindInstance(const regex * _regEx, const char * _str, size32_t _from, size32_t _len, bool _keep)
@@ -91,6 +235,25 @@ public:
 
     }
 
+    CStrRegExprFindInstance(const std::string & _literal, const char * _str, size32_t _from, size32_t _len, bool _keep)
+        : regEx(nullptr)
+    {
+        sample = NULL;
+        const char * start = _str + _from;
+        const char * end = _str + _len;
+        if (_keep)
+        {
+            sample = (char *)rtlMalloc(_len + 1);
+            memcpy(sample, _str + _from, _len);
+            sample[_len] = '\0';
+            start = sample;
+            end = sample + strlen(sample); // consistent with searching the null terminated sample above
+        }
+        literalMatch = findRegExprLiteral(start, end, _literal);
+        literalLen = _literal.length();
+        matched = (literalMatch != nullptr);
+    }
+
     ~CStrRegExprFindInstance() //CAVEAT non-virtual destructor !
     {
         free(sample);
@@ -102,11 +265,11 @@ public:
 
     void getMatchX(unsigned & outlen, char * & out, unsigned n = 0) const
     {
-        if (matched && (n < subs.size()))
+        const char * start;
+        if (getMatch(n, start, outlen))
         {
-            outlen = subs[n].second - subs[n].first;
             out = (char *)rtlMalloc(outlen);
-            memcpy_iflen(out, subs[n].first, outlen);
+            memcpy_iflen(out, start, outlen);
         }
         else
         {
@@ -117,12 +280,13 @@ public:
 
     char const * findvstr(unsigned outlen, char * out, unsigned n = 0)
     {
-        if (matched && (n < subs.size()))
+        const char * start;
+        unsigned sublen;
+        if (getMatch(n, start, sublen))
         {
-            unsigned sublen = subs[n].second - subs[n].first;
             if (sublen >= outlen)
                 sublen = outlen - 1;
-            memcpy(out, subs[n].first, sublen);
+            memcpy(out, start, sublen);
             out[sublen] = 0;
         }
         else
@@ -131,6 +295,27 @@ public:
         }
         return out;
     }
+
+private:
+    bool getMatch(unsigned n, const char * & start, unsigned & len) const
+    {
+        if (!matched)
+            return false;
+        if (literalMatch)
+        {
+            //A literal pattern has no sub-expressions
+            if (n != 0)
+                return false;
+            start = literalMatch;
+            len = literalLen;
+            return true;
+        }
+        if (n >= subs.size())
+            return false;
+        start = subs[n].first;
+        len = subs[n].second - subs[n].first;
+        return true;
+    }
 };
 
 //---------------------------------------------------------------------------
@@ -138,43 +323,25 @@ public:
 class CCompiledStrRegExpr : implements ICompiledStrRegExpr
 {
 private:
-    regex    regEx;
+    Linked<CStrRegExprPattern> pattern;
+    const regex & regEx;
 
 public:
-    CCompiledStrRegExpr(const char * _regExp, bool _isCaseSensitive = false)
+    CCompiledStrRegExpr(CStrRegExprPattern * _pattern) : pattern(_pattern), regEx(_pattern->regEx)
     {
-        try
-        {
-#if defined(_USE_BOOST_REGEX)
-            if (_isCaseSensitive)
-                regEx.assign(_regExp, regex::perl);
-            else
-                regEx.assign(_regExp, regex::perl | regex::icase);
-#else
-            if (_isCaseSensitive)
-                regEx.assign(_regExp, regex::ECMAScript);
-            else
-                regEx.assign(_regExp, regex::ECMAScript | regex::icase);
-#endif
-        }
-#if defined(_USE_BOOST_REGEX)
-        catch(const boost::bad_expression & e)
-#else
-        catch(const std::regex_error & e)
-#endif
-        {
-            std::string msg = "Bad regular expression: ";
-            msg += e.what();
-            msg += ": ";
-            msg += _regExp;
-            rtlFail(0, msg.c_str());  //throws
-        }
     }
 
     //ICompiledStrRegExpr
 
     void replace(size32_t & outlen, char * & out, size32_t slen, char const * str, size32_t rlen, char const * replace) const
     {
+        //Format strings only have special meaning if they contain $ (or \ for perl format)
+        if (pattern->isLiteral && !memchr(replace, '$', rlen) && !memchr(replace, '\\', rlen))
+        {
+            replaceLiteral(outlen, out, slen, str, rlen, replace);
+            return;
+        }
+
         std::string src(str, str + slen);
         std::string fmt(replace, replace + rlen);
         std::string tgt;
@@ -205,6 +372,8 @@ public:
 
     IStrRegExprFindInstance * find(const char * str, size32_t from, size32_t len, bool needToKeepSearchString) const
     {
+        if (pattern->isLiteral)
+            return new CStrRegExprFindInstance(pattern->literal, str, from, len, needToKeepSearchString);
         CStrRegExprFindInstance * findInst = new CStrRegExprFindInstance(&regEx, str, from, len, needToKeepSearchString);
         return findInst;
     }
@@ -215,34 +384,84 @@ public:
         size32_t outBytes = 0;
         const char * search_end = _search+_srcLen;
 
-        regex_iterator<const char *> cur(_search, search_end, regEx);
-        regex_iterator<const char *> end; // Default contructor creates an end of list marker
-        for (; cur != end; ++cur)
+        if (pattern->isLiteral)
         {
-            const match_results<const char *> &match = *cur;
-            if (match[0].first==search_end) break;
+            const std::string & literal = pattern->literal;
+            const size32_t lenBytes = literal.length();
+            const char * cur = _search;
+            while ((cur = findRegExprLiteral(cur, search_end, literal)) != nullptr)
+            {
+                out.ensureAvailable(outBytes+lenBytes+sizeof(size32_t));
+                byte *outData = out.getbytes()+outBytes;
 
-            const size32_t lenBytes = match[0].second - match[0].first;
-            out.ensureAvailable(outBytes+lenBytes+sizeof(size32_t));
-            byte *outData = out.getbytes()+outBytes;
+                * (size32_t *) outData = lenBytes;
+                memcpy(outData+sizeof(size32_t), literal.data(), lenBytes);
+
+                outBytes += lenBytes+sizeof(size32_t);
+                cur += lenBytes;
+            }
+        }
+        else
+        {
+            regex_iterator<const char *> cur(_search, search_end, regEx);
+            regex_iterator<const char *> end; // Default contructor creates an end of list marker
+            for (; cur != end; ++cur)
+            {
+                const match_results<const char *> &match = *cur;
+                if (match[0].first==search_end) break;
 
-            * (size32_t *) outData = lenBytes;
-            rtlStrToStr(lenBytes, outData+sizeof(size32_t), lenBytes, match[0].first);
+                const size32_t lenBytes = match[0].second - match[0].first;
+                out.ensureAvailable(outBytes+lenBytes+sizeof(size32_t));
+                byte *outData = out.getbytes()+outBytes;
 
-            outBytes += lenBytes+sizeof(size32_t);
+                * (size32_t *) outData = lenBytes;
+                rtlStrToStr(lenBytes, outData+sizeof(size32_t), lenBytes, match[0].first);
+
+                outBytes += lenBytes+sizeof(size32_t);
+            }
         }
         __isAllResult = false;
         __resultBytes = outBytes;
         __result = out.detachdata();
     };
 
+private:
+    void replaceLiteral(size32_t & outlen, char * & out, size32_t slen, char const * str, size32_t rlen, char const * replace) const
+    {
+        const std::string & literal = pattern->literal;
+        const size32_t litLen = literal.length();
+        const char * end = str + slen;
+        rtlRowBuilder tgt;
+        size32_t tgtLen = 0;
+        const char * cur = str;
+        for (;;)
+        {
+            const char * next = findRegExprLiteral(cur, end, literal);
+            size32_t copyLen = (next ? next : end) - cur;
+            tgt.ensureAvailable(tgtLen + copyLen + rlen);
+            memcpy_iflen(tgt.getbytes() + tgtLen, cur, copyLen);
+            tgtLen += copyLen;
+            if (!next)
+                break;
+            memcpy_iflen(tgt.getbytes() + tgtLen, replace, rlen);
+            tgtLen += rlen;
+            cur = next + litLen;
+        }
+        outlen = tgtLen;
+        out = (char *)tgt.detachdata();
+    }
 };
 
 //---------------------------------------------------------------------------
 
 ECLRTL_API ICompiledStrRegExpr * rtlCreateCompiledStrRegExpr(const char * regExpr, bool isCaseSensitive)
 {
-    CCompiledStrRegExpr * expr = new CCompiledStrRegExpr(regExpr, isCaseSensitive);
+    std::string key(isCaseSensitive ? "C" : "I");
+    key += regExpr;
+    Owned<CStrRegExprPattern> pattern = strRegExprCache.lookup(key);
+    if (!pattern)
+        pattern.setown(strRegExprCache.add(key, new CStrRegExprPattern(regExpr, isCaseSensitive)));
+    CCompiledStrRegExpr * expr = new CCompiledStrRegExpr(pattern);
     return expr;
 }
 
@@ -339,14 +558,10 @@ public:
 
 //---------------------------------------------------------------------------
 
-class CCompiledUStrRegExpr : implements ICompiledUStrRegExpr
+class CUStrRegExprPattern : public CInterface
 {
-private:
-    RegexPattern *  pattern;
-    RegexMatcher *  matcher;
-
 public:
-    CCompiledUStrRegExpr(const UChar * _UregExp, bool _isCaseSensitive = false)
+    CUStrRegExprPattern(const UChar * _UregExp, bool _isCaseSensitive)
     {
         UErrorCode uerr = U_ZERO_ERROR;
         UParseError uperr;
@@ -355,22 +570,55 @@ public:
         else
             pattern = RegexPattern::compile(_UregExp, UREGEX_CASE_INSENSITIVE, uperr, uerr);
 
-        matcher = pattern ? pattern->matcher(uerr) : NULL;
         if (U_FAILURE(uerr))
         {
-            char * expAscii;
-            unsigned expAsciiLen;
-            rtlUnicodeToEscapedStrX(expAsciiLen, expAscii, rtlUnicodeStrlen(_UregExp), _UregExp);
-            std::string msg = "Bad regular expression: ";
-            msg += u_errorName(uerr);
-            msg += ": ";
-            msg.append(expAscii, expAsciiLen);
-            rtlFree(expAscii);
-            delete matcher;
             delete pattern;
-            matcher = NULL;
             pattern = NULL;
-            rtlFail(0, msg.c_str());  //throws
+            failBadExpression(_UregExp, uerr);
+        }
+    }
+
+    ~CUStrRegExprPattern()
+    {
+        if (pattern)
+            delete pattern;
+    }
+
+    static void failBadExpression(const UChar * _UregExp, UErrorCode uerr)
+    {
+        char * expAscii;
+        unsigned expAsciiLen;
+        rtlUnicodeToEscapedStrX(expAsciiLen, expAscii, rtlUnicodeStrlen(_UregExp), _UregExp);
+        std::string msg = "Bad regular expression: ";
+        msg += u_errorName(uerr);
+        msg += ": ";
+        msg.append(expAscii, expAsciiLen);
+        rtlFree(expAscii);
+        rtlFail(0, msg.c_str());  //throws
+    }
+
+    RegexPattern *  pattern = nullptr; // immutable, so can be shared by multiple matchers
+};
+
+static CRegExprCache<CUStrRegExprPattern> ustrRegExprCache;
+
+class CCompiledUStrRegExpr : implements ICompiledUStrRegExpr
+{
+private:
+    Linked<CUStrRegExprPattern> compiled;
+    RegexPattern *  pattern;
+    RegexMatcher *  matcher;
+
+public:
+    CCompiledUStrRegExpr(CUStrRegExprPattern * _compiled, const UChar * _UregExp) : compiled(_compiled), pattern(_compiled->pattern)
+    {
+        UErrorCode uerr = U_ZERO_ERROR;
+        matcher = pattern->matcher(uerr);
+        if (U_FAILURE(uerr))
+        {
+            delete matcher;
+            matcher = NULL;
+            CUStrRegExprPattern::failBadExpression(_UregExp, uerr);
         }
     }
 
@@ -378,8 +626,6 @@ public:
     {
         if (matcher)
             delete matcher;
-        if (pattern)
-            delete pattern;
     }
 
     void replace(size32_t & outlen, UChar * & out, size32_t slen, const UChar * str, size32_t rlen, UChar const * replace) const
@@ -440,7 +686,12 @@ public:
 
 ECLRTL_API ICompiledUStrRegExpr * rtlCreateCompiledUStrRegExpr(const UChar * regExpr, bool isCaseSensitive)
 {
-    CCompiledUStrRegExpr * expr = new CCompiledUStrRegExpr(regExpr, isCaseSensitive);
+    std::string key(isCaseSensitive ? "C" : "I");
+    key.append((const char *)regExpr, rtlUnicodeStrlen(regExpr) * sizeof(UChar));
+    Owned<CUStrRegExprPattern> pattern = ustrRegExprCache.lookup(key);
+    if (!pattern)
+        pattern.setown(ustrRegExprCache.add(key, new CUStrRegExprPattern(regExpr, isCaseSensitive)));
+    CCompiledUStrRegExpr * expr = new CCompiledUStrRegExpr(pattern, regExpr);
     return expr;
 }
 
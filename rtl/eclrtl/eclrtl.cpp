@@ -6534,6 +6534,7 @@ class EclRtlTests : public CppUnit::TestFixture
     CPPUNIT_TEST_SUITE( EclRtlTests );
         CPPUNIT_TEST(RegexTest);
         CPPUNIT_TEST(MultiRegexTest);
+        CPPUNIT_TEST(LiteralRegexTest);
     CPPUNIT_TEST_SUITE_END();
 
 protected:
@@ -6581,6 +6582,50 @@ protected:
         t2.join();
         t3.join();
     }
+
+    void LiteralRegexTest()
+    {
+        //Literal patterns bypass the regex engine - check they give the same results
+        rtlCompiledStrRegex r;
+        size32_t outlen;
+        char * out = NULL;
+        r.setPattern("a\\.b", true);
+        r->replace(outlen, out, 11, "a.b axb a.b", 1, "-");
+        ASSERT(outlen==7);
+        ASSERT(memcmp(out, "- axb -", outlen)==0);
+        rtlFree(out);
+
+        r.setPattern("aa", true);
+        r->replace(outlen, out, 5, "aaaaa", 1, "b");
+        ASSERT(outlen==3);
+        ASSERT(memcmp(out, "bba", outlen)==0);
+        rtlFree(out);
+
+        r->replace(outlen, out, 4, "xaay", 4, "[$&]");
+        ASSERT(outlen==6);
+        ASSERT(memcmp(out, "x[aa]y", outlen)==0);
+        rtlFree(out);
+
+        rtlStrRegexFindInstance find;
+        find.find(r, 5, "baaab", true);
+        ASSERT(find->found());
+        find->getMatchX(outlen, out, 0);
+        ASSERT(outlen==2);
+        ASSERT(memcmp(out, "aa", outlen)==0);
+        rtlFree(out);
+        find->getMatchX(outlen, out, 1);
+        ASSERT(outlen==0);
+
+        find.find(r, 5, "babab", false);
+        ASSERT(!find->found());
+
+        bool isAll;
+        size32_t resultBytes;
+        void * result;
+        r->getMatchSet(isAll, resultBytes, result, 7, "aaxaaaa");
+        ASSERT(resultBytes==3*(sizeof(size32_t)+2));
+        rtlFree(result);
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( EclRtlTests );
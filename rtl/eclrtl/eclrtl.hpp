@@ -450,6 +450,11 @@ inline void rtlWriteInt8(void * data, unsigned __int64 value) { *(unsigned __int
 inline void rtlWriteSize32t(void * data, unsigned value) { *(size32_t *)data = value; }
 ECLRTL_API void rtlWriteInt(void * self, __int64 val, unsigned length);
 
+//Write values so that the memcmp() order of the bytes matches the order of the values (used for sort keys)
+ECLRTL_API void rtlWriteNormalizedInt(void * self, __int64 val, unsigned length);
+ECLRTL_API void rtlWriteNormalizedUInt(void * self, unsigned __int64 val, unsigned length);
+ECLRTL_API void rtlInvertNormalizedKey(void * self, unsigned length);
+
 inline int rtlReadSwapInt1(const void * data) { return *(signed char *)data; }
 ECLRTL_API int rtlReadSwapInt2(const void * data);
 ECLRTL_API int rtlReadSwapInt3(const void * data);
@@ -614,3 +614,29 @@ void rtlWriteSwapInt(void * self, __int64 val, unsigned length)
 }
 
 #endif
+
+//---------------------------------------------------------------------------
+// Normalized keys - the memcmp() order of the bytes matches the order of the values
+
+void rtlWriteNormalizedUInt(void * self, unsigned __int64 val, unsigned length)
+{
+    byte * target = (byte *)self;
+    for (unsigned i=length; i-- > 0;)
+    {
+        target[i] = (byte)val;
+        val >>= 8;
+    }
+}
+
+void rtlWriteNormalizedInt(void * self, __int64 val, unsigned length)
+{
+    rtlWriteNormalizedUInt(self, (unsigned __int64)val, length);
+    ((byte *)self)[0] ^= 0x80;  // flip the sign bit so negative values sort first
+}
+
+void rtlInvertNormalizedKey(void * self, unsigned length)
+{
+    byte * target = (byte *)self;
+    for (unsigned i=0; i < length; i++)
+        target[i] = ~target[i];
+}
@@ -92,6 +92,18 @@ protected:
 };
 #endif
 
+#ifndef ICOMPARENORMALIZEDKEY_DEFINED
+#define ICOMPARENORMALIZEDKEY_DEFINED
+//Optionally implemented by a generated compare when the sort order can also be represented as a fixed size binary key.
+//The memcmp() order of two keys must match the order returned by docompare() whenever the keys differ - rows with
+//identical keys are ordered by calling docompare().
+struct ICompareNormalizedKey : public ICompare
+{
+    virtual size32_t getNormalizedKeySize() const = 0;
+    virtual void getNormalizedKey(byte * key, const void * row) const = 0;
+};
+#endif
+
 #ifndef ICOMPAREEQ_DEFINED
 #define ICOMPAREEQ_DEFINED
 struct ICompareEq
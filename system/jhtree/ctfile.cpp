@@ -24,10 +24,21 @@
 #endif
 
 #include "jmisc.hpp"
+#include "jlz4.hpp"
 #include "hlzw.h"
 
 #include "ctfile.hpp"
 #include "jstats.h"
+#include "jdebug.hpp"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAS_X86_KEY_SEARCH
+#include <immintrin.h>
+#endif
 
 void SwapBigEndian(KeyHdr &hdr)
 {
@@ -78,6 +89,7 @@ void SwapBigEndian(KeyHdr &hdr)
     _WINREV(hdr.fileSize);
     _WINREV(hdr.nodeKeyLength);
     _WINREV(hdr.version);
+    _WINREV(hdr.extflags);
     _WINREV(hdr.blobHead);
     _WINREV(hdr.metadataHead);
     _WINREV(hdr.bloomHead);
@@ -282,7 +294,12 @@ void CWriteNodeBase::writeHdr()
 void CWriteNodeBase::write(IFileIOStream *out, CRC32 *crc)
 {
     if (isLeaf() && (keyType & HTREE_COMPRESSED_KEY))
+    {
         lzwcomp.close();
+        //The size of an LZ4 compressed node is only known once the compressor has been closed
+        if ((hdr.leafFlag == NodeLeaf) && keyHdr->isLZ4Compressed() && hdr.numKeys)
+            hdr.keyBytes = lzwcomp.buflen() + sizeof(unsigned __int64);
+    }
     assertex(hdr.keyBytes<=maxBytes);
     writeHdr();
     out->seek(getFpos(), IFSbegin);
@@ -319,10 +336,24 @@ bool CWriteNode::add(offset_t pos, const void *indata, size32_t insize, unsigned
         keyPtr += sizeof(rsequence);
         hdr.keyBytes += sizeof(rsequence);
     }
-    if (isLeaf() && (keyType & HTREE_COMPRESSED_KEY))
+    if (isLeaf() && (keyType & HTREE_COMPRESSED_KEY) && keyHdr->isLZ4Compressed())
+    {
+        //Rows are prefix compressed against the previous row (as for COL_PREFIX) before being passed to the LZ4 compressor
+        if (0 == hdr.numKeys)
+            lzwcomp.open(keyPtr, maxBytes-hdr.keyBytes, isVariable, false, true);
+        char *result = (char *) alloca(insize+1);
+        size32_t size = compressValue((const char *) indata, insize, result);
+        if (0xffff == hdr.numKeys || 0 == lzwcomp.writeprefixkey(pos, result, size, insize))
+        {
+            lzwcomp.close();
+            return false;
+        }
+        //hdr.keyBytes is updated when the node is written
+    }
+    else if (isLeaf() && (keyType & HTREE_COMPRESSED_KEY))
     {
         if (0 == hdr.numKeys)
-            lzwcomp.open(keyPtr, maxBytes-hdr.keyBytes, isVariable, (keyType&HTREE_QUICK_COMPRESSED_KEY)==HTREE_QUICK_COMPRESSED_KEY);
+            lzwcomp.open(keyPtr, maxBytes-hdr.keyBytes, isVariable, (keyType&HTREE_QUICK_COMPRESSED_KEY)==HTREE_QUICK_COMPRESSED_KEY, false);
         if (0xffff == hdr.numKeys || 0 == lzwcomp.writekey(pos, (const char *)indata, insize, sequence))
         {
             lzwcomp.close();
@@ -376,6 +407,7 @@ bool CWriteNode::add(offset_t pos, const void *indata, size32_t insize, unsigned
     if (insize>keyLen)
         throw MakeStringException(0, "key+payload (%u) exceeds max length (%u)", insize, keyLen);
     memcpy(lastKeyValue, indata, insize);
+    lastKeySize = insize;
     lastSequence = sequence;
     hdr.numKeys++;
     return true;
@@ -386,7 +418,9 @@ size32_t CWriteNode::compressValue(const char *keyData, size32_t size, char *res
     unsigned int pack = 0;
     if (hdr.numKeys)
     {
-        for (; pack<size && pack<255; pack++)
+        //Never use bytes beyond the end of the previous (variable size) row
+        size32_t maxPack = (size < lastKeySize) ? size : lastKeySize;
+        for (; pack<maxPack && pack<255; pack++)
         {
             if (keyData[pack] != lastKeyValue[pack])
                 break;
@@ -496,6 +530,225 @@ void CBloomFilterWriteNode::put8(__int64 val)
 
 //=========================================================================================================
 
+// Optional arena for expanded node payloads.  The node cache is usually the largest consumer of memory in a roxie
+// process, so backing it with huge pages noticeably reduces TLB misses.  The arena is split into slabs, each of which
+// is dedicated to a single size class when it is first needed.  Freed blocks are kept on a per-class free list, and
+// slabs are never returned to the arena.  Payloads larger than the biggest class, or requested once the arena is
+// exhausted, are allocated with malloc as before.
+
+class NodeMemoryArena
+{
+    friend class NodeMemoryArenaTest;
+    static constexpr unsigned numClasses = 7;           // 1Kb .. 64Kb, covering the usual node sizes
+    static constexpr size32_t minClassSize = 0x400;
+    static constexpr memsize_t slabSize = 0x200000;     // matches the usual huge page size
+
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+    struct SizeClass
+    {
+        mutable CriticalSection crit;
+        FreeBlock *freeList = nullptr;
+        char *nextFree = nullptr;
+        char *slabEnd = nullptr;
+        unsigned numSlabs = 0;
+        RelaxedAtomic<memsize_t> inUse{0};
+    };
+
+public:
+    NodeMemoryArena(memsize_t size, bool allowHugePages, bool allowTransparentHugePages, bool preFault)
+    {
+        numSlabs = (unsigned)((size + slabSize - 1) / slabSize);
+        totalSize = numSlabs * slabSize;
+        slabClass = new byte[numSlabs];
+#ifdef MAP_HUGETLB
+        if (allowHugePages)
+        {
+            void *mapped = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (mapped != MAP_FAILED)
+            {
+                mapBase = (char *) mapped;
+                mapSize = totalSize;
+                base = mapBase;
+                hugePages = true;
+            }
+            else
+                DBGLOG("Huge pages requested for index node memory but unavailable, errno = %d", errno);
+        }
+#endif
+        if (!base)
+        {
+            // Over-allocate so the arena can be aligned to a slab (and therefore huge page) boundary
+            mapSize = totalSize + slabSize;
+            void *mapped = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapped == MAP_FAILED)
+                throw makeErrnoExceptionV(errno, "Failed to reserve %" I64F "u bytes for index node memory", (unsigned __int64) mapSize);
+            mapBase = (char *) mapped;
+            base = (char *) (((memsize_t) mapBase + slabSize - 1) & ~(slabSize - 1));
+#ifdef MADV_HUGEPAGE
+            if (allowTransparentHugePages && areTransparentHugePagesEnabled(queryTransparentHugePagesMode()))
+                hugePages = (madvise(base, totalSize, MADV_HUGEPAGE) == 0);
+#endif
+        }
+        if (preFault)
+        {
+            for (memsize_t offset = 0; offset < totalSize; offset += 0x1000)
+                base[offset] = 0;
+        }
+        DBGLOG("Index node memory arena: %" I64F "u bytes, %s pages%s", (unsigned __int64) totalSize, hugePages ? "huge" : "standard", preFault ? ", pre-faulted" : "");
+    }
+    ~NodeMemoryArena()
+    {
+        munmap(mapBase, mapSize);
+        delete [] slabClass;
+    }
+
+    void *allocate(size32_t len)
+    {
+        unsigned sizeClass = getSizeClass(len);
+        if (sizeClass >= numClasses)
+            return nullptr;
+        size32_t classSize = minClassSize << sizeClass;
+        SizeClass &cls = classes[sizeClass];
+        void *ret;
+        {
+            CriticalBlock b(cls.crit);
+            if (cls.freeList)
+            {
+                ret = cls.freeList;
+                cls.freeList = cls.freeList->next;
+            }
+            else
+            {
+                if (cls.nextFree == cls.slabEnd)
+                {
+                    unsigned slab = nextSlab.fetch_add(1);
+                    if (slab >= numSlabs)
+                    {
+                        exhausted++;
+                        return nullptr;
+                    }
+                    slabClass[slab] = sizeClass;
+                    cls.nextFree = base + slab * slabSize;
+                    cls.slabEnd = cls.nextFree + slabSize;
+                    cls.numSlabs++;
+                }
+                ret = cls.nextFree;
+                cls.nextFree += classSize;
+            }
+        }
+        cls.inUse += classSize;
+        return ret;
+    }
+
+    void release(void *ptr)
+    {
+        unsigned sizeClass = slabClass[((char *) ptr - base) / slabSize];
+        SizeClass &cls = classes[sizeClass];
+        FreeBlock *block = (FreeBlock *) ptr;
+        {
+            CriticalBlock b(cls.crit);
+            block->next = cls.freeList;
+            cls.freeList = block;
+        }
+        cls.inUse -= (minClassSize << sizeClass);
+    }
+
+    inline bool owns(const void *ptr) const
+    {
+        return ((const char *) ptr >= base) && ((const char *) ptr < base + totalSize);
+    }
+
+    StringBuffer &getStats(StringBuffer &out) const
+    {
+        unsigned slabsUsed = nextSlab.load();
+        if (slabsUsed > numSlabs)
+            slabsUsed = numSlabs;
+        out.appendf("<NodeMemory size=\"%" I64F "u\" hugePages=\"%u\" slabsUsed=\"%u\" slabs=\"%u\" exhausted=\"%u\">",
+                    (unsigned __int64) totalSize, hugePages ? 1 : 0, slabsUsed, numSlabs, exhausted.load());
+        for (unsigned i = 0; i < numClasses; i++)
+        {
+            const SizeClass &cls = classes[i];
+            unsigned classSlabs;
+            {
+                CriticalBlock b(cls.crit);
+                classSlabs = cls.numSlabs;
+            }
+            if (classSlabs)
+                out.appendf("<SizeClass size=\"%u\" slabs=\"%u\" inUse=\"%" I64F "u\"/>", minClassSize << i, classSlabs, (unsigned __int64) cls.inUse.load());
+        }
+        return out.append("</NodeMemory>");
+    }
+
+private:
+    static unsigned getSizeClass(size32_t len)
+    {
+        unsigned sizeClass = 0;
+        while ((sizeClass < numClasses) && ((minClassSize << sizeClass) < len))
+            sizeClass++;
+        return sizeClass;
+    }
+
+    char *mapBase = nullptr;
+    memsize_t mapSize = 0;
+    char *base = nullptr;
+    memsize_t totalSize = 0;
+    unsigned numSlabs = 0;
+    byte *slabClass = nullptr;      // size class of each slab that has been handed out
+    std::atomic<unsigned> nextSlab{0};
+    RelaxedAtomic<unsigned> exhausted{0};
+    bool hugePages = false;
+    SizeClass classes[numClasses];
+};
+
+// Created once at startup, and deliberately never freed - cached nodes can outlive any sensible point to release it
+static NodeMemoryArena *nodeMemoryArena = nullptr;
+
+extern jhtree_decl void setNodeMemoryArena(memsize_t size, bool allowHugePages, bool allowTransparentHugePages, bool preFault)
+{
+#ifdef _WIN32
+    DBGLOG("Index node memory arena is not supported on this platform");
+#else
+    assertex(!nodeMemoryArena);
+    if (size)
+        nodeMemoryArena = new NodeMemoryArena(size, allowHugePages, allowTransparentHugePages, preFault);
+#endif
+}
+
+extern jhtree_decl StringBuffer &getNodeMemoryStats(StringBuffer &out)
+{
+    if (nodeMemoryArena)
+        nodeMemoryArena->getStats(out);
+    return out;
+}
+
+//=========================================================================================================
+
+static void releaseAlignedMem(void *togo)
+{
+#ifdef _WIN32
+    _aligned_free(togo);
+#else
+    free(togo);
+#endif
+}
+
+static void *allocAlignedMem(size32_t len)
+{
+    void * ret;
+#ifdef _WIN32
+    ret = _aligned_malloc(len, CACHE_LINE_SIZE);
+#else
+    if (posix_memalign(&ret, CACHE_LINE_SIZE, len) != 0)
+        ret = nullptr;
+#endif
+    if (!ret)
+        throw MakeStringException(MSGAUD_operator,0, "Out of memory allocating key prefixes, requesting %u bytes", len);
+    return ret;
+}
+
 CJHTreeNode::CJHTreeNode()
 {
     keyBuf = NULL;
@@ -508,21 +761,31 @@ void CJHTreeNode::load(CKeyHdr *_keyHdr, const void *rawData, offset_t _fpos, bo
 {
     CNodeBase::load(_keyHdr, _fpos);
     unpack(rawData, needCopy);
+    //Variable size leaves are not stored with a fixed stride, and row compressed leaves do not have a keyBuf
+    if (useKeyPrefixSearch && keyBuf && keyCompareLen && (hdr.leafFlag == NodeBranch || (hdr.leafFlag == NodeLeaf && !isVariable)))
+        buildKeyPrefixes();
 }
 
 CJHTreeNode::~CJHTreeNode()
 {
     releaseMem(keyBuf, expandedSize);
+    if (keyPrefixes)
+        releaseAlignedMem(keyPrefixes);
 }
 
 void CJHTreeNode::releaseMem(void *togo, size32_t len)
 {
-    free(togo);
+    if (nodeMemoryArena && nodeMemoryArena->owns(togo))
+        nodeMemoryArena->release(togo);
+    else
+        free(togo);
 }
 
 void *CJHTreeNode::allocMem(size32_t len)
 {
-    char *ret = (char *) malloc(len);
+    char *ret = nodeMemoryArena ? (char *) nodeMemoryArena->allocate(len) : nullptr;
+    if (!ret)
+        ret = (char *) malloc(len);
     if (!ret)
     {
         Owned<IException> E = MakeStringException(MSGAUD_operator,0, "Out of memory in CJHTreeNode::allocMem, requesting %d bytes", len);
@@ -538,9 +801,9 @@ void *CJHTreeNode::allocMem(size32_t len)
     return ret;
 }
 
-char *CJHTreeNode::expandKeys(void *src,size32_t &retsize)
+char *CJHTreeNode::expandKeys(void *src,size32_t &retsize, bool lz4)
 {
-    Owned<IExpander> exp = createLZWExpander(true);
+    Owned<IExpander> exp = lz4 ? createLZ4Expander() : createLZWExpander(true);
     int len=exp->init(src);
     if (len==0)
     {
@@ -606,117 +869,144 @@ void CJHTreeNode::unpack(const void *node, bool needCopy)
             expandedSize = keyHdr->getNodeSize();
             bool quick = !isBlob() && (keyType&(HTREE_QUICK_COMPRESSED_KEY|HTREE_VARSIZE))==HTREE_QUICK_COMPRESSED_KEY;
             keyBuf = NULL;
-            if (!quick)
-                keyBuf = expandKeys(keys,expandedSize);
+            if (hdr.leafFlag == NodeLeaf && keyHdr->isLZ4Compressed())
+            {
+                size32_t prefixedSize;
+                char * prefixed = expandKeys(keys, prefixedSize, true);
+                try
+                {
+                    expandColPrefix(prefixed);
+                }
+                catch (...)
+                {
+                    releaseMem(prefixed, prefixedSize);
+                    throw;
+                }
+                releaseMem(prefixed, prefixedSize);
+            }
+            else if (!quick)
+                keyBuf = expandKeys(keys,expandedSize,false);
         }
     }
     else
     {
-        int i;
         if (keyType & COL_PREFIX)
         {
             MTIME_SECTION(queryActiveTimer(), "COL_PREFIX expand");
-            
-            if (hdr.numKeys) {
-                bool handleVariable = isVariable && isLeaf();
-                KEYRECSIZE_T workRecLen;
-                MemoryBuffer keyBufMb;
-                const char *source = keys;
-                char *target;
-                // do first row
-                if (handleVariable) {
-                    memcpy(&workRecLen, source, sizeof(workRecLen));
-                    _WINREV(workRecLen);
-                    size32_t tmpSz = sizeof(workRecLen) + sizeof(offset_t);
-                    target = (char *)keyBufMb.reserve(tmpSz+workRecLen);
-                    memcpy(target, source, tmpSz);
-                    source += tmpSz;
-                    target += tmpSz;
-                }
-                else {
-                    target = (char *)keyBufMb.reserveTruncate(hdr.numKeys * keyRecLen);
-                    workRecLen = keyRecLen - sizeof(offset_t);
-                    memcpy(target, source, sizeof(offset_t));
-                    source += sizeof(offset_t);
-                    target += sizeof(offset_t);
-                }
+            expandColPrefix(keys);
+        }
+        else
+        {
+            MTIME_SECTION(queryActiveTimer(), "NO compression copy");
+            expandedSize = hdr.keyBytes + sizeof( __int64 );  // MORE - why is the +sizeof() there?
+            keyBuf = (char *) allocMem(expandedSize);
+            memcpy(keyBuf, keys, hdr.keyBytes + sizeof( __int64 ));
+        }
+    }
+}
+
+void CJHTreeNode::expandColPrefix(const char *keys)
+{
+    int i;
+    if (hdr.numKeys) {
+        bool handleVariable = isVariable && isLeaf();
+        KEYRECSIZE_T workRecLen;
+        MemoryBuffer keyBufMb;
+        const char *source = keys;
+        char *target;
+        // do first row
+        if (handleVariable) {
+            memcpy(&workRecLen, source, sizeof(workRecLen));
+            _WINREV(workRecLen);
+            size32_t tmpSz = sizeof(workRecLen) + sizeof(offset_t);
+            target = (char *)keyBufMb.reserve(tmpSz+workRecLen);
+            memcpy(target, source, tmpSz);
+            source += tmpSz;
+            target += tmpSz;
+        }
+        else {
+            target = (char *)keyBufMb.reserveTruncate(hdr.numKeys * keyRecLen);
+            workRecLen = keyRecLen - sizeof(offset_t);
+            memcpy(target, source, sizeof(offset_t));
+            source += sizeof(offset_t);
+            target += sizeof(offset_t);
+        }
 
-                // this is where next row gets data from
-                const char *prev, *next = NULL;
-                unsigned prevOffset = 0;
-                if (handleVariable)
-                    prevOffset = target-((char *)keyBufMb.bufferBase());
-                else
-                    next = target;
+        // this is where next row gets data from
+        const char *prev, *next = NULL;
+        unsigned prevOffset = 0;
+        if (handleVariable)
+            prevOffset = target-((char *)keyBufMb.bufferBase());
+        else
+            next = target;
 
-                unsigned char pack1 = *source++;
+        unsigned char pack1 = *source++;
 #ifdef _DEBUG
-                assertex(0==pack1); // 1st time will be always be 0
+        assertex(0==pack1); // 1st time will be always be 0
 #endif
-                KEYRECSIZE_T left = workRecLen;
-                while (left--) {
-                    *target = *source;
-                    source++;
-                    target++;
-                }
-                // do subsequent rows
-                for (i = 1; i < hdr.numKeys; i++) {
-                    if (handleVariable) {
-                        memcpy(&workRecLen, source, sizeof(workRecLen));
-                        _WINREV(workRecLen);
-                        target = (char *)keyBufMb.reserve(sizeof(workRecLen)+sizeof(offset_t)+workRecLen);
-                        size32_t tmpSz = sizeof(workRecLen)+sizeof(offset_t);
-                        memcpy(target, source, tmpSz);
-                        target += tmpSz;
-                        source += tmpSz;
-                    }
-                    else
-                    {
-                        memcpy(target, source, sizeof(offset_t));
-                        source += sizeof(offset_t);
-                        target += sizeof(offset_t);
-                    }
-                    pack1 = *source++;
+        KEYRECSIZE_T left = workRecLen;
+        while (left--) {
+            *target = *source;
+            source++;
+            target++;
+        }
+        // do subsequent rows
+        for (i = 1; i < hdr.numKeys; i++) {
+            if (handleVariable) {
+                memcpy(&workRecLen, source, sizeof(workRecLen));
+                _WINREV(workRecLen);
+                target = (char *)keyBufMb.reserve(sizeof(workRecLen)+sizeof(offset_t)+workRecLen);
+                size32_t tmpSz = sizeof(workRecLen)+sizeof(offset_t);
+                memcpy(target, source, tmpSz);
+                target += tmpSz;
+                source += tmpSz;
+            }
+            else
+            {
+                memcpy(target, source, sizeof(offset_t));
+                source += sizeof(offset_t);
+                target += sizeof(offset_t);
+            }
+            pack1 = *source++;
 #ifdef _DEBUG
-                    assertex(pack1<=workRecLen);            
+            assertex(pack1<=workRecLen);            
 #endif
-                    if (handleVariable) {
-                        prev = ((char *)keyBufMb.bufferBase())+prevOffset;
-                        // for next
-                        prevOffset = target-((char *)keyBufMb.bufferBase());
-                    }
-                    else {
-                        prev = next;
-                        next = target;
-                    }
-                    left = workRecLen - pack1;
-                    while (pack1--) {
-                        *target = *prev;
-                        prev++;
-                        target++;
-                    }
-                    while (left--) {
-                        *target = *source;
-                        source++;
-                        target++;
-                    }
-                }
-                expandedSize = keyBufMb.length();
-                keyBuf = (char *)keyBufMb.detach();
-                assertex(keyBuf);
+            if (handleVariable) {
+                prev = ((char *)keyBufMb.bufferBase())+prevOffset;
+                // for next
+                prevOffset = target-((char *)keyBufMb.bufferBase());
             }
             else {
-                keyBuf = NULL;
-                expandedSize = 0;
+                prev = next;
+                next = target;
+            }
+            left = workRecLen - pack1;
+            while (pack1--) {
+                *target = *prev;
+                prev++;
+                target++;
+            }
+            while (left--) {
+                *target = *source;
+                source++;
+                target++;
             }
         }
-        else
+        expandedSize = keyBufMb.length();
+        // Only copy into the arena if it can take the payload - otherwise keep the malloced buffer as before
+        void *arenaBuf = nodeMemoryArena ? nodeMemoryArena->allocate(expandedSize) : nullptr;
+        if (arenaBuf)
         {
-            MTIME_SECTION(queryActiveTimer(), "NO compression copy");
-            expandedSize = hdr.keyBytes + sizeof( __int64 );  // MORE - why is the +sizeof() there?
-            keyBuf = (char *) allocMem(expandedSize);
-            memcpy(keyBuf, keys, hdr.keyBytes + sizeof( __int64 ));
+            memcpy(arenaBuf, keyBufMb.toByteArray(), expandedSize);
+            keyBuf = (char *) arenaBuf;
         }
+        else
+            keyBuf = (char *)keyBufMb.detach();
+        assertex(keyBuf);
+    }
+    else {
+        keyBuf = NULL;
+        expandedSize = 0;
     }
 }
 
@@ -747,6 +1037,173 @@ int CJHTreeNode::compareValueAt(const char *src, unsigned int index) const
     return memcmp(src, keyBuf + index*keyRecLen + (keyHdr->hasSpecialFileposition() ? sizeof(offset_t) : 0), keyCompareLen);
 }
 
+//---------------------------------------------------------------------------------------------------------------------
+
+//The first 8 bytes of each key are extracted into a separate cache-line aligned array of big-endian integers when a
+//fixed size node is loaded.  Comparing two prefixes as unsigned integers gives the same ordering as a memcmp() of the
+//same bytes, so most of a search within the node can be done on this dense array without touching the key rows.
+//Once the binary search has narrowed down to a small window the remaining entries are counted using vector compares.
+
+static constexpr unsigned keyPrefixSearchWindow = 32;
+
+static inline unsigned __int64 extractKeyPrefix(const char * key, size32_t len)
+{
+    unsigned __int64 value = 0;
+    if (len >= sizeof(value))
+        memcpy(&value, key, sizeof(value));
+    else
+        memcpy(&value, key, len);  // trailing bytes are zero, which preserves the ordering
+    _WINREV(value);
+    return value;
+}
+
+static unsigned countLessScalar(const unsigned __int64 * values, unsigned num, unsigned __int64 search)
+{
+    unsigned count = 0;
+    for (unsigned i=0; i < num; i++)
+        count += (values[i] < search);
+    return count;
+}
+
+#ifdef HAS_X86_KEY_SEARCH
+//There are no unsigned 64bit compares, so flip the top bit and use a signed comparison instead
+__attribute__((target("sse4.2")))
+static unsigned countLessSSE42(const unsigned __int64 * values, unsigned num, unsigned __int64 search)
+{
+    const __m128i bias = _mm_set1_epi64x(I64C(0x8000000000000000));
+    const __m128i key = _mm_xor_si128(_mm_set1_epi64x((__int64)search), bias);
+    unsigned count = 0;
+    unsigned i = 0;
+    for (; i + 2 <= num; i += 2)
+    {
+        __m128i next = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(values + i)), bias);
+        __m128i less = _mm_cmpgt_epi64(key, next);
+        count += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(less)));
+    }
+    return count + countLessScalar(values + i, num - i, search);
+}
+
+__attribute__((target("avx2")))
+static unsigned countLessAVX2(const unsigned __int64 * values, unsigned num, unsigned __int64 search)
+{
+    const __m256i bias = _mm256_set1_epi64x(I64C(0x8000000000000000));
+    const __m256i key = _mm256_xor_si256(_mm256_set1_epi64x((__int64)search), bias);
+    unsigned count = 0;
+    unsigned i = 0;
+    for (; i + 4 <= num; i += 4)
+    {
+        __m256i next = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(values + i)), bias);
+        __m256i less = _mm256_cmpgt_epi64(key, next);
+        count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(less)));
+    }
+    return count + countLessScalar(values + i, num - i, search);
+}
+#endif
+
+typedef unsigned (*CountLessFunction)(const unsigned __int64 * values, unsigned num, unsigned __int64 search);
+
+static CountLessFunction selectCountLess()
+{
+#ifdef HAS_X86_KEY_SEARCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return countLessAVX2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return countLessSSE42;
+#endif
+    return countLessScalar;
+}
+
+static const CountLessFunction countLess = selectCountLess();
+
+//Return the index of the first prefix in [low, high) that is >= search (if orEqual is false) or > search (if orEqual is true)
+static unsigned locatePrefix(const unsigned __int64 * prefixes, unsigned low, unsigned high, unsigned __int64 search, bool orEqual)
+{
+    if (orEqual)
+    {
+        if (search == (unsigned __int64)-1)
+            return high;
+        search++;
+    }
+    while (high - low > keyPrefixSearchWindow)
+    {
+        unsigned mid = low + (high - low) / 2;
+        if (prefixes[mid] < search)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low + countLess(prefixes + low, high - low, search);
+}
+
+void CJHTreeNode::buildKeyPrefixes()
+{
+    unsigned numKeys = hdr.numKeys;
+    if (!numKeys)
+        return;
+    size32_t prefixOffset = keyHdr->hasSpecialFileposition() ? sizeof(offset_t) : 0;
+    keyPrefixes = (unsigned __int64 *) allocAlignedMem(numKeys * sizeof(unsigned __int64));
+    const char * cur = keyBuf + prefixOffset;
+    for (unsigned i=0; i < numKeys; i++)
+    {
+        keyPrefixes[i] = extractKeyPrefix(cur, keyCompareLen);
+        cur += keyRecLen;
+    }
+}
+
+unsigned CJHTreeNode::locateGE(const char *src, unsigned minIndex) const
+{
+    unsigned numKeys = hdr.numKeys;
+    if (keyPrefixes)
+    {
+        unsigned __int64 search = extractKeyPrefix(src, keyCompareLen);
+        unsigned low = locatePrefix(keyPrefixes, minIndex, numKeys, search, false);
+        if (keyCompareLen <= sizeof(unsigned __int64))
+            return low;
+        //Only the keys with an identical prefix need to be compared in full
+        minIndex = low;
+        numKeys = locatePrefix(keyPrefixes, low, numKeys, search, true);
+    }
+
+    unsigned a = minIndex;
+    unsigned b = numKeys;
+    while (a < b)
+    {
+        unsigned i = a+(b-a)/2;
+        if (compareValueAt(src, i) > 0)
+            a = i+1;
+        else
+            b = i;
+    }
+    return a;
+}
+
+unsigned CJHTreeNode::locateGT(const char *src, unsigned minIndex) const
+{
+    unsigned numKeys = hdr.numKeys;
+    if (keyPrefixes)
+    {
+        unsigned __int64 search = extractKeyPrefix(src, keyCompareLen);
+        if (keyCompareLen <= sizeof(unsigned __int64))
+            return locatePrefix(keyPrefixes, minIndex, numKeys, search, true);
+        //Only the keys with an identical prefix need to be compared in full
+        minIndex = locatePrefix(keyPrefixes, minIndex, numKeys, search, false);
+        numKeys = locatePrefix(keyPrefixes, minIndex, numKeys, search, true);
+    }
+
+    unsigned a = minIndex;
+    unsigned b = numKeys;
+    while (a < b)
+    {
+        unsigned i = a+(b-a)/2;
+        if (compareValueAt(src, i) >= 0)
+            a = i+1;
+        else
+            b = i;
+    }
+    return a;
+}
+
 bool CJHTreeNode::getValueAt(unsigned int index, char *dst) const
 {
     if (index >= hdr.numKeys) return false;
@@ -1098,3 +1555,130 @@ IKeyException *MakeKeyException(int code, const char *format, ...)
     return e;
 }
 
+#ifdef _USE_CPPUNIT
+#include "unittests.hpp"
+
+class NodeMemoryArenaTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( NodeMemoryArenaTest );
+        CPPUNIT_TEST(testSizeClasses);
+        CPPUNIT_TEST(testReuse);
+        CPPUNIT_TEST(testExhausted);
+        CPPUNIT_TEST(testNodeAllocation);
+    CPPUNIT_TEST_SUITE_END();
+
+    // Gives the tests access to the node's allocation functions
+    class TestNode : public CJHTreeNode
+    {
+    public:
+        using CJHTreeNode::allocMem;
+        using CJHTreeNode::releaseMem;
+    };
+
+    static constexpr memsize_t slabSize = NodeMemoryArena::slabSize;
+    static constexpr size32_t minClassSize = NodeMemoryArena::minClassSize;
+    static constexpr size32_t maxClassSize = minClassSize << (NodeMemoryArena::numClasses - 1);
+
+    static memsize_t inUse(const NodeMemoryArena &arena, unsigned sizeClass)
+    {
+        return arena.classes[sizeClass].inUse.load();
+    }
+
+protected:
+    void testSizeClasses()
+    {
+        NodeMemoryArena arena(NodeMemoryArena::numClasses * slabSize, false, false, false);
+        void *tiny = arena.allocate(1);
+        void *exact = arena.allocate(minClassSize);
+        void *over = arena.allocate(minClassSize + 1);
+        void *largest = arena.allocate(maxClassSize);
+        CPPUNIT_ASSERT(tiny && exact && over && largest);
+        CPPUNIT_ASSERT_EQUAL((memsize_t) (2 * minClassSize), inUse(arena, 0));        // both rounded up to the smallest class
+        CPPUNIT_ASSERT_EQUAL((memsize_t) (2 * minClassSize), inUse(arena, 1));
+        CPPUNIT_ASSERT_EQUAL((memsize_t) maxClassSize, inUse(arena, NodeMemoryArena::numClasses - 1));
+        CPPUNIT_ASSERT_EQUAL((memsize_t) minClassSize, (memsize_t) ((char *) exact - (char *) tiny));     // consecutive blocks of the class
+        CPPUNIT_ASSERT(arena.owns(tiny) && arena.owns(largest));
+
+        // Anything larger than the biggest class is left to malloc
+        CPPUNIT_ASSERT(!arena.allocate(maxClassSize + 1));
+
+        arena.release(tiny);
+        arena.release(exact);
+        arena.release(over);
+        arena.release(largest);
+        for (unsigned i = 0; i < NodeMemoryArena::numClasses; i++)
+            CPPUNIT_ASSERT_EQUAL((memsize_t) 0, inUse(arena, i));
+    }
+
+    void testReuse()
+    {
+        NodeMemoryArena arena(slabSize, false, false, false);
+        void *first = arena.allocate(1000);
+        void *second = arena.allocate(1000);
+        arena.release(first);
+        void *reused = arena.allocate(900);      // same class - taken from the free list
+        CPPUNIT_ASSERT(reused == first);
+        arena.release(second);
+        arena.release(reused);
+        CPPUNIT_ASSERT(arena.allocate(1) == reused);     // most recently freed first
+        CPPUNIT_ASSERT_EQUAL(1U, arena.nextSlab.load());
+    }
+
+    void testExhausted()
+    {
+        NodeMemoryArena arena(2 * slabSize, false, false, false);
+        CPPUNIT_ASSERT(arena.allocate(minClassSize));                           // takes the first slab
+        unsigned blocksPerSlab = (unsigned) (slabSize / maxClassSize);
+        for (unsigned i = 0; i < blocksPerSlab; i++)
+            CPPUNIT_ASSERT(arena.allocate(maxClassSize));                       // fills the second
+        CPPUNIT_ASSERT(!arena.allocate(maxClassSize));                          // no slabs left for this class
+        CPPUNIT_ASSERT(!arena.allocate(minClassSize * 4));                      // or for a new one
+        CPPUNIT_ASSERT(arena.allocate(minClassSize));                           // but the first slab still has room
+        CPPUNIT_ASSERT_EQUAL(2U, arena.exhausted.load());
+
+        StringBuffer stats;
+        arena.getStats(stats);
+        CPPUNIT_ASSERT(strstr(stats.str(), "exhausted=\"2\"") != nullptr);
+    }
+
+    void testNodeAllocation()
+    {
+        // Route node allocations through a private arena, falling back to malloc when it cannot help
+        NodeMemoryArena arena(slabSize, false, false, false);
+        NodeMemoryArena *saved = nodeMemoryArena;
+        nodeMemoryArena = &arena;
+        try
+        {
+            void *fromArena = TestNode::allocMem(2000);
+            CPPUNIT_ASSERT(arena.owns(fromArena));
+            void *large = TestNode::allocMem(maxClassSize + 1);                 // too big for any class
+            CPPUNIT_ASSERT(large && !arena.owns(large));
+            memset(large, 0, maxClassSize + 1);
+
+            unsigned blocksPerSlab = (unsigned) (slabSize / (2 * minClassSize));
+            for (unsigned i = 1; i < blocksPerSlab; i++)
+                CPPUNIT_ASSERT(arena.owns(TestNode::allocMem(2000)));
+            void *overflow = TestNode::allocMem(2000);                           // arena full
+            CPPUNIT_ASSERT(overflow && !arena.owns(overflow));
+
+            memsize_t used = inUse(arena, 1);
+            TestNode::releaseMem(large, maxClassSize + 1);                      // freed, not returned to the arena
+            TestNode::releaseMem(overflow, 2000);
+            CPPUNIT_ASSERT_EQUAL(used, inUse(arena, 1));
+            TestNode::releaseMem(fromArena, 2000);
+            CPPUNIT_ASSERT_EQUAL(used - 2 * minClassSize, inUse(arena, 1));
+            CPPUNIT_ASSERT(TestNode::allocMem(2000) == fromArena);
+        }
+        catch (...)
+        {
+            nodeMemoryArena = saved;
+            throw;
+        }
+        nodeMemoryArena = saved;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( NodeMemoryArenaTest );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( NodeMemoryArenaTest, "NodeMemoryArenaTest" );
+
+#endif
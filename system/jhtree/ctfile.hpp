@@ -36,7 +36,10 @@
 #define USE_TRAILING_HEADER  0x80 // Real index header node located at end of file
 #define HTREE_COMPRESSED_KEY 0x40
 #define HTREE_QUICK_COMPRESSED_KEY 0x48
-#define KEYBUILD_VERSION 1 // unsigned short. NB: This should upped if a change would make existing keys incompatible with current build.
+// Flags above 0xff are stored in KeyHdr::extflags
+#define HTREE_LZ4_COMPRESSED_KEY 0x100 // Leaf nodes are prefix compressed and then LZ4 compressed - requires HTREE_COMPRESSED_KEY
+#define KEYBUILD_VERSION 2 // unsigned short. NB: This should upped if a change would make existing keys incompatible with current build.
+#define KEYBUILD_LZ4_VERSION 2 // Minimum version for keys with HTREE_LZ4_COMPRESSED_KEY.  Other keys are still written as version 1.
 #define KEYBUILD_MAXLENGTH 0x7FFF
 
 // structure to be read into - NO VIRTUALS.
@@ -92,7 +95,8 @@ struct __declspec(novtable) jhtree_decl KeyHdr
     __int64 fileSize; /* fileSize - was once used in the bias calculation e0x */
     short nodeKeyLength; /* key length in intermediate level nodes e8x */
     unsigned short version; /* build version - to be updated if key format changes    eax*/
-    short unused[2]; /* unused ecx */
+    unsigned short extflags; /* extended key type flags (HTREE_* >> 8) ecx */
+    short unused; /* unused eex */
     __int64 blobHead; /* fpos of first blob node f0x */
     __int64 metadataHead; /* fpos of first metadata node f8x */
     __int64 bloomHead; /* fpos of bloom table data, if present 100x */
@@ -169,6 +173,7 @@ public:
     inline unsigned getNodeSize() { return hdr.nodeSize; }
     inline bool hasSpecialFileposition() const { return true; }
     inline bool isRowCompressed() const { return (hdr.ktype & (HTREE_QUICK_COMPRESSED_KEY|HTREE_VARSIZE)) == HTREE_QUICK_COMPRESSED_KEY; }
+    inline bool isLZ4Compressed() const { return (hdr.extflags & (HTREE_LZ4_COMPRESSED_KEY >> 8)) != 0; }
     __uint64 getPartitionFieldMask()
     {
         if (hdr.partitionFieldMask == (__uint64) -1)
@@ -228,12 +233,15 @@ class jhtree_decl CJHTreeNode : public CNodeBase
 protected:
     size32_t keyRecLen;
     char *keyBuf;
+    unsigned __int64 *keyPrefixes = nullptr; // first 8 bytes of each key as a big-endian integer (fixed size keys only)
 
     void unpack(const void *node, bool needCopy);
+    void expandColPrefix(const char *keys);
+    void buildKeyPrefixes();
     unsigned __int64 firstSequence;
     size32_t expandedSize;
 
-    static char *expandKeys(void *src,size32_t &retsize);
+    static char *expandKeys(void *src,size32_t &retsize, bool lz4);
     static void releaseMem(void *togo, size32_t size);
     static void *allocMem(size32_t size);
 
@@ -241,7 +249,7 @@ public:
     CJHTreeNode();
     virtual void load(CKeyHdr *keyHdr, const void *rawData, offset_t pos, bool needCopy);
     ~CJHTreeNode();
-    size32_t getMemSize() { return expandedSize; }
+    size32_t getMemSize() { return expandedSize + (keyPrefixes ? hdr.numKeys * sizeof(unsigned __int64) : 0); }
 
 // reading methods
     offset_t prevNodeFpos() const;
@@ -250,6 +258,8 @@ public:
     virtual size32_t getSizeAt(unsigned int num) const;
     virtual offset_t getFPosAt(unsigned int num) const;
     virtual int compareValueAt(const char *src, unsigned int index) const;
+    unsigned locateGE(const char *src, unsigned minIndex) const;   // index of first key >= src, or getNumKeys()
+    unsigned locateGT(const char *src, unsigned minIndex) const;   // index of first key > src, or getNumKeys()
     bool contains(const char *src) const;
     inline offset_t getRightSib() const { return hdr.rightSib; }
     inline offset_t getLeftSib() const { return hdr.leftSib; }
@@ -346,6 +356,7 @@ class jhtree_decl CWriteNode : public CWriteNodeBase
 {
 private:
     char *lastKeyValue;
+    size32_t lastKeySize = 0;
     unsigned __int64 lastSequence;
 
 public:
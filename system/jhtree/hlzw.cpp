@@ -31,6 +31,7 @@
 #endif
 
 #include "jmisc.hpp"
+#include "jlz4.hpp"
 #include "hlzw.h"
 
 KeyCompressor::~KeyCompressor()
@@ -43,14 +44,16 @@ KeyCompressor::~KeyCompressor()
     }
 }
 
-void KeyCompressor::open(void *blk,int blksize,bool _isVariable, bool rowcompression)
+void KeyCompressor::open(void *blk,int blksize,bool _isVariable, bool rowcompression, bool lz4compression)
 {
     isVariable = _isVariable;
     isBlob = false;
     curOffset = 0;
     ::Release(comp);
     comp = NULL;
-    if (rowcompression&&!_isVariable) {
+    if (lz4compression)
+        comp = createLZ4Compressor(false);
+    else if (rowcompression&&!_isVariable) {
         if (USE_RANDROWDIFF)
             comp = createRandRDiffCompressor();
         else
@@ -100,6 +103,34 @@ int KeyCompressor::writekey(offset_t fPtr, const char *key, unsigned datalength,
     return 1;
 }
 
+int KeyCompressor::writeprefixkey(offset_t fPtr, const char *key, unsigned datalength, KEYRECSIZE_T recordlength)
+{
+    assert(!isBlob);
+    comp->startblock(); // start transaction
+    // first write out the uncompressed length if variable
+    if (isVariable) {
+        KEYRECSIZE_T rs = recordlength;
+        _WINREV(rs);
+        if (comp->write(&rs, sizeof(rs))!=sizeof(rs)) {
+            close();
+            return 0;
+        }
+    }
+    // then write out fpos and the prefix compressed key
+    _WINREV(fPtr);
+    if (comp->write(&fPtr,sizeof(offset_t))!=sizeof(offset_t)) {
+        close();
+        return 0;
+    }
+    if (comp->write(key,datalength)!=datalength) {
+        close();
+        return 0;
+    }
+    comp->commitblock();    // end transaction
+
+    return 1;
+}
+
 unsigned KeyCompressor::writeBlob(const char *data, unsigned datalength)
 {
     assert(isBlob);
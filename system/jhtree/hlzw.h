@@ -29,9 +29,10 @@ class KeyCompressor
 public:
     KeyCompressor() {}
     ~KeyCompressor();
-    void open(void *blk,int blksize, bool isVariable, bool rowcompression);
+    void open(void *blk,int blksize, bool isVariable, bool rowcompression, bool lz4compression);
     void openBlob(void *blk,int blksize);
     int writekey(offset_t fPtr,const char *key,unsigned datalength, unsigned __int64 sequence);
+    int writeprefixkey(offset_t fPtr,const char *key,unsigned datalength, KEYRECSIZE_T recordlength); // key is already prefix compressed
     unsigned writeBlob(const char *data, unsigned datalength);
     void *bufptr() { return (comp==NULL)?bufp:comp->bufptr();}
     int buflen() { return (comp==NULL)?bufl:comp->buflen();}
@@ -46,6 +46,8 @@
 #ifdef __linux__
 #include <alloca.h>
 #endif
+#include <algorithm>
+#include <vector>
 
 #include "hlzw.h"
 
@@ -53,6 +55,7 @@
 #include "jhutil.hpp"
 #include "jmisc.hpp"
 #include "jstats.h"
+#include "jmetrics.hpp"
 #include "ctfile.hpp"
 
 #include "jhtree.ipp"
@@ -68,6 +71,7 @@ static CNodeCache *nodeCache = NULL;
 static CriticalSection *initCrit = NULL;
 
 bool useMemoryMappedIndexes = false;
+bool useKeyPrefixSearch = false;
 bool linuxYield = false;
 bool traceSmartStepping = false;
 bool flushJHtreeCacheOnOOM = true;
@@ -451,6 +455,14 @@ public:
         started = false;
     }
 
+    virtual bool getLowBound(MemoryBuffer &out) const override
+    {
+        if (!keyedSize || !filter->canMatch())
+            return false;
+        filter->setLow(0, out.reserve(keyedSize));
+        return true;
+    }
+
     virtual void append(IKeySegmentMonitor *segment) 
     { 
         assertex(!newFilters && !started);
@@ -688,13 +700,43 @@ static_assert((unsigned)CacheBranch == (unsigned)NodeBranch, "Mismatch Cache Bra
 static_assert((unsigned)CacheLeaf == (unsigned)NodeLeaf, "Mismatch Cache Leaf");
 static_assert((unsigned)CacheBlob == (unsigned)NodeBlob, "Mismatch Cache Blob");
 
+//The cache for each node type can be split into a number of shards, each protected by its own critical section, to
+//reduce contention when many threads are accessing the cache concurrently.  The memory limit for the cache type is
+//divided equally between the active shards, so the total memory used is still bounded by the configured limit.
+constexpr unsigned maxNodeCacheShards = 64;
+
+class CNodeCacheShard
+{
+public:
+    CriticalSection lock;
+    CNodeMRUCache cache;
+};
+
+//Lock a critical section, and count the number of times the lock was already held by another thread
+class CContentionCountingBlock
+{
+    CriticalSection &crit;
+public:
+    inline CContentionCountingBlock(CriticalSection &c, RelaxedAtomic<unsigned> &contended) : crit(c)
+    {
+        if (!crit.tryEnter())
+        {
+            contended++;
+            crit.enter();
+        }
+    }
+    inline ~CContentionCountingBlock() { crit.leave(); }
+};
+
 class CNodeCache : public CInterface
 {
 private:
-    mutable CriticalSection lock[CacheMax];
-    CNodeMRUCache cache[CacheMax];
+    CNodeCacheShard shards[CacheMax][maxNodeCacheShards];
+    size32_t cacheMemLimit[CacheMax] = { 0, 0, 0 };
     bool cacheEnabled[CacheMax] = { false, false, false };
     bool legacyMode = false;
+    std::atomic<unsigned> numShards{1};
+    CriticalSection configCrit;
 public:
     CNodeCache(size32_t maxNodeMem, size32_t maxLeaveMem, size32_t maxBlobMem)
     {
@@ -704,6 +746,7 @@ public:
         // note that each index caches the last blob it unpacked so that sequential blobfetches are still ok
     }
     CJHTreeNode *getNode(INodeLoader *key, unsigned keyID, offset_t pos, NodeType type, IContextLogger *ctx, bool isTLK);
+    bool isCached(unsigned keyID, offset_t pos, NodeType type, bool isTLK);
     void getCacheInfo(ICacheInfoRecorder &cacheInfo);
 
 
@@ -723,20 +766,48 @@ public:
     {
         legacyMode = _value;
     }
+    unsigned setNumShards(unsigned newShards)
+    {
+        if (newShards == 0)
+            newShards = 1;
+        else if (newShards > maxNodeCacheShards)
+            newShards = maxNodeCacheShards;
+
+        CriticalBlock block(configCrit);
+        unsigned oldShards = numShards;
+        if (newShards != oldShards)
+        {
+            //Entries are distributed between shards by a hash of the key, so they need to be discarded when the number changes
+            numShards = newShards;
+            for (unsigned type=0; type < CacheMax; type++)
+                updateShardLimits((CacheType)type);
+            clear();
+        }
+        return oldShards;
+    }
     void clear()
     {
         for (unsigned i=0; i < CacheMax; i++)
         {
-            CriticalBlock block(lock[i]);
-            cache[i].kill();
+            for (unsigned shard=0; shard < maxNodeCacheShards; shard++)
+            {
+                CriticalBlock block(shards[i][shard].lock);
+                shards[i][shard].cache.kill();
+            }
         }
     }
     void traceState(StringBuffer & out)
     {
+        unsigned activeShards = numShards;
         for (unsigned i=0; i < CacheMax; i++)
         {
             out.append(cacheTypeText[i]).append('(');
-            cache[i].traceState(out);
+            for (unsigned shard=0; shard < activeShards; shard++)
+            {
+                if (shard)
+                    out.append(',');
+                shards[i][shard].cache.traceState(out);
+            }
             out.append(") ");
         }
     }
@@ -750,11 +821,29 @@ public:
 protected:
     size32_t setCacheMem(size32_t newSize, CacheType type)
     {
-        CriticalBlock block(lock[type]);
-        unsigned oldV = cache[type].setMemLimit(newSize);
+        CriticalBlock block(configCrit);
+        size32_t oldV = cacheMemLimit[type];
+        cacheMemLimit[type] = newSize;
+        updateShardLimits(type);
         cacheEnabled[type] = (newSize != 0);
         return oldV;
     }
+    void updateShardLimits(CacheType type)
+    {
+        unsigned activeShards = numShards;
+        size32_t totalLimit = cacheMemLimit[type];
+        size32_t shardLimit = (totalLimit == (size32_t)-1) ? totalLimit : totalLimit / activeShards;
+        for (unsigned shard=0; shard < maxNodeCacheShards; shard++)
+        {
+            CriticalBlock block(shards[type][shard].lock);
+            shards[type][shard].cache.setMemLimit(shard < activeShards ? shardLimit : 0);
+        }
+    }
+    inline CNodeCacheShard & queryShard(CacheType type, unsigned hashcode)
+    {
+        unsigned activeShards = numShards.load(std::memory_order_relaxed);
+        return shards[type][(activeShards == 1) ? 0 : hashcode % activeShards];
+    }
 };
 
 static inline CNodeCache *queryNodeCache()
@@ -1103,6 +1192,92 @@ CDiskKeyIndex::CDiskKeyIndex(unsigned _iD, IFileIO *_io, const char *_name, bool
     init(hdr, isTLK);
 }
 
+//Supplies the nodes that were read by a batch of reads to the node cache, reading any others directly
+class CBatchNodeLoader : implements INodeLoader
+{
+    CDiskKeyIndex & key;
+    unsigned num;
+    const FileReadRequest * requests;
+public:
+    CBatchNodeLoader(CDiskKeyIndex & _key, unsigned _num, const FileReadRequest * _requests)
+        : key(_key), num(_num), requests(_requests)
+    {
+    }
+
+    virtual CJHTreeNode * createNode(NodeType type) override { return key.createNode(type); }
+    virtual CJHTreeNode *loadNode(CJHTreeNode * optNode, offset_t offset) override { return key.loadBatchedNode(optNode, offset, num, requests); }
+    virtual CJHTreeNode *locateFirstNode(KeyStatsCollector &stats) override { return key.locateFirstNode(stats); }
+    virtual CJHTreeNode *locateLastNode(KeyStatsCollector &stats) override { return key.locateLastNode(stats); }
+};
+
+unsigned CDiskKeyIndex::prewarmPages(unsigned num, const offset_t * offsets, NodeType type)
+{
+    //Read all the nodes that are not already cached as a single batch, so that the reads are issued concurrently
+    bool isTLK = isTopLevelKey();
+    unsigned nodeSize = keyHdr->getNodeSize();
+    std::vector<FileReadRequest> requests;
+    for (unsigned i=0; i < num; i++)
+    {
+        offset_t pos = offsets[i];
+        if (pos && !cache->isCached(iD, pos, type, isTLK))
+            requests.push_back({ pos, nodeSize, nullptr, 0 });
+    }
+    if (requests.size() <= 1)
+        return CKeyIndex::prewarmPages(num, offsets, type);
+
+    std::sort(requests.begin(), requests.end(), [](const FileReadRequest & l, const FileReadRequest & r) { return l.pos < r.pos; });
+    auto last = std::unique(requests.begin(), requests.end(), [](const FileReadRequest & l, const FileReadRequest & r) { return l.pos == r.pos; });
+    requests.erase(last, requests.end());
+
+    unsigned numRequests = requests.size();
+    MemoryAttr buffer;
+    char * nodeData = (char *)buffer.allocate((memsize_t)numRequests * nodeSize);
+    for (unsigned i=0; i < numRequests; i++)
+        requests[i].data = nodeData + (memsize_t)i * nodeSize;
+
+    try
+    {
+        MTIME_SECTION(queryActiveTimer(), "JHTREE read nodes");
+        readFileBatch(io, numRequests, requests.data());
+    }
+    catch (IException * E)
+    {
+        ::Release(E);
+        return CKeyIndex::prewarmPages(num, offsets, type);
+    }
+
+    CBatchNodeLoader loader(*this, numRequests, requests.data());
+    unsigned loaded = 0;
+    for (unsigned i=0; i < num; i++)
+    {
+        try
+        {
+            Owned<CJHTreeNode> node = cache->getNode(&loader, iD, offsets[i], type, nullptr, isTLK);
+            if (node)
+                loaded++;
+        }
+        catch (IException * E)
+        {
+            ::Release(E);
+        }
+    }
+    return loaded;
+}
+
+CJHTreeNode *CDiskKeyIndex::loadBatchedNode(CJHTreeNode * optNode, offset_t pos, unsigned num, const FileReadRequest * requests)
+{
+    const FileReadRequest * end = requests + num;
+    const FileReadRequest * match = std::lower_bound(requests, end, pos, [](const FileReadRequest & request, offset_t value) { return request.pos < value; });
+    if ((match == end) || (match->pos != pos) || (match->numRead != match->len))
+        return loadNode(optNode, pos);
+
+    nodesLoaded++;
+    char *nodeData = (char *)match->data;
+    if (optNode)
+        return CKeyIndex::loadNode(optNode, nodeData, pos, true);
+    return CKeyIndex::loadNode(nodeData, pos, true);
+}
+
 CJHTreeNode *CDiskKeyIndex::loadNode(CJHTreeNode * optNode, offset_t pos)
 {
     nodesLoaded++;
@@ -1398,6 +1573,17 @@ bool CKeyIndex::prewarmPage(offset_t offset, NodeType type)
     return false;
 }
 
+unsigned CKeyIndex::prewarmPages(unsigned num, const offset_t * offsets, NodeType type)
+{
+    unsigned loaded = 0;
+    for (unsigned i=0; i < num; i++)
+    {
+        if (prewarmPage(offsets[i], type))
+            loaded++;
+    }
+    return loaded;
+}
+
 CJHTreeNode *CKeyIndex::locateFirstNode(KeyStatsCollector &stats)
 {
     keySeeks++;
@@ -1510,7 +1696,10 @@ CKeyCursor::~CKeyCursor()
 
 void CKeyCursor::reset()
 {
-    node.clear();
+    if (node && node->isLeaf())
+        lastLeaf.setown(node.getClear());
+    else
+        node.clear();
     matched = false;
     eof = key.bloomFilterReject(*filter) || !filter->canMatch();
     if (!eof)
@@ -1618,6 +1807,21 @@ bool CKeyCursor::gtEqual(const char *src, char *dst, KeyStatsCollector &stats)
             }
         }
     }
+    else if (lastLeaf)
+    {
+        // After a reset, a seek that falls inside the leaf the previous lookup finished on does not need to walk
+        // down from the root. This is common when a batch of lookups is processed in key order.
+        // NB: src must be strictly greater than the first key, otherwise a match could be in the preceding leaf.
+        unsigned numKeys = lastLeaf->getNumKeys();
+        if (numKeys && (lastLeaf->compareValueAt(src, 0) > 0) && (lastLeaf->compareValueAt(src, numKeys-1) <= 0))
+        {
+            node.setown(lastLeaf.getClear());
+            nodeKey = node->locateGE(src, 0);
+            node->getValueAt(nodeKey, dst);
+            return true;
+        }
+        lastLeaf.clear();
+    }
     if (!lwm)
     {
         node.set(key.rootNode);
@@ -1625,18 +1829,8 @@ bool CKeyCursor::gtEqual(const char *src, char *dst, KeyStatsCollector &stats)
     }
     for (;;)
     {
-        unsigned int a = lwm;
-        int b = node->getNumKeys();
-        // first search for first GTE entry (result in b(<),a(>=))
-        while ((int)a<b)
-        {
-            int i = a+(b-a)/2;
-            int rc = node->compareValueAt(src, i);
-            if (rc>0)
-                a = i+1;
-            else
-                b = i;
-        }
+        // first search for first GTE entry
+        unsigned int a = node->locateGE(src, lwm);
         if (node->isLeaf())
         {
             if (a<node->getNumKeys())
@@ -1706,18 +1900,8 @@ bool CKeyCursor::ltEqual(const char *src, KeyStatsCollector &stats)
     }
     for (;;)
     {
-        unsigned int a = lwm;
-        int b = node->getNumKeys();
         // Locate first record greater than src
-        while ((int)a<b)
-        {
-            int i = a+(b+1-a)/2;
-            int rc = node->compareValueAt(src, i-1);
-            if (rc>=0)
-                a = i;
-            else
-                b = i-1;
-        }
+        unsigned int a = node->locateGT(src, lwm);
         if (node->isLeaf())
         {
             // record we want is the one before first record greater than src.
@@ -2326,6 +2510,7 @@ public:
     virtual bool hasSpecialFileposition() const { return checkOpen().hasSpecialFileposition(); }
     virtual bool needsRowBuffer() const { return checkOpen().needsRowBuffer(); }
     virtual bool prewarmPage(offset_t offset, NodeType type) { return checkOpen().prewarmPage(offset, type); }
+    virtual unsigned prewarmPages(unsigned num, const offset_t * offsets, NodeType type) { return checkOpen().prewarmPages(num, offsets, type); }
     virtual void mergeStats(CRuntimeStatisticCollection & stats) const override
     {
         {
@@ -2396,6 +2581,11 @@ extern jhtree_decl void setLegacyNodeCache(bool _value)
     return queryNodeCache()->setLegacyLocking(_value);
 }
 
+extern jhtree_decl unsigned setNodeCacheShards(unsigned numShards)
+{
+    return queryNodeCache()->setNumShards(numShards);
+}
+
 extern jhtree_decl void getNodeCacheInfo(ICacheInfoRecorder &cacheInfo)
 {
     // MORE - consider reporting root nodes of open IKeyIndexes too?
@@ -2408,10 +2598,14 @@ extern jhtree_decl void getNodeCacheInfo(ICacheInfoRecorder &cacheInfo)
 
 void CNodeCache::getCacheInfo(ICacheInfoRecorder &cacheInfo)
 {
+    unsigned activeShards = numShards;
     for (unsigned i = 0; i < CacheMax; i++)
     {
-        CriticalBlock block(lock[i]);
-        cache[i].reportEntries(cacheInfo);
+        for (unsigned shard = 0; shard < activeShards; shard++)
+        {
+            CriticalBlock block(shards[i][shard].lock);
+            shards[i][shard].cache.reportEntries(cacheInfo);
+        }
     }
 }
 
@@ -2421,6 +2615,14 @@ constexpr StatisticKind loadStatId[CacheMax] = { StCycleNodeLoadCycles, StCycleL
 constexpr RelaxedAtomic<unsigned> * hitMetric[CacheMax] = { &nodeCacheHits, &leafCacheHits, &blobCacheHits };
 constexpr RelaxedAtomic<unsigned> * addMetric[CacheMax] = { &nodeCacheAdds, &leafCacheAdds, &blobCacheAdds };
 constexpr RelaxedAtomic<unsigned> * dupMetric[CacheMax] = { &nodeCacheDups, &leafCacheDups, &blobCacheDups };
+constexpr RelaxedAtomic<unsigned> * contentionMetric[CacheMax] = { &nodeCacheContention, &leafCacheContention, &blobCacheContention };
+
+//Distribution of the time taken to read and expand a node that was not in the cache (10us up to ~160ms)
+static std::shared_ptr<hpccMetrics::HistogramMetric> loadLatencyMetric[CacheMax] = {
+    hpccMetrics::registerHistogramMetric("jhtree.node.load", "Time taken to load a branch node", SMeasureTimeNs, hpccMetrics::createExponentialBuckets(10000, 2, 15)),
+    hpccMetrics::registerHistogramMetric("jhtree.leaf.load", "Time taken to load a leaf node", SMeasureTimeNs, hpccMetrics::createExponentialBuckets(10000, 2, 15)),
+    hpccMetrics::registerHistogramMetric("jhtree.blob.load", "Time taken to load a blob node", SMeasureTimeNs, hpccMetrics::createExponentialBuckets(10000, 2, 15))
+};
 
 //Rather than using a critical section in each node (which can be large and expensive) have an array which is indexed by a function
 //of the key id/file position
@@ -2430,7 +2632,6 @@ static CriticalSection loadCs[numLoadCritSects];
 CJHTreeNode *CNodeCache::getNode(INodeLoader *keyIndex, unsigned iD, offset_t pos, NodeType type, IContextLogger *ctx, bool isTLK)
 {
     // MORE - could probably be improved - I think having the cache template separate is not helping us here
-    // Also one cache per key would surely be faster, and could still use a global total
     if (!pos)
         return NULL;
 
@@ -2452,12 +2653,18 @@ CJHTreeNode *CNodeCache::getNode(INodeLoader *keyIndex, unsigned iD, offset_t po
     //There will be the same number of critical section locks, but loading a page will contend on a different lock - so it should reduce contention.
     //There will be a limit on the number of nodes concurrently being loaded from memory with the new code, where it was unlimited before, but
     //nodes will only be loaded once.
+    //Sharded cache access:
+    //  As the new code, but the entries are distributed between several independent caches (selected by the hash of the key),
+    //  each with its own lock, so that concurrent lookups of different nodes rarely contend.
     CKeyIdAndPos key(iD, pos);
-    CriticalSection & cacheLock = lock[cacheType];
+    unsigned hashcode = hashc(reinterpret_cast<const byte *>(&key), sizeof(key), 0x811C9DC5);
+    CNodeCacheShard & shard = queryShard(cacheType, hashcode);
+    CriticalSection & cacheLock = shard.lock;
+    CNodeMRUCache & cache = shard.cache;
     if (legacyMode)
     {
-        CriticalBlock block(cacheLock);
-        CJHTreeNode *cacheNode = cache[cacheType].query(key);
+        CContentionCountingBlock block(cacheLock, *contentionMetric[cacheType]);
+        CJHTreeNode *cacheNode = cache.query(key);
         if (likely(cacheNode))
         {
             cacheHits++;
@@ -2475,7 +2682,7 @@ CJHTreeNode *CNodeCache::getNode(INodeLoader *keyIndex, unsigned iD, offset_t po
         }
 
         cacheAdds++;
-        cacheNode = cache[cacheType].query(key); // check if added to cache while we were reading
+        cacheNode = cache.query(key); // check if added to cache while we were reading
         if (cacheNode)
         {
             cacheHits++;
@@ -2486,7 +2693,7 @@ CJHTreeNode *CNodeCache::getNode(INodeLoader *keyIndex, unsigned iD, offset_t po
         }
         if (ctx) ctx->noteStatistic(addStatId[cacheType], 1);
         (*addMetric[cacheType])++;
-        cache[cacheType].replace(key, *LINK(node));
+        cache.replace(key, *LINK(node));
         return node.getClear();
     }
     else
@@ -2495,14 +2702,14 @@ CJHTreeNode *CNodeCache::getNode(INodeLoader *keyIndex, unsigned iD, offset_t po
         bool alreadyExists = true;
         {
             CJHTreeNode * node;
-            CriticalBlock block(cacheLock);
+            CContentionCountingBlock block(cacheLock, *contentionMetric[cacheType]);
 
-            node = cache[cacheType].query(key);
+            node = cache.query(key);
             if (unlikely(!node))
             {
                 node = keyIndex->createNode(type);
                 assertex(node->getMemSize() == 0);   // check the reported size is 0 so that the updated size is correct
-                cache[cacheType].replace(key, *node);
+                cache.replace(key, *node);
                 alreadyExists = false;
             }
 
@@ -2534,8 +2741,6 @@ CJHTreeNode *CNodeCache::getNode(INodeLoader *keyIndex, unsigned iD, offset_t po
             if (likely(ownedNode->isReady()))
                 return ownedNode.getClear();
 
-            //Shame that the hash code is recalculated - it might be possible to remove this.
-            unsigned hashcode = hashc(reinterpret_cast<const byte *>(&key), sizeof(key), 0x811C9DC5);
             unsigned whichCs = hashcode % numLoadCritSects;
 
             cycle_t startCycles = get_cycles_now();
@@ -2546,10 +2751,12 @@ CJHTreeNode *CNodeCache::getNode(INodeLoader *keyIndex, unsigned iD, offset_t po
                 CriticalBlock loadBlock(loadCs[whichCs]);
                 if (!ownedNode->isReady())
                 {
+                    cycle_t loadStartCycles = get_cycles_now();
                     keyIndex->loadNode(ownedNode, pos);
+                    loadLatencyMetric[cacheType]->recordMeasurement(cycle_to_nanosec(get_cycles_now() - loadStartCycles));
 
                     //Update the associated size of the entry in the hash table before setting isReady (never evicted until isReady is set)
-                    cache[cacheType].noteReady(*ownedNode);
+                    cache.noteReady(*ownedNode);
                     ownedNode->noteReady();
                 }
                 else
@@ -2566,13 +2773,26 @@ CJHTreeNode *CNodeCache::getNode(INodeLoader *keyIndex, unsigned iD, offset_t po
             {
                 CriticalBlock block(cacheLock);
                 if (!ownedNode->isReady())
-                    cache[cacheType].remove(key);
+                    cache.remove(key);
             }
             throw;
         }
     }
 }
 
+bool CNodeCache::isCached(unsigned iD, offset_t pos, NodeType type, bool isTLK)
+{
+    CacheType cacheType = isTLK ? CacheBranch : (CacheType)type;
+    if ((type == NodeMeta) || (type == NodeBloom) || !cacheEnabled[cacheType])
+        return false;
+
+    CKeyIdAndPos key(iD, pos);
+    unsigned hashcode = hashc(reinterpret_cast<const byte *>(&key), sizeof(key), 0x811C9DC5);
+    CNodeCacheShard & shard = queryShard(cacheType, hashcode);
+    CriticalBlock block(shard.lock);
+    return shard.cache.query(key, false) != nullptr;
+}
+
 RelaxedAtomic<unsigned> cacheAdds;
 RelaxedAtomic<unsigned> cacheHits;
 RelaxedAtomic<unsigned> nodesLoaded;
@@ -2585,6 +2805,9 @@ RelaxedAtomic<unsigned> leafCacheDups;
 RelaxedAtomic<unsigned> nodeCacheHits;
 RelaxedAtomic<unsigned> nodeCacheAdds;
 RelaxedAtomic<unsigned> nodeCacheDups;
+RelaxedAtomic<unsigned> nodeCacheContention;
+RelaxedAtomic<unsigned> leafCacheContention;
+RelaxedAtomic<unsigned> blobCacheContention;
 
 void clearNodeStats()
 {
@@ -2600,6 +2823,9 @@ void clearNodeStats()
     nodeCacheHits.store(0);
     nodeCacheAdds.store(0);
     nodeCacheDups.store(0);
+    nodeCacheContention.store(0);
+    leafCacheContention.store(0);
+    blobCacheContention.store(0);
 }
 
 //------------------------------------------------------------------------------------------------
@@ -3298,13 +3524,13 @@ class IKeyManagerTest : public CppUnit::TestFixture
         removeTestKeys();
     }
 
-    void buildTestKeys(bool variable, bool useTrailingHeader, bool noSeek, bool quickCompressed)
+    void buildTestKeys(bool variable, bool useTrailingHeader, bool noSeek, bool quickCompressed, bool lz4Compressed = false)
     {
-        buildTestKey("keyfile1.$$$", false, variable, useTrailingHeader, noSeek, quickCompressed);
-        buildTestKey("keyfile2.$$$", true, variable, useTrailingHeader, noSeek, quickCompressed);
+        buildTestKey("keyfile1.$$$", false, variable, useTrailingHeader, noSeek, quickCompressed, lz4Compressed);
+        buildTestKey("keyfile2.$$$", true, variable, useTrailingHeader, noSeek, quickCompressed, lz4Compressed);
     }
 
-    void buildTestKey(const char *filename, bool skip, bool variable, bool useTrailingHeader, bool noSeek, bool quickCompressed)
+    void buildTestKey(const char *filename, bool skip, bool variable, bool useTrailingHeader, bool noSeek, bool quickCompressed, bool lz4Compressed)
     {
         OwnedIFile file = createIFile(filename);
         OwnedIFileIO io = file->openShared(IFOcreate, IFSHfull);
@@ -3315,6 +3541,7 @@ class IKeyManagerTest : public CppUnit::TestFixture
         unsigned keyedSize = 10;
         Owned<IKeyBuilder> builder = createKeyBuilder(out, COL_PREFIX | HTREE_FULLSORT_KEY | HTREE_COMPRESSED_KEY |
                 (quickCompressed ? HTREE_QUICK_COMPRESSED_KEY : 0) |
+                (lz4Compressed ? HTREE_LZ4_COMPRESSED_KEY : 0) |
                 (variable ? HTREE_VARSIZE : 0) |
                 (useTrailingHeader ? USE_TRAILING_HEADER : 0) |
                 (noSeek ? TRAILING_HEADER_ONLY : 0),
@@ -3386,7 +3613,7 @@ class IKeyManagerTest : public CppUnit::TestFixture
         key->releaseBlobs();
     }
 protected:
-    void testKeys(bool variable, bool useTrailingHeader, bool noSeek, bool quickCompressed)
+    void testKeys(bool variable, bool useTrailingHeader, bool noSeek, bool quickCompressed, bool lz4Compressed = false)
     {
         const char *json = variable ?
                 "{ \"ty1\": { \"fieldType\": 4, \"length\": 10 }, "
@@ -3406,7 +3633,7 @@ protected:
                 "}";
         Owned<IOutputMetaData> meta = createTypeInfoOutputMetaData(json, false);
         const RtlRecord &recInfo = meta->queryRecordAccessor(true);
-        buildTestKeys(variable, useTrailingHeader, noSeek, quickCompressed);
+        buildTestKeys(variable, useTrailingHeader, noSeek, quickCompressed, lz4Compressed);
         {
             Owned <IKeyIndex> index1 = createKeyIndex("keyfile1.$$$", 0, false);
             Owned <IKeyManager> tlk1 = createLocalKeyManager(recInfo, index1, NULL, false, false);
@@ -3564,6 +3791,33 @@ protected:
             tlk2->releaseSegmentMonitors();
             if (tlk3)
                 tlk3->releaseSegmentMonitors();
+
+            // A batch of single value lookups reusing one cursor, in ascending then descending order
+            Owned <IKeyManager> tlk2d = createLocalKeyManager(recInfo, index2, NULL, false, false);
+            for (pass = 0; pass < 2; pass++)
+            {
+                for (unsigned n = 1; n <= 100; n++)
+                {
+                    i = pass ? 101 - n : n;
+                    sprintf(buf, "%010d", i);
+                    Owned<IStringSet> sset2d = createStringSet(10);
+                    sset2d->addRange(buf, buf);
+                    tlk2d->append(createKeySegmentMonitor(false, sset2d.getClear(), 0, 0, 10));
+                    tlk2d->finishSegmentMonitors();
+                    MemoryBuffer lowBound;
+                    ASSERT(tlk2d->getLowBound(lowBound));
+                    ASSERT(lowBound.length() == 10 && memcmp(lowBound.toByteArray(), buf, 10)==0);
+                    tlk2d->reset();
+                    unsigned matches = 0;
+                    while (tlk2d->lookup(true))
+                    {
+                        ASSERT(memcmp(tlk2d->queryKeyBuffer(), buf, 10)==0);
+                        matches++;
+                    }
+                    ASSERT(matches == ((i % 4) ? 0 : (i == 48) ? 2 : 1));
+                    tlk2d->releaseSegmentMonitors();
+                }
+            }
         }
         clearKeyStoreCache(true);
         removeTestKeys();
@@ -3577,6 +3831,24 @@ protected:
                 for (bool noseek : { false, true })
                     for (bool quick : { true, false })
                         testKeys(var, trail, noseek, quick);
+        for (bool var : { true, false })
+            testKeys(var, false, false, false, true);
+
+        //Check the results are the same when the node cache is partitioned
+        unsigned oldShards = setNodeCacheShards(8);
+        testKeys(true, false, false, true);
+        testKeys(false, false, false, false);
+        setNodeCacheShards(oldShards);
+
+        //Check the results are the same when searching using the key prefix column
+        bool oldPrefixSearch = useKeyPrefixSearch;
+        useKeyPrefixSearch = true;
+        clearNodeCache();
+        for (bool var : { true, false })
+            for (bool quick : { true, false })
+                testKeys(var, false, false, quick);
+        useKeyPrefixSearch = oldPrefixSearch;
+        clearNodeCache();
     }
 };
 
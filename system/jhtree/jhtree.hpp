@@ -117,6 +117,7 @@ interface jhtree_decl IKeyIndex : public IKeyIndexBase
     virtual bool hasSpecialFileposition() const = 0;
     virtual bool needsRowBuffer() const = 0;
     virtual bool prewarmPage(offset_t offset, NodeType type) = 0;
+    virtual unsigned prewarmPages(unsigned num, const offset_t * offsets, NodeType type) = 0; // returns the number of pages now cached
     virtual void mergeStats(CRuntimeStatisticCollection & stats) const = 0;
 };
 
@@ -153,8 +154,13 @@ extern jhtree_decl size32_t setNodeCacheMem(size32_t cacheSize);
 extern jhtree_decl size32_t setLeafCacheMem(size32_t cacheSize);
 extern jhtree_decl size32_t setBlobCacheMem(size32_t cacheSize);
 extern jhtree_decl void setLegacyNodeCache(bool _value);
+// Number of independently locked partitions of each node cache (1 = single lock per cache type).  Clears the cache if changed.
+extern jhtree_decl unsigned setNodeCacheShards(unsigned numShards);
 
 extern jhtree_decl void getNodeCacheInfo(ICacheInfoRecorder &cacheInfo);
+// Allocate expanded node payloads from a dedicated (ideally huge page backed) arena of the given size.  Call once, at startup.
+extern jhtree_decl void setNodeMemoryArena(memsize_t size, bool allowHugePages, bool allowTransparentHugePages, bool preFault);
+extern jhtree_decl StringBuffer &getNodeMemoryStats(StringBuffer &out);
 
 extern jhtree_decl IKeyIndex *createKeyIndex(const char *filename, unsigned crc, bool isTLK);
 extern jhtree_decl IKeyIndex *createKeyIndex(const char *filename, unsigned crc, IFileIO &ifile, unsigned fileIdx, bool isTLK);
@@ -180,10 +186,14 @@ extern jhtree_decl RelaxedAtomic<unsigned> leafCacheDups;
 extern jhtree_decl RelaxedAtomic<unsigned> nodeCacheHits;
 extern jhtree_decl RelaxedAtomic<unsigned> nodeCacheAdds;
 extern jhtree_decl RelaxedAtomic<unsigned> nodeCacheDups;
+extern jhtree_decl RelaxedAtomic<unsigned> nodeCacheContention;
+extern jhtree_decl RelaxedAtomic<unsigned> leafCacheContention;
+extern jhtree_decl RelaxedAtomic<unsigned> blobCacheContention;
 extern jhtree_decl bool linuxYield;
 extern jhtree_decl bool traceSmartStepping;
 extern jhtree_decl bool flushJHtreeCacheOnOOM;
 extern jhtree_decl bool useMemoryMappedIndexes;
+extern jhtree_decl bool useKeyPrefixSearch;     // Build a vectorized search column for fixed size nodes when they are loaded
 extern jhtree_decl void clearNodeStats();
 
 
@@ -283,6 +293,7 @@ interface IKeyManager : public IInterface, extends IIndexReadContext
     virtual void setLayoutTranslator(const IDynamicTransform * trans) = 0;
     virtual void finishSegmentMonitors() = 0;
     virtual void describeFilter(StringBuffer &out) const = 0;
+    virtual bool getLowBound(MemoryBuffer &out) const = 0; // appends lowest keyed value the finished filter can match, false if it cannot match
 
     virtual bool lookupSkip(const void *seek, size32_t seekGEOffset, size32_t seeklen) = 0;
     virtual unsigned getPartition() = 0;  // Use PARTITION() to retrieve partno, if possible, or zero to mean read all
@@ -154,6 +154,7 @@ public:
     virtual bool hasSpecialFileposition() const;
     virtual bool needsRowBuffer() const;
     virtual bool prewarmPage(offset_t page, NodeType type);
+    virtual unsigned prewarmPages(unsigned num, const offset_t * offsets, NodeType type);
  
  // INodeLoader impl.
     virtual CJHTreeNode * createNode(NodeType type) final;
@@ -180,15 +181,18 @@ public:
 
 class jhtree_decl CDiskKeyIndex : public CKeyIndex
 {
+    friend class CBatchNodeLoader;
 private:
     Linked<IFileIO> io;
     void cacheNodes(CNodeCache *cache, offset_t firstnode, bool isTLK);
+    CJHTreeNode *loadBatchedNode(CJHTreeNode * optNode, offset_t pos, unsigned num, const FileReadRequest * requests);
     
 public:
     CDiskKeyIndex(unsigned _iD, IFileIO *_io, const char *_name, bool _isTLK);
 
     virtual const char *queryFileName() { return name.get(); }
     virtual const IFileIO *queryFileIO() const override { return io; }
+    virtual unsigned prewarmPages(unsigned num, const offset_t * offsets, NodeType type) override;
 // INodeLoader impl.
     virtual CJHTreeNode *loadNode(CJHTreeNode * optNode, offset_t offset);
     virtual void mergeStats(CRuntimeStatisticCollection & stats) const override { ::mergeStats(stats, io); }
@@ -201,6 +205,7 @@ protected:
     const IIndexFilterList *filter;
     char *keyBuffer = nullptr;
     Owned<CJHTreeNode> node;
+    Owned<CJHTreeNode> lastLeaf;    // leaf the previous lookup finished on, retained across reset()
     unsigned int nodeKey;
 
     bool eof=false;
@@ -130,6 +130,7 @@ public:
         hdr->extsiz = 4096;
         hdr->length = keyValueSize; 
         hdr->ktype = flags;
+        hdr->extflags = flags >> 8;
         hdr->timeid = 0;
         hdr->clstyp = 1;  // IDX_CLOSE
         hdr->maxkbn = nodeSize-sizeof(NodeHdr);
@@ -146,7 +147,7 @@ public:
         hdr->fposOffset = 0;
         hdr->fileSize = 0;
         hdr->nodeKeyLength = _keyedSize;
-        hdr->version = KEYBUILD_VERSION;
+        hdr->version = (flags & HTREE_LZ4_COMPRESSED_KEY) ? KEYBUILD_LZ4_VERSION : 1; // allow older builds to read keys that do not use new features
         hdr->blobHead = 0;
         hdr->metadataHead = 0;
 
@@ -626,5 +627,19 @@ int compareParts(CInterface * const * _left, CInterface * const * _right)
 
 extern jhtree_decl bool checkReservedMetadataName(const char *name)
 {
-    return strsame(name, "_nodeSize") || strsame(name, "_noSeek") || strsame(name, "_useTrailingHeader");
+    return strsame(name, "_nodeSize") || strsame(name, "_noSeek") || strsame(name, "_useTrailingHeader") || strsame(name, "_leafCompression");
+}
+
+extern jhtree_decl unsigned applyLeafCompression(unsigned flags, const char *leafCompression)
+{
+    if (isEmptyString(leafCompression) || strieq(leafCompression, "lzw"))
+        return flags;
+    if (strieq(leafCompression, "lz4"))
+    {
+        //Row compression takes precedence - it allows rows to be expanded individually
+        if ((flags & HTREE_QUICK_COMPRESSED_KEY) == HTREE_QUICK_COMPRESSED_KEY)
+            return flags;
+        return flags | HTREE_COMPRESSED_KEY | HTREE_LZ4_COMPRESSED_KEY;
+    }
+    throw MakeStringException(0, "Unrecognised index leaf compression '%s'", leafCompression);
 }
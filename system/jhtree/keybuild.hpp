@@ -112,5 +112,7 @@ interface IKeyDesprayer : public IInterface
 
 extern jhtree_decl IKeyDesprayer * createKeyDesprayer(IFile * in, IFileIOStream * out);
 extern jhtree_decl bool checkReservedMetadataName(const char *name);
+// Returns the key builder flags updated for the requested leaf node compression ("lzw" or "lz4")
+extern jhtree_decl unsigned applyLeafCompression(unsigned flags, const char *leafCompression);
 
 #endif
@@ -30,11 +30,26 @@ private:
     unsigned int m_timeout;
 
     ISocket* m_socket;
+    MemoryBuffer m_prefetched;      // data already read from the socket by the caller, returned before reading any more
+
+    void fill(unsigned &readlen)
+    {
+        size32_t remaining = m_prefetched.remaining();
+        if (remaining)
+        {
+            readlen = remaining < BSOCKET_BUFSIZE ? remaining : BSOCKET_BUFSIZE;
+            m_prefetched.read(readlen, m_buf);
+            if (!m_prefetched.remaining())
+                m_prefetched.clear();
+        }
+        else
+            m_socket->read(m_buf, 0, BSOCKET_BUFSIZE, readlen, m_timeout);
+    }
 
 public:
     IMPLEMENT_IINTERFACE;
 
-    BufferedSocket(ISocket* socket);
+    BufferedSocket(ISocket* socket, const void *prefetched, size32_t prefetchedLen);
 
     virtual int readline(char* buf, int maxlen, IMultiException *me)
     { return readline(buf, maxlen, false, me); }
@@ -47,7 +62,7 @@ public:
 };
 
 
-BufferedSocket::BufferedSocket(ISocket* socket)
+BufferedSocket::BufferedSocket(ISocket* socket, const void *prefetched, size32_t prefetchedLen)
 {
     m_timeout = BSOCKET_READ_TIMEOUT;
     
@@ -60,6 +75,8 @@ BufferedSocket::BufferedSocket(ISocket* socket)
     
     m_endptr = 0;
     m_curptr = 0;
+    if (prefetchedLen)
+        m_prefetched.append(prefetchedLen, prefetched);
 };
 
 //always make the size of buf at lease maxlen+1
@@ -100,7 +117,7 @@ int BufferedSocket::readline(char* buf, int maxlen, bool keepcrlf, IMultiExcepti
                         m_curptr = 0;
                         m_endptr = 0;
                         unsigned readlen;
-                        m_socket->read(m_buf, 0, BSOCKET_BUFSIZE, readlen, m_timeout);
+                        fill(readlen);
                         if(readlen > 0)
                         {
                             m_endptr = readlen;
@@ -136,7 +153,7 @@ int BufferedSocket::readline(char* buf, int maxlen, bool keepcrlf, IMultiExcepti
                 m_curptr = 0;
                 m_endptr = 0;
                 unsigned readlen;
-                m_socket->read(m_buf, 0, BSOCKET_BUFSIZE, readlen, m_timeout);
+                fill(readlen);
                 if(readlen <= 0)
                     break;
                 m_endptr = readlen;
@@ -218,7 +235,7 @@ int BufferedSocket::read(char* buf, int maxlen)
             unsigned readlen;
             try
             {
-                m_socket->read(m_buf, 0, BSOCKET_BUFSIZE, readlen, m_timeout);
+                fill(readlen);
             }
             catch (IException *e) 
             {
@@ -278,7 +295,7 @@ int BufferedSocket::read(char* buf, int maxlen)
     return ptr;
 }
 
-IBufferedSocket* createBufferedSocket(ISocket* socket)
+IBufferedSocket* createBufferedSocket(ISocket* socket, const void *prefetched, size32_t prefetchedLen)
 {
-    return new BufferedSocket(socket);
+    return new BufferedSocket(socket, prefetched, prefetchedLen);
 }
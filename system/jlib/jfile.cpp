@@ -17,8 +17,10 @@
 #include "platform.h"
 
 #include <atomic>
+#include <memory>
 #include <unordered_set>
 #include <unordered_map>
+#include <vector>
 
 #ifdef _WIN32
 #include <errno.h>
@@ -42,6 +44,12 @@
 #include <sys/vfs.h>
 #include <sys/sendfile.h>
 #include <sys/inotify.h>
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define _USE_IO_URING
+#include <linux/io_uring.h>
+#endif
+#endif
 #endif
 #if defined (__APPLE__)
 #include <sys/mount.h>
@@ -1883,6 +1891,17 @@ size32_t CFileIO::read(offset_t pos, size32_t len, void * data)
     return (size32_t)numRead;
 }
 
+bool CFileIO::canReadConcurrently()
+{
+    return false;
+}
+
+void CFileIO::readBatch(unsigned num, FileReadRequest * requests)
+{
+    for (unsigned i=0; i < num; i++)
+        requests[i].numRead = read(requests[i].pos, requests[i].len, requests[i].data);
+}
+
 void CFileIO::setPos(offset_t newPos)
 {
     LARGE_INTEGER tempPos;
@@ -1920,6 +1939,239 @@ void CFileIO::setSize(offset_t pos)
 
 //-- Unix implementation ----------------------------------------------------
 
+#ifdef _USE_IO_URING
+
+// The io_uring interface is used directly via the system calls rather than through liburing.  Each thread that issues
+// batched reads has its own ring, so no locking is required.
+
+static constexpr unsigned ioUringQueueDepth = 64;
+static std::atomic<bool> ioUringUnavailable{false};
+
+class CIoUring
+{
+public:
+    CIoUring()
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ringFd = (int)syscall(__NR_io_uring_setup, ioUringQueueDepth, &params);
+        if (ringFd < 0)
+        {
+            //ENOSYS on old kernels, EPERM if it has been disabled (e.g. by a container seccomp profile)
+            DBGLOG("io_uring unavailable (errno %d) - reads will be synchronous", errno);
+            return;
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap)
+        {
+            if (cqRingSize > sqRingSize)
+                sqRingSize = cqRingSize;
+            cqRingSize = 0;
+        }
+        sqRing = mapRing(sqRingSize, IORING_OFF_SQ_RING);
+        cqRing = singleMap ? sqRing : mapRing(cqRingSize, IORING_OFF_CQ_RING);
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = (io_uring_sqe *)mapRing(sqesSize, IORING_OFF_SQES);
+        if (!sqRing || !cqRing || !sqes)
+        {
+            DBGLOG("io_uring ring could not be mapped (errno %d) - reads will be synchronous", errno);
+            closeRing();
+            return;
+        }
+
+        char * sq = (char *)sqRing;
+        sqTail = (unsigned *)(sq + params.sq_off.tail);
+        sqMask = *(unsigned *)(sq + params.sq_off.ring_mask);
+        sqArray = (unsigned *)(sq + params.sq_off.array);
+        sqEntries = params.sq_entries;
+        if (sqEntries > ioUringQueueDepth)
+            sqEntries = ioUringQueueDepth;
+        char * cq = (char *)cqRing;
+        cqHead = (unsigned *)(cq + params.cq_off.head);
+        cqTail = (unsigned *)(cq + params.cq_off.tail);
+        cqMask = *(unsigned *)(cq + params.cq_off.ring_mask);
+        cqes = (io_uring_cqe *)(cq + params.cq_off.cqes);
+    }
+    ~CIoUring()
+    {
+        closeRing();
+    }
+
+    bool isValid() const { return ringFd >= 0; }
+
+    void read(int file, unsigned num, FileReadRequest * requests)
+    {
+        unsigned done = 0;
+        while (done < num)
+        {
+            unsigned batch = num - done;
+            if (batch > sqEntries)
+                batch = sqEntries;
+
+            unsigned tail = *sqTail;
+            for (unsigned i=0; i < batch; i++)
+            {
+                FileReadRequest & request = requests[done+i];
+                iov[i].iov_base = request.data;
+                iov[i].iov_len = request.len;
+                unsigned index = tail & sqMask;
+                io_uring_sqe * sqe = &sqes[index];
+                memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = IORING_OP_READV;
+                sqe->fd = file;
+                sqe->off = request.pos;
+                sqe->addr = (__u64)(memsize_t)&iov[i];
+                sqe->len = 1;
+                sqe->user_data = i;
+                sqArray[index] = index;
+                tail++;
+            }
+            __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+            unsigned submitted = 0;
+            unsigned completed = 0;
+            while (completed < batch)
+            {
+                unsigned head = *cqHead;
+                unsigned available = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+                if (head == available)
+                {
+                    int ret = (int)syscall(__NR_io_uring_enter, ringFd, batch - submitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                    if (ret < 0)
+                    {
+                        if ((errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY))
+                            continue;
+                        throw makeErrnoException(errno, "io_uring_enter");
+                    }
+                    submitted += ret;
+                    continue;
+                }
+                for (; head != available; head++)
+                {
+                    const io_uring_cqe & cqe = cqes[head & cqMask];
+                    results[(unsigned)cqe.user_data] = cqe.res;
+                    completed++;
+                }
+                __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+            }
+
+            //All the reads have completed, so it is now safe to throw an exception
+            for (unsigned i=0; i < batch; i++)
+            {
+                FileReadRequest & request = requests[done+i];
+                int result = results[i];
+                if (result < 0)
+                    request.numRead = checked_pread(file, request.data, request.len, request.pos);   // retry synchronously - reports the error
+                else if ((size32_t)result < request.len)
+                {
+                    //A short read is either the end of the file, or needs completing
+                    size32_t got = (size32_t)result;
+                    if (got)
+                        got += checked_pread(file, (byte *)request.data + got, request.len - got, request.pos + got);
+                    request.numRead = got;
+                }
+                else
+                    request.numRead = request.len;
+            }
+            done += batch;
+        }
+    }
+
+protected:
+    void * mapRing(size_t size, off_t offset)
+    {
+        void * ret = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, offset);
+        return (ret == MAP_FAILED) ? nullptr : ret;
+    }
+    void closeRing()
+    {
+        if (sqes)
+            munmap(sqes, sqesSize);
+        if (cqRing && (cqRing != sqRing))
+            munmap(cqRing, cqRingSize);
+        if (sqRing)
+            munmap(sqRing, sqRingSize);
+        sqes = nullptr;
+        cqRing = nullptr;
+        sqRing = nullptr;
+        if (ringFd >= 0)
+            close(ringFd);
+        ringFd = -1;
+    }
+
+protected:
+    int ringFd = -1;
+    void * sqRing = nullptr;
+    void * cqRing = nullptr;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    size_t sqesSize = 0;
+    io_uring_sqe * sqes = nullptr;
+    unsigned * sqTail = nullptr;
+    unsigned * sqArray = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+    unsigned * cqHead = nullptr;
+    unsigned * cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe * cqes = nullptr;
+    iovec iov[ioUringQueueDepth];
+    int results[ioUringQueueDepth];
+};
+
+static thread_local std::unique_ptr<CIoUring> threadRing;
+
+static bool isIoUringAvailable()
+{
+    return !ioUringUnavailable;
+}
+
+static bool ioUringReadBatch(int file, unsigned num, FileReadRequest * requests)
+{
+    if (ioUringUnavailable)
+        return false;
+    if (!threadRing)
+    {
+        threadRing.reset(new CIoUring);
+        if (!threadRing->isValid())
+        {
+            //The kernel either supports it or not, so avoid trying to create a ring on every thread
+            threadRing.reset();
+            ioUringUnavailable = true;
+            return false;
+        }
+    }
+    try
+    {
+        threadRing->read(file, num, requests);
+    }
+    catch (...)
+    {
+        //The ring may be in an inconsistent state - create a new one next time
+        threadRing.reset();
+        throw;
+    }
+    return true;
+}
+
+#else
+
+static bool isIoUringAvailable()
+{
+    return false;
+}
+
+static bool ioUringReadBatch(int file, unsigned num, FileReadRequest * requests)
+{
+    return false;
+}
+
+#endif
+
+
 // More errorno checking TBD
 CFileIO::CFileIO(HANDLE handle, IFOmode _openmode, IFSHmode _sharemode, IFEflags _extraFlags)
     : unflushedReadBytes(0), unflushedWriteBytes(0)
@@ -2026,6 +2278,31 @@ size32_t CFileIO::read(offset_t pos, size32_t len, void * data)
     return ret;
 }
 
+bool CFileIO::canReadConcurrently()
+{
+    return isIoUringAvailable();
+}
+
+void CFileIO::readBatch(unsigned num, FileReadRequest * requests)
+{
+    if (num > 1)
+    {
+        CCycleTimer timer;
+        if (ioUringReadBatch(file, num, requests))
+        {
+            offset_t totalRead = 0;
+            for (unsigned i=0; i < num; i++)
+                totalRead += requests[i].numRead;
+            stats.ioReadCycles.fetch_add(timer.elapsedCycles());
+            stats.ioReadBytes.fetch_add(totalRead);
+            stats.ioReads.fetch_add(num);
+            return;
+        }
+    }
+    for (unsigned i=0; i < num; i++)
+        requests[i].numRead = read(requests[i].pos, requests[i].len, requests[i].data);
+}
+
 void CFileIO::setPos(offset_t newPos)
 {
     if (file != NULLFILE)
@@ -4317,6 +4594,135 @@ IFileIO * createIORange(IFileIO * io, offset_t header, offset_t length)
     return new CFileRangeIO(io, header, length);
 }
 
+bool canReadFileConcurrently(IFileIO * io)
+{
+    IBatchReadFileIO * batchIO = dynamic_cast<IBatchReadFileIO *>(io);
+    return batchIO && batchIO->canReadConcurrently();
+}
+
+void readFileBatch(IFileIO * io, unsigned num, FileReadRequest * requests)
+{
+    IBatchReadFileIO * batchIO = dynamic_cast<IBatchReadFileIO *>(io);
+    if (batchIO)
+    {
+        batchIO->readBatch(num, requests);
+        return;
+    }
+    for (unsigned i=0; i < num; i++)
+        requests[i].numRead = io->read(requests[i].pos, requests[i].len, requests[i].data);
+}
+
+class CPrefetchFileIO : public CInterfaceOf<IPrefetchFileIO>
+{
+public:
+    CPrefetchFileIO(IFileIO * _io) : io(_io) {}
+
+    virtual size32_t read(offset_t pos, size32_t len, void * data) override
+    {
+        size32_t copied = 0;
+        const FileReadRequest * block = findBlock(pos);
+        if (block)
+        {
+            size32_t offset = (size32_t)(pos - block->pos);
+            copied = block->numRead - offset;
+            if (copied > len)
+                copied = len;
+            memcpy(data, (const byte *)block->data + offset, copied);
+            // A short block means the end of the file was reached
+            if ((copied == len) || (block->numRead < block->len))
+                return copied;
+        }
+        return copied + io->read(pos + copied, len - copied, (byte *)data + copied);
+    }
+    virtual offset_t size() override { return io->size(); }
+    virtual size32_t write(offset_t pos, size32_t len, const void * data) override
+    {
+        clearPrefetched();
+        return io->write(pos, len, data);
+    }
+    virtual offset_t appendFile(IFile *file,offset_t pos,offset_t len) override
+    {
+        clearPrefetched();
+        return io->appendFile(file, pos, len);
+    }
+    virtual void setSize(offset_t size) override
+    {
+        clearPrefetched();
+        io->setSize(size);
+    }
+    virtual void flush() override { io->flush(); }
+    virtual void close() override
+    {
+        clearPrefetched();
+        io->close();
+    }
+    virtual unsigned __int64 getStatistic(StatisticKind kind) override { return io->getStatistic(kind); }
+
+    virtual void prefetch(unsigned num, const offset_t * positions, size32_t len) override
+    {
+        clearPrefetched();
+        if (!num || !len)
+            return;
+        byte * next = (byte *)buffer.ensure((memsize_t)num * len);
+        blocks.resize(num);
+        for (unsigned i=0; i < num; i++)
+        {
+            FileReadRequest & request = blocks[i];
+            request.pos = positions[i];
+            request.len = len;
+            request.data = next;
+            request.numRead = 0;
+            next += len;
+        }
+        try
+        {
+            readFileBatch(io, num, blocks.data());
+        }
+        catch (IException * e)
+        {
+            //Only an optimization - any problem will be reported when the data is read directly
+            e->Release();
+            clearPrefetched();
+        }
+    }
+    virtual void clearPrefetched() override
+    {
+        blocks.clear();
+        lastBlock = 0;
+    }
+
+protected:
+    const FileReadRequest * findBlock(offset_t pos)
+    {
+        //Blocks are normally read in the order they were requested, so start from the last match
+        unsigned num = blocks.size();
+        for (unsigned i=0; i < num; i++)
+        {
+            unsigned cur = lastBlock + i;
+            if (cur >= num)
+                cur -= num;
+            const FileReadRequest & block = blocks[cur];
+            if ((pos >= block.pos) && (pos < block.pos + block.numRead))
+            {
+                lastBlock = cur;
+                return &block;
+            }
+        }
+        return nullptr;
+    }
+
+protected:
+    Linked<IFileIO> io;
+    MemoryAttr buffer;
+    std::vector<FileReadRequest> blocks;
+    unsigned lastBlock = 0;
+};
+
+IPrefetchFileIO * createPrefetchFileIO(IFileIO * io)
+{
+    return new CPrefetchFileIO(io);
+}
+
 IFileIOStream * createBufferedIOStream(IFileIO * io, unsigned bufsize)
 {
     if (bufsize == (unsigned)-1)
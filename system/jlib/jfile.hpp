@@ -212,6 +212,29 @@ interface IFileAsyncIO : extends IFileIO
     virtual IFileAsyncResult *writeAsync(offset_t pos, size32_t len, const void * data) = 0; // data must be available until getResult returns true
 };
 
+struct FileReadRequest
+{
+    offset_t pos;
+    size32_t len;
+    void * data;
+    size32_t numRead;       // filled in by the read - only less than len if the end of the file is reached
+};
+
+// Optionally implemented by an IFileIO that can have several reads outstanding at once (e.g. using io_uring)
+interface IBatchReadFileIO
+{
+    virtual bool canReadConcurrently() = 0;
+    virtual void readBatch(unsigned num, FileReadRequest * requests) = 0;
+};
+
+// An IFileIO that satisfies reads from blocks that were read ahead of time as a single batch (see readFileBatch).
+// Reads that are not covered by a prefetched block go to the underlying file.  Not thread safe.
+interface IPrefetchFileIO : extends IFileIO
+{
+    virtual void prefetch(unsigned num, const offset_t * positions, size32_t len) = 0;    // replaces any blocks previously prefetched
+    virtual void clearPrefetched() = 0;
+};
+
 
 interface IFileIOStream : extends IIOStream
 {
@@ -272,6 +295,9 @@ extern jlib_decl IFileIO * createIFileIO(HANDLE handle,IFOmode mode,IFEflags ext
 extern jlib_decl IDirectoryIterator * createDirectoryIterator(const char * path = NULL, const char * wildcard = NULL, bool sub = false, bool includedirs = true);
 extern jlib_decl IDirectoryIterator * createNullDirectoryIterator();
 extern jlib_decl IFileIO * createIORange(IFileIO * file, offset_t header, offset_t length);     // restricts input/output to a section of a file.
+extern jlib_decl void readFileBatch(IFileIO * file, unsigned num, FileReadRequest * requests);     // reads are issued concurrently if the file supports it
+extern jlib_decl bool canReadFileConcurrently(IFileIO * file);    // is it worth issuing a batch of reads ahead of when they are needed?
+extern jlib_decl IPrefetchFileIO * createPrefetchFileIO(IFileIO * file);
 
 extern jlib_decl IFileIOStream * createIOStream(IFileIO * file);        // links argument
 extern jlib_decl IFileIOStream * createNoSeekIOStream(IFileIOStream * stream);  // links argument
@@ -88,7 +88,7 @@ protected:
 };
 
 
-class jlib_decl CFileIO : implements IFileIO, public CInterface
+class jlib_decl CFileIO : implements IFileIO, implements IBatchReadFileIO, public CInterface
 {
 public:
     CFileIO(HANDLE,IFOmode _openmode,IFSHmode _sharemode,IFEflags _extraFlags);
@@ -96,6 +96,8 @@ public:
     IMPLEMENT_IINTERFACE
 
     virtual size32_t read(offset_t pos, size32_t len, void * data);
+    virtual bool canReadConcurrently();
+    virtual void readBatch(unsigned num, FileReadRequest * requests);
     virtual offset_t size();
     virtual size32_t write(offset_t pos, size32_t len, const void * data);
     virtual void setSize(offset_t size);
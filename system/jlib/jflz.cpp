@@ -647,6 +647,7 @@ class jlib_decl CFastLZCompressor : public CFcmpCompressor
             {
                 inlen -= inlenblk;
                 memmove(inbuf,inbuf+toflush,inlen);
+                inlenblk = 0; // the uncommitted block now starts at the beginning of the buffer
             }
             setinmax();
             return;
@@ -1105,7 +1105,7 @@ void PostMortemLogMsgHandler::handleMessage(const LogMsg & msg)
     {
         checkRollover();
         msg.fprintTable(handle, messageFields);
-        if(flushes)
+        if(flushes && !isLogMsgFlushDeferred())
             fflush(handle);
         linesInCurrent++;
     }
@@ -1444,28 +1444,53 @@ void CLogMsgManager::MsgProcessor::push(LogMsg * msg)
     q.enqueue(msg);
 }
 
+static thread_local bool deferLogMsgFlush = false;
+
+bool isLogMsgFlushDeferred()
+{
+    return deferLogMsgFlush;
+}
+
 int CLogMsgManager::MsgProcessor::run()
 {
-    Owned<LogMsg> msg;
     while(more)
     {
-        msg.setown(q.dequeueAndNotify(this)); // notify locks mutex on non-null return
+        LogMsg * msg = q.dequeueAndNotify(this); // notify locks mutex on non-null return
         if(!msg)
             break;
-        owner->doReport(*msg);
+        processBatch(msg);
         pullCycleMutex.unlock();
     }
     while(true)
     {
-        msg.setown(q.dequeueNowAndNotify(this)); // notify locks mutex on non-null return
+        LogMsg * msg = q.dequeueNowAndNotify(this); // notify locks mutex on non-null return
         if(!msg)
             break;
-        owner->doReport(*msg);
+        processBatch(msg);
         pullCycleMutex.unlock();
     }
     return 0;
 }
 
+// Write any other messages that are already queued along with the first one, so the handlers are flushed once per
+// batch rather than once per message.  pullCycleMutex is held throughout, so flush() waits for the whole batch.
+void CLogMsgManager::MsgProcessor::processBatch(LogMsg * first)
+{
+    Owned<LogMsg> msg(first);
+    deferLogMsgFlush = true;
+    for (unsigned count = 1;; count++)
+    {
+        owner->doReport(*msg);
+        if (count == maxMsgBatchSize)
+            break;
+        msg.setown(q.dequeueNow());
+        if (!msg)
+            break;
+    }
+    deferLogMsgFlush = false;
+    owner->flushMonitors();
+}
+
 void CLogMsgManager::MsgProcessor::notify(LogMsg *)
 {
     pullCycleMutex.lock();
@@ -1507,6 +1532,7 @@ void CLogMsgManager::MsgProcessor::drop()
         if(!msg) break;
         DropLogMsg * dmsg = dynamic_cast<DropLogMsg *>(msg.get());
         if(dmsg) prev += dmsg->queryCount()-1;
+        else numDropped.fetch_add(1, std::memory_order_relaxed);
         lastMsg.setown(msg.getClear());
     }
     if(lastMsg)
@@ -1767,6 +1793,18 @@ void CLogMsgManager::doReport(const LogMsg & msg) const
     }
 }
 
+// Only the handlers that would have flushed each message skip it while a batch is written, so only they need flushing
+void CLogMsgManager::flushMonitors() const
+{
+    ReadLockBlock block(monitorLock);
+    ForEachItemIn(i, monitors)
+    {
+        ILogMsgHandler * handler = monitors.item(i).queryHandler();
+        if (handler->queryFlushes())
+            handler->flush();
+    }
+}
+
 void CLogMsgManager::panic(char const * reason) const
 {
     fprintf(stderr, "%s", reason); // not sure there's anything more useful we can do here
@@ -2340,6 +2378,7 @@ public:
     virtual void              setQueueDroppingLimit(unsigned lim, unsigned numToDrop) override {}
     virtual void              resetQueueLimit() override {}
     virtual bool              flushQueue(unsigned timeout) override { return true; }
+    virtual unsigned __int64  queryDroppedMessages() const override { return 0; }
     virtual void              resetMonitors() override {}
     virtual void              report(const LogMsgCategory & cat, const char * format, ...) override {}
     virtual void              report_va(const LogMsgCategory & cat, const char * format, va_list args) override {}
@@ -642,6 +642,7 @@ interface jlib_decl ILogMsgHandler : public IInterface
     virtual void              setMessageFields(unsigned _fields = MSGFIELD_all) = 0;
     virtual void              addToPTree(IPropertyTree * parent) const = 0;
     virtual int               flush() { return 0; }
+    virtual bool              queryFlushes() const { return false; }     // true if the handler flushes after every message
     virtual bool              getLogName(StringBuffer &name) const = 0;
     virtual offset_t          getLogPosition(StringBuffer &logFileName) const = 0;
 };
@@ -697,6 +698,7 @@ interface jlib_decl ILogMsgManager : public ILogMsgListener
     virtual void              setQueueDroppingLimit(unsigned lim, unsigned numToDrop) = 0;
     virtual void              resetQueueLimit() = 0;
     virtual bool              flushQueue(unsigned timeout) = 0;
+    virtual unsigned __int64  queryDroppedMessages() const = 0;
     virtual void              resetMonitors() = 0;
     virtual void              report(const LogMsgCategory & cat, const char * format, ...) __attribute__((format(printf, 3, 4))) = 0;
     virtual void              report_va(const LogMsgCategory & cat, const char * format, va_list args) = 0;
@@ -862,7 +864,7 @@ extern jlib_decl ILogMsgHandler * queryStderrLogMsgHandler();
 extern jlib_decl void setupContainerizedLogMsgHandler();
 #endif
 
-//extern jlib_decl ILogMsgManager * createLogMsgManager(); // use with care! (needed by mplog listener facility)
+extern jlib_decl ILogMsgManager * createLogMsgManager(); // use with care! (needed by mplog listener facility)
 
 extern jlib_decl void setDefaultJobId(const char *id, bool threaded = false);
 extern jlib_decl void setDefaultJobId(LogMsgJobId id, bool threaded = false);
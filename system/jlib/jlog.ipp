@@ -31,8 +31,14 @@
 #include "jregexp.hpp"
 
 static unsigned const defaultMsgQueueLimit = 256;
+static unsigned const maxMsgBatchSize = 256; // maximum number of queued messages written before the handlers are flushed
 static LogMsgCategory const dropWarningCategory(MSGAUD_operator, MSGCLS_error, 0);
 
+// True while the queue processor is writing a batch of messages - file handlers then skip the per-message flush,
+// and are flushed once when the batch is complete.
+
+extern jlib_decl bool isLogMsgFlushDeferred();
+
 // Initial size of StringBuffer used to build output in LogMsg::toString methods
 
 #define LOG_MSG_FORMAT_BUFFER_LENGTH 1024
@@ -480,6 +486,7 @@ public:
     unsigned                  queryMessageFields() const { return messageFields; }
     void                      setMessageFields(unsigned _fields) { messageFields = _fields; }
     int                       flush() { CriticalBlock block(crit); return fflush(handle); }
+    bool                      queryFlushes() const { return flushes; }
     char const *              disable();
     void                      enable();
     bool                      getLogName(StringBuffer &name) const { name.append(filename); return true; }
@@ -500,7 +507,7 @@ class FileLogMsgHandlerXML : implements FileLogMsgHandler, public CInterface
 public:
     FileLogMsgHandlerXML(const char * _filename, const char * _headerText = 0, unsigned _fields = MSGFIELD_all, bool _append = false, bool _flushes = true) : FileLogMsgHandler(_filename, _headerText, _fields, _append, _flushes) {}
     IMPLEMENT_IINTERFACE;
-    void                      handleMessage(const LogMsg & msg) { CriticalBlock block(crit); msg.fprintXML(handle, messageFields); if(flushes) fflush(handle); }
+    void                      handleMessage(const LogMsg & msg) { CriticalBlock block(crit); msg.fprintXML(handle, messageFields); if(flushes && !isLogMsgFlushDeferred()) fflush(handle); }
     bool                      needsPrep() const { return false; }
     void                      prep() {}
     void                      addToPTree(IPropertyTree * tree) const;
@@ -511,7 +518,7 @@ class FileLogMsgHandlerTable : implements FileLogMsgHandler, public CInterface
 public:
     FileLogMsgHandlerTable(const char * _filename, const char * _headerText = 0, unsigned _fields = MSGFIELD_all, bool _append = false, bool _flushes = true) : FileLogMsgHandler(_filename, _headerText, _fields, _append, _flushes), prepped(false) {}
     IMPLEMENT_IINTERFACE;
-    void                      handleMessage(const LogMsg & msg) { CriticalBlock block(crit); msg.fprintTable(handle, messageFields); if(flushes) fflush(handle); }
+    void                      handleMessage(const LogMsg & msg) { CriticalBlock block(crit); msg.fprintTable(handle, messageFields); if(flushes && !isLogMsgFlushDeferred()) fflush(handle); }
     bool                      needsPrep() const { return !prepped; }
     void                      prep() { CriticalBlock block(crit); LogMsg::fprintTableHead(handle, messageFields); prepped = true; }
     void                      addToPTree(IPropertyTree * tree) const;
@@ -531,6 +538,7 @@ public:
     virtual void setMessageFields(unsigned _fields) override { messageFields = _fields; }
     virtual void addToPTree(IPropertyTree * tree) const override;
     virtual int flush() override { CriticalBlock block(crit); return fflush(handle); }
+    virtual bool queryFlushes() const override { return flushes; }
     virtual bool getLogName(StringBuffer &name) const override { CriticalBlock block(crit); name.append(filename); return true; }
     virtual offset_t getLogPosition(StringBuffer &name) const override { CriticalBlock block(crit); fflush(handle); name.append(filename); return ftell(handle); }
 protected:
@@ -570,7 +578,7 @@ public:
         else
             msg.fprintTable(handle, messageFields);
 
-        if(flushes) fflush(handle);
+        if(flushes && !isLogMsgFlushDeferred()) fflush(handle);
     }
     bool                      needsPrep() const { return false; }
     void                      prep() {}
@@ -578,6 +586,7 @@ public:
     void                      setMessageFields(unsigned _fields) { messageFields = _fields; }
     void                      addToPTree(IPropertyTree * tree) const;
     int                       flush() { CriticalBlock block(crit); return fflush(handle); }
+    bool                      queryFlushes() const { return flushes; }
     bool                      getLogName(StringBuffer &name) const { CriticalBlock block(crit); name.append(filename); return true; }
     offset_t                  getLogPosition(StringBuffer &name) const { CriticalBlock block(crit); fflush(handle); name.append(filename); return ftell(handle); }
 protected:
@@ -689,9 +698,11 @@ private:
         void setDroppingLimit(unsigned lim, unsigned num);
         void resetLimit();
         bool flush(unsigned timeout);
+        unsigned __int64 queryDropped() const { return numDropped.load(std::memory_order_relaxed); }
 
     private:
         void drop();
+        void processBatch(LogMsg * first);
 
     private:
         CLogMsgManager * owner;
@@ -699,6 +710,7 @@ private:
         CallbackInterThreadQueueOf<LogMsg, MsgProcessor, false> q;
         unsigned droppingLimit;
         unsigned numToDrop = 1;
+        std::atomic<unsigned __int64> numDropped{0};
         Mutex pullCycleMutex;
     };
     Owned<MsgProcessor> processor;
@@ -715,6 +727,7 @@ public:
     void                      setQueueDroppingLimit(unsigned lim, unsigned numToDrop);
     void                      resetQueueLimit();
     bool                      flushQueue(unsigned timeout) { if(processor) return processor->flush(timeout); else return true; }
+    unsigned __int64          queryDroppedMessages() const { return processor ? processor->queryDropped() : 0; }
     void                      report(const LogMsgCategory & cat, const char * format, ...) __attribute__((format(printf,3,4)));
     void                      report_va(const LogMsgCategory & cat, const char * format, va_list args) __attribute__((format(printf,3,0)));
     void                      mreport_direct(const LogMsgCategory & cat, const LogMsgJobInfo & job, const char * msg);
@@ -764,6 +777,7 @@ private:
     void                      buildPrefilter();
     void                      pushMsg(LogMsg * msg);
     void                      doReport(const LogMsg & msg) const;
+    void                      flushMonitors() const;
     void                      panic(char const * reason) const;
     aindex_t                  findChild(ILogMsgLinkToChild * child) const;
 
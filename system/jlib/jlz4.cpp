@@ -92,6 +92,7 @@ protected:
             {
                 inlen -= inlenblk;
                 memmove(inbuf,inbuf+toflush,inlen);
+                inlenblk = 0; // the uncommitted block now starts at the beginning of the buffer
             }
             setinmax();
             return;
@@ -11,6 +11,7 @@
     limitations under the License.
 ############################################################################## */
 
+#include <algorithm>
 #include "jmetrics.hpp"
 #include "jlog.hpp"
 
@@ -240,6 +241,105 @@ const char *MetricsManager::queryUnitsString(StatisticMeasure units) const
 }
 
 
+static const std::vector<__uint64> noBucketLimits;
+
+const std::vector<__uint64> &MetricBase::queryBucketLimits() const
+{
+    return noBucketLimits;
+}
+
+
+static std::atomic<unsigned> nextHistogramShard{0};
+static thread_local unsigned histogramShard = (unsigned)-1;
+
+HistogramMetric::HistogramMetric(const char *name, const char *description, StatisticMeasure _units, const std::vector<__uint64> &_bucketLimits, const MetricMetaData &_metaData) :
+    MetricBase(name, description, METRICS_HISTOGRAM, _units, _metaData),
+    bucketLimits{_bucketLimits}
+{
+    assertex(std::is_sorted(bucketLimits.begin(), bucketLimits.end()));
+    constexpr unsigned countersPerLine = CACHE_LINE_SIZE / sizeof(RelaxedAtomic<__uint64>);
+    unsigned numCounters = bucketLimits.size() + 2;     // one per bucket, the overflow bucket, and the sum
+    shardStride = ((numCounters + countersPerLine - 1) / countersPerLine) * countersPerLine;
+
+    unsigned totalCounters = shardStride * numShards + countersPerLine - 1;
+    counterMemory.reset(new RelaxedAtomic<__uint64>[totalCounters]);
+    for (unsigned i=0; i < totalCounters; i++)
+        counterMemory[i] = 0;
+    memsize_t misalignment = ((memsize_t)counterMemory.get()) % CACHE_LINE_SIZE;
+    counters = counterMemory.get();
+    if (misalignment)
+        counters += (CACHE_LINE_SIZE - misalignment) / sizeof(RelaxedAtomic<__uint64>);
+}
+
+
+void HistogramMetric::recordMeasurement(__uint64 measurement)
+{
+    unsigned shard = histogramShard;
+    if (unlikely(shard == (unsigned)-1))
+    {
+        shard = nextHistogramShard.fetch_add(1, std::memory_order_relaxed) % numShards;
+        histogramShard = shard;
+    }
+
+    unsigned bucket = std::lower_bound(bucketLimits.begin(), bucketLimits.end(), measurement) - bucketLimits.begin();
+    RelaxedAtomic<__uint64> *shardCounters = queryShard(shard);
+    shardCounters[bucket].fetch_add(1);
+    shardCounters[bucketLimits.size()+1].fetch_add(measurement);
+}
+
+
+__uint64 HistogramMetric::queryValue() const
+{
+    unsigned numBuckets = bucketLimits.size() + 1;
+    __uint64 total = 0;
+    for (unsigned shard=0; shard < numShards; shard++)
+    {
+        const RelaxedAtomic<__uint64> *shardCounters = queryShard(shard);
+        for (unsigned bucket=0; bucket < numBuckets; bucket++)
+            total += shardCounters[bucket];
+    }
+    return total;
+}
+
+
+std::vector<__uint64> HistogramMetric::queryBucketValues() const
+{
+    unsigned numBuckets = bucketLimits.size() + 1;
+    std::vector<__uint64> values(numBuckets, 0);
+    for (unsigned shard=0; shard < numShards; shard++)
+    {
+        const RelaxedAtomic<__uint64> *shardCounters = queryShard(shard);
+        for (unsigned bucket=0; bucket < numBuckets; bucket++)
+            values[bucket] += shardCounters[bucket];
+    }
+    return values;
+}
+
+
+__uint64 HistogramMetric::querySum() const
+{
+    unsigned sumIndex = bucketLimits.size() + 1;
+    __uint64 sum = 0;
+    for (unsigned shard=0; shard < numShards; shard++)
+        sum += queryShard(shard)[sumIndex];
+    return sum;
+}
+
+
+std::vector<__uint64> hpccMetrics::createExponentialBuckets(__uint64 first, unsigned factor, unsigned count)
+{
+    std::vector<__uint64> limits;
+    limits.reserve(count);
+    __uint64 limit = first;
+    for (unsigned i=0; i < count; i++)
+    {
+        limits.push_back(limit);
+        limit *= factor;
+    }
+    return limits;
+}
+
+
 PeriodicMetricSink::PeriodicMetricSink(const char *name, const char *type, const IPropertyTree *pSettingsTree) :
     MetricSink(name, type),
     collectionPeriodSeconds{60}
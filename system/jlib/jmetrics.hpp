@@ -42,7 +42,8 @@ MetricsManager jlib_decl &queryMetricsManager();
 enum MetricType
 {
     METRICS_COUNTER,
-    METRICS_GAUGE
+    METRICS_GAUGE,
+    METRICS_HISTOGRAM
 };
 
 
@@ -96,6 +97,22 @@ interface IMetric
      * Get the units for the metric
      */
     virtual StatisticMeasure queryUnits() const = 0;
+
+    /*
+     * Histogram metrics only - the inclusive upper limit of each bucket (empty for other metric types)
+     */
+    virtual const std::vector<__uint64> &queryBucketLimits() const = 0;
+
+    /*
+     * Histogram metrics only - the number of measurements in each bucket, with one extra
+     * trailing entry for measurements above the last limit
+     */
+    virtual std::vector<__uint64> queryBucketValues() const = 0;
+
+    /*
+     * Histogram metrics only - the sum of all the measurements
+     */
+    virtual __uint64 querySum() const = 0;
 };
 
 
@@ -112,6 +129,9 @@ public:
     virtual MetricType queryMetricType() const override { return metricType; }
     const MetricMetaData &queryMetaData() const { return metaData; }
     StatisticMeasure queryUnits() const override { return units; }
+    virtual const std::vector<__uint64> &queryBucketLimits() const override;
+    virtual std::vector<__uint64> queryBucketValues() const override { return std::vector<__uint64>(); }
+    virtual __uint64 querySum() const override { return 0; }
 
 
 protected:
@@ -237,6 +257,43 @@ protected:
 };
 
 
+/*
+ * Metric used to track the distribution of a measurement (e.g. a latency) across a fixed set of buckets.
+ * Updates are lock free; the counts are spread over several cache line aligned shards, selected per
+ * thread, so that concurrent updates from different threads do not contend on the same cache line.
+ * queryValue() returns the total number of measurements.
+ */
+class jlib_decl HistogramMetric : public MetricBase
+{
+public:
+    HistogramMetric(const char *name, const char *description, StatisticMeasure _units, const std::vector<__uint64> &_bucketLimits, const MetricMetaData &_metaData = MetricMetaData());
+
+    void recordMeasurement(__uint64 measurement);
+
+    virtual __uint64 queryValue() const override;
+    virtual const std::vector<__uint64> &queryBucketLimits() const override { return bucketLimits; }
+    virtual std::vector<__uint64> queryBucketValues() const override;
+    virtual __uint64 querySum() const override;
+
+protected:
+    static constexpr unsigned numShards = 16;
+
+    inline RelaxedAtomic<__uint64> *queryShard(unsigned shard) const { return counters + shard * shardStride; }
+
+protected:
+    std::vector<__uint64> bucketLimits;
+    unsigned shardStride = 0;                                 // counters per shard - buckets + overflow + sum, rounded up to a cache line
+    std::unique_ptr<RelaxedAtomic<__uint64>[]> counterMemory;
+    RelaxedAtomic<__uint64> *counters = nullptr;              // cache line aligned start of counterMemory
+};
+
+
+/*
+ * Convenience function to create an exponential sequence of bucket limits: first, first*factor, ...
+ */
+extern jlib_decl std::vector<__uint64> createExponentialBuckets(__uint64 first, unsigned factor, unsigned count);
+
+
 class jlib_decl MetricSink
 {
 public:
@@ -350,6 +407,14 @@ inline std::shared_ptr<GaugeMetricFromCounters> registerGaugeFromCountersMetric(
 }
 
 
+inline std::shared_ptr<HistogramMetric> registerHistogramMetric(const char *name, const char* desc, StatisticMeasure units, const std::vector<__uint64> &bucketLimits, const MetricMetaData &metaData = MetricMetaData())
+{
+    std::shared_ptr<HistogramMetric> pMetric = std::make_shared<HistogramMetric>(name, desc, units, bucketLimits, metaData);
+    queryMetricsManager().addMetric(pMetric);
+    return pMetric;
+}
+
+
 template <typename T>
 std::shared_ptr<CustomMetric<T>> registerCustomMetric(const char *name, const char *desc, MetricType metricType, T &value, StatisticMeasure units, const MetricMetaData &metaData = MetricMetaData())
 {
@@ -245,6 +245,21 @@ public:
 #endif
         LeaveCriticalSection(&flags);
     };
+    inline bool tryEnter()
+    {
+        if (!TryEnterCriticalSection(&flags))
+            return false;
+#ifdef _ASSERT_LOCK_SUPPORT
+        if (owner)
+        {
+            assertex(owner==GetCurrentThreadId());
+            depth++;
+        }
+        else
+            owner = GetCurrentThreadId();
+#endif
+        return true;
+    };
     inline void assertLocked()
     {
 #ifdef _ASSERT_LOCK_SUPPORT
@@ -320,6 +335,23 @@ public:
 #endif
         pthread_mutex_unlock(&mutex);
     }
+
+    /// Returns true if the lock was acquired without waiting, false if it is held by another thread.
+    inline bool tryEnter()
+    {
+        if (pthread_mutex_trylock(&mutex) != 0)
+            return false;
+#ifdef _ASSERT_LOCK_SUPPORT
+        if (owner)
+        {
+            assertex(owner==GetCurrentThreadId());
+            depth++;
+        }
+        else
+            owner = GetCurrentThreadId();
+#endif
+        return true;
+    }
     inline void assertLocked()
     {
 #ifdef _ASSERT_LOCK_SUPPORT
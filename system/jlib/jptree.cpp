@@ -2154,7 +2154,7 @@ bool PTree::isArray(const char *xpath) const
             }
             else
             {
-                IPropertyTree *child = children->query(xpath);
+                IPropertyTree *child = checkChildren() ? children->query(xpath) : nullptr;
                 if (child)
                 {
                     PTree *tree = static_cast<PTree *>(child);
@@ -2383,7 +2383,7 @@ bool PTree::removeProp(const char *xpath)
             if (']' == *xxpath) // so it's a digit index!
             {
                 StringAttr id(prop, idEnd-prop);
-                PTree *child = children?(PTree *)children->query(id):NULL;
+                PTree *child = checkChildren()?(PTree *)children->query(id):NULL;
                 if (child)
                 {
                     if (child->value && child->value->isArray() && child->value->elements()>1)
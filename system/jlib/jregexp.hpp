@@ -117,6 +117,7 @@ public:
     unsigned getMatch(unsigned maxLength, const char * text, unsigned & matchLen);
     bool queryAddEntry(unsigned len, const char * text, unsigned action);
     void reset()            {   freeLevel(firstLevel); }
+    bool canStartMatch(byte next) const { return firstLevel[next].value || firstLevel[next].table; }
 
 protected:
     struct entry { unsigned value; entry * table; };
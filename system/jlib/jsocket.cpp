@@ -46,6 +46,7 @@
 #else
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/tcp.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -2193,7 +2194,6 @@ size32_t CSocket::udp_write_to(const SocketEndpoint &ep, void const* buf, size32
 size32_t CSocket::write_multiple(unsigned num,const void **buf, size32_t *size)
 {
     assertex(sockmode!=sm_udp_server);
-    assertex(!nonblocking);
     if (num==1)
         return write(buf[0],size[0]);
     size32_t total = 0;
@@ -2209,6 +2209,7 @@ size32_t CSocket::write_multiple(unsigned num,const void **buf, size32_t *size)
     }
     size32_t res=0;
 #ifdef _WIN32
+    assertex(!nonblocking);
     WSABUF *bufs = (WSABUF *)alloca(sizeof(WSABUF)*num);
     for (i=0;i<num;i++) {
         bufs[i].buf = (char *)buf[i];
@@ -2243,6 +2244,7 @@ EintrRetry:
     res = sent;
 #else
 #ifdef USE_CORK
+    assertex(!nonblocking);
     if (total>1024) {
         class Copt
         {
@@ -2280,47 +2282,72 @@ EintrRetry:
         res = write(b,total);
     }
 #else
-    // send in equal chunks about 64K
-    unsigned n = (total+0xffff)/0x10000;
-    size32_t outbufsize = (total+n-1)/n;
-    MemoryAttr ma;
-    byte *outbuf = (byte *)ma.allocate(outbufsize);
-    i = 0;
-    size32_t os = 0;
-    size32_t left = total;
-    byte *b = NULL;
-    size32_t s=0;
-    for (;;) {
-        while (!s&&(i<num)) {
-            b = (byte *)buf[i];
-            s = size[i];
-            i++;
+    // gather the blocks straight from the callers buffers, rather than copying them into a contiguous buffer first
+    struct iovec *iov = (struct iovec *)alloca(sizeof(struct iovec)*num);
+    unsigned niov = 0;
+    for (i=0;i<num;i++) {
+        if (size[i]) {
+            iov[niov].iov_base = (void *)buf[i];
+            iov[niov].iov_len = size[i];
+            niov++;
         }
-        if ((os==0)&&(s==left)) {
-            write(b,s);     // go for it
-            break;
+    }
+    struct iovec *next = iov;
+    while (niov) {
+        if (state != ss_open) {
+            THROWJSOCKEXCEPTION(JSOCKERR_not_opened);
         }
-        else {
-            size32_t cpy = outbufsize-os;
-            if (cpy>s)
-                cpy = s;
-            memcpy(outbuf+os,b,cpy);
-            os += cpy;
-            left -= cpy;
-            s -= cpy;
-            b += cpy;
-            if (left==0)  {
-                write(outbuf,os);       
-                break;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = next;
+        msg.msg_iovlen = (niov > IOV_MAX) ? IOV_MAX : niov;
+        unsigned retrycount=100;
+EintrRetry:
+        ssize_t rc = sendmsg(sock, &msg, SEND_FLAGS);
+        if (rc < 0) {
+            int err=ERRNO();
+            if (BADSOCKERR(err)) {
+                LOGERR2(err,8,"Socket closed during write");
+                rc = 0;
             }
-            else if (os==outbufsize) {
-                write(outbuf,os);   
-                os = 0;
+            else if ((err==JSE_INTR)&&(retrycount--!=0)) {
+                LOGERR2(err,8,"EINTR retrying");
+                goto EintrRetry;
             }
+            else {
+                LOGERR2(err,8,"write_multiple");
+                if ((err==JSE_CONNRESET)||(err==JSE_INTR)||(err==JSE_CONNABORTED)||(err==EPIPE)||(err==JSE_TIMEDOUT)) {
+                    errclose();
+                    err = JSOCKERR_broken_pipe;
+                }
+                if (((err == JSE_WOULDBLOCK) || (err == EAGAIN)) && nonblocking)
+                    break;
+                THROWJSOCKEXCEPTION(err);
+            }
+        }
+        if (rc == 0) {
+            state = ss_shutdown;
+            THROWJSOCKEXCEPTION(JSOCKERR_graceful_close);
+        }
+        res += rc;
+        if (nonblocking)
+            break; // as write(), return what was sent, the caller resends the remainder
+
+        // step over the blocks that were completely sent, and trim a partially sent one
+        size_t sent = rc;
+        while (niov && (sent >= next->iov_len)) {
+            sent -= next->iov_len;
+            next++;
+            niov--;
+        }
+        if (niov) {
+            next->iov_base = (byte *)next->iov_base + sent;
+            next->iov_len -= sent;
         }
     }
 #endif
 #endif
+    // the sendmsg and WSASendTo paths do not go through write(), so this is the only accounting for them
     STATS.writes++;
     STATS.writesize += res;
     STATS.writetime+=usTick()-startt;
@@ -658,7 +658,8 @@ interface IBufferedSocket : implements IInterface
 #define BSOCKET_READ_TIMEOUT 600
 #define BSOCKET_CLIENT_READ_TIMEOUT 7200
 
-extern jlib_decl IBufferedSocket* createBufferedSocket(ISocket* socket);
+// prefetched data has already been read from the socket, and is returned before anything else is read
+extern jlib_decl IBufferedSocket* createBufferedSocket(ISocket* socket, const void *prefetched = nullptr, size32_t prefetchedLen = 0);
 
 #define MAX_NET_ADDRESS_SIZE (16)
 
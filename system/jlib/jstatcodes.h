@@ -254,6 +254,13 @@ enum StatisticKind
     StTimeStart,
     StCycleStartCycles,
     StEnumActivityCharacteristics,
+    StNumHotKeys,
+    StNumHotKeyRows,
+    StNumSoapcalls,                     // Number of http requests sent by a soapcall/httpcall
+    StNumBroadcastHops,                 // Number of packets a lookup/all join sent on to other nodes while broadcasting the rhs
+    StSizeBroadcastHops,
+    StTimeBroadcastHops,                // Time from sending a broadcast packet to it being acknowledged, summed over all hops
+    StCycleBroadcastHopsCycles,
     StMax,
 
     //For any quantity there is potentially the following variants.
@@ -918,6 +918,13 @@ static const constexpr StatisticMeta statsMetaData[StMax] = {
     { TIMESTAT(Start) },
     { CYCLESTAT(Start) },
     { ENUMSTAT(ActivityCharacteristics) },
+    { NUMSTAT(HotKeys) },
+    { NUMSTAT(HotKeyRows) },
+    { NUMSTAT(Soapcalls) },
+    { NUMSTAT(BroadcastHops) },
+    { SIZESTAT(BroadcastHops) },
+    { TIMESTAT(BroadcastHops) },
+    { CYCLESTAT(BroadcastHops) },
 };
 
 //Is a 0 value likely, and useful to be reported if it does happen to be zero?
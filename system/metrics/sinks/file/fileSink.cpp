@@ -70,7 +70,24 @@ void FileMetricSink::writeMeasurementToFile(const std::shared_ptr<IMetric> &pMet
         name.append(".").append(unitsStr);
     }
 
-    fprintf(fhandle, "  %s -> %" I64F "d, %s\n", name.c_str(), pMetric->queryValue(), pMetric->queryDescription().c_str());
+    if (pMetric->queryMetricType() == METRICS_HISTOGRAM)
+    {
+        // count, sum and the count in each bucket (the last bucket is for measurements above the final limit)
+        StringBuffer buckets;
+        const std::vector<__uint64> & limits = pMetric->queryBucketLimits();
+        std::vector<__uint64> values = pMetric->queryBucketValues();
+        for (unsigned bucket=0; bucket < values.size(); bucket++)
+        {
+            if (bucket < limits.size())
+                buckets.append(" <=").append(limits[bucket]);
+            else
+                buckets.append(" >");
+            buckets.append(':').append(values[bucket]);
+        }
+        fprintf(fhandle, "  %s -> count=%" I64F "d sum=%" I64F "d [%s ], %s\n", name.c_str(), pMetric->queryValue(), pMetric->querySum(), buckets.str(), pMetric->queryDescription().c_str());
+    }
+    else
+        fprintf(fhandle, "  %s -> %" I64F "d, %s\n", name.c_str(), pMetric->queryValue(), pMetric->queryDescription().c_str());
     fflush(fhandle);
 }
 
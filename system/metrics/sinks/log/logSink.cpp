@@ -53,5 +53,14 @@ void LogMetricSink::writeLogEntry(const std::shared_ptr<IMetric> &pMetric)
     {
         name.append(".").append(unitsStr);
     }
-    LOG(MCmetrics, "name=%s,value=%" I64F "d", name.c_str(), pMetric->queryValue());
+    if (pMetric->queryMetricType() == METRICS_HISTOGRAM)
+    {
+        StringBuffer buckets;
+        std::vector<__uint64> values = pMetric->queryBucketValues();
+        for (unsigned bucket=0; bucket < values.size(); bucket++)
+            buckets.append(bucket ? ":" : "").append(values[bucket]);
+        LOG(MCmetrics, "name=%s,value=%" I64F "d,sum=%" I64F "d,buckets=%s", name.c_str(), pMetric->queryValue(), pMetric->querySum(), buckets.str());
+    }
+    else
+        LOG(MCmetrics, "name=%s,value=%" I64F "d", name.c_str(), pMetric->queryValue());
 }
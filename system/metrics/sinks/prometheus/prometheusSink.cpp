@@ -91,12 +91,39 @@ const char * PrometheusMetricSink::mapHPCCMetricTypeToPrometheusStr(MetricType t
         return "counter";
     case hpccMetrics::METRICS_GAUGE:
         return "gauge";
+    case hpccMetrics::METRICS_HISTOGRAM:
+        return "histogram";
     default:
         LOG(MCinternalWarning, "Encountered unknown metric - cannot map to Prometheus metric!");
         return nullptr;
     }
 }
 
+static void appendPrometheusLabels(StringBuffer & out, const MetricMetaData & metaData, const char * bucketLimit)
+{
+    if ((metaData.size()>0) || bucketLimit)
+    {
+        out.append(" {");
+        bool firstEntry = true;
+        for (auto &metaDataIt: metaData)
+        {
+            if (!firstEntry)
+                out.append(",");
+            else
+                firstEntry=false;
+
+            out.append(metaDataIt.key.c_str()).append("=\"").append(metaDataIt.value.c_str()).append("\"");
+        }
+        if (bucketLimit)
+        {
+            if (!firstEntry)
+                out.append(",");
+            out.append("le=\"").append(bucketLimit).append("\"");
+        }
+        out.append("}");
+    }
+}
+
 void PrometheusMetricSink::toPrometheusMetrics(const std::vector<std::shared_ptr<IMetric>> & reportMetrics, StringBuffer & out, bool verbose)
 {
     /*
@@ -124,24 +151,40 @@ void PrometheusMetricSink::toPrometheusMetrics(const std::vector<std::shared_ptr
                 out.append("# TYPE ").append(name.c_str()).append(" ").append(promtype).append("\n");
         }
 
-        out.append(name.c_str());
         const auto & metaData = pMetric->queryMetaData();
-        if (metaData.size()>0)
+        if (pMetric->queryMetricType() == METRICS_HISTOGRAM)
         {
-            out.append(" {");
-            bool firstEntry = true;
-            for (auto &metaDataIt: metaData)
+            /*
+             * <metric name>_bucket{le="<limit>"} <cumulative count>\n  (one per bucket, ending with le="+Inf")
+             * <metric name>_sum <sum of measurements>\n
+             * <metric name>_count <number of measurements>\n
+             */
+            const std::vector<__uint64> & limits = pMetric->queryBucketLimits();
+            std::vector<__uint64> values = pMetric->queryBucketValues();
+            __uint64 cumulative = 0;
+            for (unsigned bucket=0; bucket < values.size(); bucket++)
             {
-                if (!firstEntry)
-                    out.append(",");
+                cumulative += values[bucket];
+                StringBuffer bucketLimit;
+                if (bucket < limits.size())
+                    bucketLimit.append(limits[bucket]);
                 else
-                    firstEntry=false;
-
-                out.append(metaDataIt.key.c_str()).append("=\"").append(metaDataIt.value.c_str()).append("\"");
+                    bucketLimit.append("+Inf");
+                out.append(name.c_str()).append("_bucket");
+                appendPrometheusLabels(out, metaData, bucketLimit);
+                out.append(" ").append(cumulative).append("\n");
             }
-            out.append("}");
+            out.append(name.c_str()).append("_sum");
+            appendPrometheusLabels(out, metaData, nullptr);
+            out.append(" ").append(pMetric->querySum()).append("\n");
+            out.append(name.c_str()).append("_count");
+            appendPrometheusLabels(out, metaData, nullptr);
+            out.append(" ").append(cumulative).append("\n");
+            continue;
         }
 
+        out.append(name.c_str());
+        appendPrometheusLabels(out, metaData, nullptr);
         out.append(" ").append(pMetric->queryValue()).append("\n");
     }
 }
@@ -1395,13 +1395,13 @@ class MultiPacketHandler // TAG_SYS_MULTI
     CriticalSection sect;
     unsigned lastErrMs;
 
-    void logError(unsigned code, MultiPacketHeader &mhdr, CMessageBuffer &msg, MultiPacketHeader *otherMhdr)
+    void logError(unsigned code, MultiPacketHeader &mhdr, const SocketEndpoint &sender, MultiPacketHeader *otherMhdr)
     {
         unsigned ms = msTick();
         if ((ms-lastErrMs) > 1000) // avoid logging too much
         {
             StringBuffer errorMsg("sender=");
-            msg.getSender().getUrlStr(errorMsg).newline();
+            sender.getUrlStr(errorMsg).newline();
             errorMsg.append("This header: ");
             mhdr.getDetails(errorMsg).newline();
             if (otherMhdr)
@@ -1409,7 +1409,6 @@ class MultiPacketHandler // TAG_SYS_MULTI
                 errorMsg.append("Other header: ");
                 otherMhdr->getDetails(errorMsg).newline();
             }
-            msg.getDetails(errorMsg);
             LOG(MCerror, unknownJob, "MultiPacketHandler: protocol error (%d) %s", code, errorMsg.str());
         }
         lastErrMs = ms;
@@ -1418,33 +1417,38 @@ public:
     MultiPacketHandler() : lastErrMs(0)
     {
     }
-    CMessageBuffer *handle(CMessageBuffer * msg)
+    /*
+     * The packet reader reads the data of each part directly into the message being assembled,
+     * rather than into a packet buffer that is then copied.
+     * beginPart returns where the mhdr.size bytes of part data should be read to, or NULL if the part is
+     * out of sequence (in which case the data should be read and discarded).
+     * endPart returns the complete message once the last part has been read, and NULL otherwise.
+     */
+    byte *beginPart(PacketHeader &hdr, MultiPacketHeader &mhdr)
     {
-        if (!msg) 
-            return NULL;
+        SocketEndpoint sender;
+        hdr.sender.get(sender);
         CriticalBlock block(sect);
-        MultiPacketHeader mhdr;
-        msg->read(sizeof(mhdr),&mhdr);
         CMultiPacketReceiver *recv=NULL;
         ForEachItemIn(i,inprogress) {
             CMultiPacketReceiver &mpr = inprogress.item(i);
-            if ((mpr.info.tag==mhdr.tag)&&mpr.sender.equals(msg->getSender())) {
+            if ((mpr.info.tag==mhdr.tag)&&mpr.sender.equals(sender)) {
                 recv = &mpr;
                 break;
             }
         }
         if (mhdr.idx==0) {
-            if ((mhdr.ofs!=0)||(recv!=NULL)) {
-                logError(1, mhdr, *msg, recv?&recv->info:NULL);
-                delete msg;
+            if ((mhdr.ofs!=0)||(recv!=NULL)||(mhdr.size>mhdr.total)) {
+                logError(1, mhdr, sender, recv?&recv->info:NULL);
                 return NULL;
             }
             recv = new CMultiPacketReceiver;
-            recv->msg = new CMessageBuffer();           
-            recv->msg->init(msg->getSender(),mhdr.tag,msg->getReplyTag());
+            recv->msg = new CMessageBuffer();
+            recv->msg->init(sender,mhdr.tag,hdr.replytag);
             recv->ptr = (byte *)recv->msg->reserveTruncate(mhdr.total);
-            recv->sender = msg->getSender();
+            recv->sender = sender;
             recv->info = mhdr;
+            recv->info.size = 0; // nothing read yet
             inprogress.append(*recv);
         }
         else {
@@ -1453,24 +1457,34 @@ public:
                  (recv->info.idx+1!=mhdr.idx)||
                  (recv->info.total!=mhdr.total)||
                  (mhdr.ofs+mhdr.size>mhdr.total)) {
-                logError(2, mhdr, *msg, recv?&recv->info:NULL);
-                delete msg;
+                logError(2, mhdr, sender, recv?&recv->info:NULL);
                 return NULL;
             }
         }
-        msg->read(mhdr.size,recv->ptr+mhdr.ofs);
-        delete msg;
-        msg = NULL;
-        recv->info = mhdr;
-        if (mhdr.idx+1==mhdr.numparts) {
-            if (mhdr.ofs+mhdr.size!=mhdr.total) {
-                logError(3, mhdr, *msg, NULL);
-                return NULL;
+        return recv->ptr+mhdr.ofs;
+    }
+    CMessageBuffer *endPart(PacketHeader &hdr, MultiPacketHeader &mhdr)
+    {
+        SocketEndpoint sender;
+        hdr.sender.get(sender);
+        CriticalBlock block(sect);
+        ForEachItemIn(i,inprogress) {
+            CMultiPacketReceiver &recv = inprogress.item(i);
+            if ((recv.info.tag==mhdr.tag)&&recv.sender.equals(sender)) {
+                recv.info = mhdr;
+                if (mhdr.idx+1!=mhdr.numparts)
+                    return NULL;
+                CMessageBuffer *msg = recv.msg;
+                inprogress.remove(i);
+                if (mhdr.ofs+mhdr.size!=mhdr.total) {
+                    logError(3, mhdr, sender, NULL);
+                    delete msg;
+                    return NULL;
+                }
+                return msg;
             }
-            msg = recv->msg;
-            inprogress.remove(i);
         }
-        return msg;
+        return NULL;
     }
     bool send(CMPChannel *channel,PacketHeader &hdr,MemoryBuffer &mb, CTimeMon &tm, Mutex &sendmutex)
     {
@@ -1550,6 +1564,10 @@ class CMPPacketReader: public ISocketSelectNotify, public CInterface
     size32_t remaining;
     CMPChannel *parent;
     CriticalSection sect;
+    bool activemulti = false;       // reading a multi-packet part directly into the message being assembled
+    bool discarding = false;        // reading a packet that is to be thrown away
+    PacketHeader activehdr;         // header of the active multi-packet part
+    MultiPacketHeader activemhdr;
 public:
     IMPLEMENT_IINTERFACE;
 
@@ -1562,6 +1580,8 @@ public:
     {
         parent = _parent;
         activemsg = NULL;
+        activemulti = false;
+        discarding = false;
     }
 
     void shutdown()
@@ -1602,7 +1622,7 @@ public:
 #ifdef _FULLTRACE
                 parent->numiter++;
 #endif
-                if (!activemsg) { // no message in progress
+                if (!activemsg&&!activemulti) { // no message in progress
                     PacketHeader hdr; // header for active message
 #ifdef _FULLTRACE
                     parent->numiter = 1;
@@ -1635,9 +1655,34 @@ public:
                     LOG(MCdebugInfo, unknownJob, "MP: ReadPacket(sender=%s,target=%s,tag=%d,replytag=%d,size=%d)",hdr.sender.getUrlStr(ep1).str(),hdr.target.getUrlStr(ep2).str(),hdr.tag,hdr.replytag,hdr.size);
 #endif
                     remaining = hdr.size-sizeof(hdr);
-                    activemsg = new CMessageBuffer(remaining); // will get from low level IO at some stage
-                    activeptr = (byte *)activemsg->reserveTruncate(remaining);
-                    hdr.setMessageFields(*activemsg);
+                    if (hdr.tag==TAG_SYS_MULTI) {
+                        activeptr = NULL;
+                        if (remaining>=sizeof(activemhdr)) {
+                            if (sizeavail<sizeof(activemhdr)) {
+                                size32_t szread;
+                                sock->read(&activemhdr,sizeof(activemhdr),sizeof(activemhdr),szread,60);
+                            }
+                            else
+                                sock->read(&activemhdr,sizeof(activemhdr));
+                            if (sizeavail<=sizeof(activemhdr))
+                                sizeavail = sock->avail_read();
+                            else
+                                sizeavail -= sizeof(activemhdr);
+                            remaining -= sizeof(activemhdr);
+                            activehdr = hdr;
+                            if (remaining==activemhdr.size)
+                                activeptr = parent->queryServer().multipackethandler->beginPart(activehdr,activemhdr);
+                        }
+                        if (activeptr)
+                            activemulti = true;
+                        else
+                            discarding = true;
+                    }
+                    if (!activemulti) {
+                        activemsg = new CMessageBuffer(remaining); // will get from low level IO at some stage
+                        activeptr = (byte *)activemsg->reserveTruncate(remaining);
+                        hdr.setMessageFields(*activemsg);
+                    }
                 }
                 
                 size32_t toread = sizeavail;
@@ -1654,11 +1699,17 @@ public:
 #ifdef _FULLTRACE
                     LOG(MCdebugInfo, unknownJob, "MP: ReadPacket(timetaken = %d,select iterations=%d)",msTick()-parent->startxfer,parent->numiter);
 #endif
-                    do {
+                    if (activemulti) {
+                        activemulti = false;
+                        activemsg = parent->queryServer().multipackethandler->endPart(activehdr,activemhdr); // NULL until last part read
+                    }
+                    else if (discarding) {
+                        discarding = false;
+                        delete activemsg;
+                        activemsg = NULL;
+                    }
+                    while (activemsg) {
                         switch (activemsg->getTag()) {
-                        case TAG_SYS_MULTI:
-                             activemsg = parent->queryServer().multipackethandler->handle(activemsg); // activemsg in/out
-                             break;
                         case TAG_SYS_PING:
                              parent->queryServer().pingpackethandler->handle(parent,false); //,activemsg); 
                              delete activemsg;
@@ -1679,7 +1730,7 @@ public:
                              parent->queryServer().userpackethandler->handle(activemsg); // takes ownership
                              activemsg = NULL;
                         }
-                    } while (activemsg);
+                    }
                 }
                 if (!sizeavail)
                     sizeavail = sock->avail_read();
@@ -31,6 +31,7 @@
 #include "dasds.hpp"
 #include "danqs.hpp"
 #include "dautils.hpp"
+#include "dadiags.hpp"
 
 #include <vector>
 #include <future>
@@ -807,6 +808,7 @@ class CDaliSDSStressTests : public CppUnit::TestFixture
         CPPUNIT_TEST(testSDSSubs2);
         CPPUNIT_TEST(testSDSNodeSubs);
         CPPUNIT_TEST(testEphemeralLocks);
+        CPPUNIT_TEST(testSDSPackedSubtree);
         CPPUNIT_TEST(testSiblingPerfLocal);
         CPPUNIT_TEST(testSiblingPerfDali);
         CPPUNIT_TEST(testSiblingPerfContention);
@@ -1462,6 +1464,68 @@ public:
         for (auto &f: results)
             f.get();
     }
+    void testSDSPackedSubtree()
+    {
+        const char *xpath = "/DAREGRESS_PACKED";
+        Owned<IRemoteConnection> conn = querySDS().connect(xpath, myProcessSession(), RTM_CREATE, 1000000);
+        IPropertyTree *root = conn->queryRoot();
+        for (unsigned i=0; i<10; i++)
+        {
+            IPropertyTree *wu = root->addPropTree("WU");
+            wu->setPropInt("@id", i);
+            IPropertyTree *result = wu->addPropTree("Results")->addPropTree("Result");
+            result->setProp("@name", "original");
+            result->setPropInt("Value", i);
+        }
+        conn.clear();
+
+        // Pack the children of each WU, as the server would on load with @compactSubtrees
+        MemoryBuffer mb;
+        mb.append("setsdsdebug").append((unsigned)2).append("packSubtrees").append("DAREGRESS_PACKED/WU");
+        getDaliDiagnosticValue(mb);
+        bool success;
+        StringAttr reply;
+        mb.read(success).read(reply);
+        CPPUNIT_ASSERT_MESSAGE(reply.get(), success);
+        CPPUNIT_ASSERT(streq("packed 10 subtrees", reply.get()));
+
+        // Connecting to a packed node expands it, so changes committed to it are kept
+        conn.setown(querySDS().connect("/DAREGRESS_PACKED/WU[@id=\"3\"]", myProcessSession(), RTM_LOCK_WRITE, 1000000));
+        CPPUNIT_ASSERT(conn);
+        IPropertyTree *result = conn->queryRoot()->queryPropTree("Results/Result");
+        CPPUNIT_ASSERT(result);
+        CPPUNIT_ASSERT(streq("original", result->queryProp("@name")));
+        CPPUNIT_ASSERT_EQUAL(3, result->getPropInt("Value"));
+        result->setProp("@name", "changed");
+        conn->queryRoot()->queryPropTree("Results")->addPropTree("Result")->setProp("@name", "added");
+        conn->commit();
+        conn.clear();
+
+        conn.setown(querySDS().connect("/DAREGRESS_PACKED/WU[@id=\"3\"]", myProcessSession(), 0, 1000000));
+        CPPUNIT_ASSERT(conn);
+        CPPUNIT_ASSERT(streq("changed", conn->queryRoot()->queryProp("Results/Result[1]/@name")));
+        CPPUNIT_ASSERT(streq("added", conn->queryRoot()->queryProp("Results/Result[2]/@name")));
+        conn.clear();
+
+        // A connection above the packed nodes sees the same data through every access path
+        conn.setown(querySDS().connect(xpath, myProcessSession(), RTM_DELETE_ON_DISCONNECT, 1000000));
+        root = conn->queryRoot();
+        unsigned count = 0;
+        Owned<IPropertyTreeIterator> iter = root->getElements("WU");
+        ForEach(*iter)
+        {
+            IPropertyTree &wu = iter->query();
+            unsigned id = wu.getPropInt("@id");
+            CPPUNIT_ASSERT_EQUAL(id, (unsigned)wu.getPropInt("Results/Result[1]/Value"));
+            CPPUNIT_ASSERT(streq(3 == id ? "changed" : "original", wu.queryProp("Results/Result[1]/@name")));
+            CPPUNIT_ASSERT_EQUAL(3 == id ? 2U : 1U, wu.getCount("Results/Result"));
+            count++;
+        }
+        CPPUNIT_ASSERT_EQUAL(10U, count);
+        CPPUNIT_ASSERT(streq("added", root->queryProp("WU[@id=\"3\"]/Results/Result[2]/@name")));
+        iter.clear();
+        conn.clear();
+    }
     void createLevel(IPropertyTree *parent, unsigned nodeSiblings, unsigned leafSiblings, unsigned attributes, unsigned depth, unsigned level)
     {
         StringBuffer aname;
@@ -2583,9 +2583,82 @@ class JlibIOTest : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE(JlibIOTest);
         CPPUNIT_TEST(test);
+        CPPUNIT_TEST(testBatchRead);
+        CPPUNIT_TEST(testPrefetchRead);
     CPPUNIT_TEST_SUITE_END();
 
 public:
+    void testBatchRead()
+    {
+        const unsigned numValues = 0x40000;
+        const unsigned numRequests = 200;   // more than can be outstanding at once
+        const unsigned valuesPerRead = 16;
+        OwnedIFile iFile = createIFile("JlibIOTestBatch.bin");
+        {
+            OwnedIFileIO iFileIO = iFile->open(IFOcreate);
+            OwnedIFileIOStream stream = createBufferedIOStream(iFileIO);
+            for (unsigned i=0; i<numValues; i++)
+                stream->write(sizeof(i), &i);
+        }
+
+        OwnedIFileIO iFileIO = iFile->open(IFOread);
+        FileReadRequest requests[numRequests];
+        unsigned values[numRequests][valuesPerRead];
+        for (unsigned i=0; i<numRequests; i++)
+        {
+            requests[i].pos = (offset_t)((i * 7919) % (numValues - valuesPerRead)) * sizeof(unsigned);
+            requests[i].len = sizeof(values[i]);
+            requests[i].data = values[i];
+            requests[i].numRead = 0;
+        }
+        //The last read is truncated by the end of the file
+        requests[numRequests-1].pos = (offset_t)(numValues - 4) * sizeof(unsigned);
+
+        readFileBatch(iFileIO, numRequests, requests);
+        for (unsigned i=0; i<numRequests; i++)
+        {
+            unsigned expectedValues = (i == numRequests-1) ? 4 : valuesPerRead;
+            CPPUNIT_ASSERT_EQUAL((size32_t)(expectedValues * sizeof(unsigned)), requests[i].numRead);
+            unsigned first = (unsigned)(requests[i].pos / sizeof(unsigned));
+            for (unsigned j=0; j<expectedValues; j++)
+                CPPUNIT_ASSERT_EQUAL(first+j, values[i][j]);
+        }
+        iFileIO.clear();
+        iFile->remove();
+    }
+
+    void testPrefetchRead()
+    {
+        const unsigned numValues = 0x10000;
+        OwnedIFile iFile = createIFile("JlibIOTestPrefetch.bin");
+        {
+            OwnedIFileIO iFileIO = iFile->open(IFOcreate);
+            OwnedIFileIOStream stream = createBufferedIOStream(iFileIO);
+            for (unsigned i=0; i<numValues; i++)
+                stream->write(sizeof(i), &i);
+        }
+
+        OwnedIFileIO iFileIO = iFile->open(IFOread);
+        Owned<IPrefetchFileIO> prefetchIO = createPrefetchFileIO(iFileIO);
+        const size32_t blockSize = 16 * sizeof(unsigned);
+        offset_t positions[3] = { 400 * sizeof(unsigned), 100 * sizeof(unsigned), (numValues - 4) * sizeof(unsigned) };
+        prefetchIO->prefetch(3, positions, blockSize);
+
+        //Reads within a block, spanning the end of a block, outside all blocks, and truncated by the end of the file
+        const unsigned tests[][3] = { { 100, 16, 16 }, { 404, 4, 4 }, { 410, 20, 20 }, { 1000, 8, 8 }, { numValues - 2, 8, 2 } };
+        for (const auto & test : tests)
+        {
+            unsigned values[32];
+            size32_t numRead = prefetchIO->read((offset_t)test[0] * sizeof(unsigned), test[1] * sizeof(unsigned), values);
+            CPPUNIT_ASSERT_EQUAL((size32_t)(test[2] * sizeof(unsigned)), numRead);
+            for (unsigned j=0; j<test[2]; j++)
+                CPPUNIT_ASSERT_EQUAL(test[0]+j, values[j]);
+        }
+        prefetchIO.clear();
+        iFileIO.clear();
+        iFile->remove();
+    }
+
     void test()
     {
         unsigned numTestLines = 1000;
@@ -2979,6 +3052,137 @@ class BlockedTimingTests : public CppUnit::TestFixture
 CPPUNIT_TEST_SUITE_REGISTRATION( BlockedTimingTests );
 CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( BlockedTimingTests, "BlockedTimingTests" );
 
+class JlibLogTiming : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( JlibLogTiming );
+        CPPUNIT_TEST(testDroppedMessages);
+        CPPUNIT_TEST(testQueuedLogging);
+    CPPUNIT_TEST_SUITE_END();
+
+    class LogThread : public Thread
+    {
+    public:
+        LogThread(ILogMsgManager & _manager, Semaphore & _startSem, unsigned _numIterations) : Thread("LogThread"), manager(_manager), startSem(_startSem), numIterations(_numIterations)
+        {
+        }
+
+        virtual int run() override
+        {
+            startSem.wait();
+            cycle_t start = get_cycles_now();
+            for (unsigned i = 0; i < numIterations; i++)
+                manager.report(MCdebugInfo, "Log timing test message %u from a busy thread", i);
+            elapsed = get_cycles_now() - start;
+            return 0;
+        }
+
+        cycle_t elapsed = 0;
+
+    protected:
+        ILogMsgManager & manager;
+        Semaphore & startSem;
+        const unsigned numIterations;
+    };
+
+    // Handler that holds up the queue processor on the first message until it is released
+    class BlockingLogMsgHandler : public CInterfaceOf<ILogMsgHandler>
+    {
+    public:
+        virtual void handleMessage(const LogMsg & msg) override
+        {
+            if (handled++ == 0)
+            {
+                started.signal();
+                release.wait();
+            }
+        }
+        virtual bool needsPrep() const override { return false; }
+        virtual void prep() override {}
+        virtual unsigned queryMessageFields() const override { return MSGFIELD_all; }
+        virtual void setMessageFields(unsigned _fields) override {}
+        virtual void addToPTree(IPropertyTree * parent) const override {}
+        virtual bool getLogName(StringBuffer &name) const override { return false; }
+        virtual offset_t getLogPosition(StringBuffer &logFileName) const override { return 0; }
+
+        Semaphore started;
+        Semaphore release;
+        std::atomic<unsigned> handled{0};
+    };
+
+public:
+    // The tests use their own manager so that the global one is never switched into queueing mode
+    void testDroppedMessages()
+    {
+        Owned<BlockingLogMsgHandler> handler = new BlockingLogMsgHandler;
+        Owned<ILogMsgManager> manager = createLogMsgManager();
+        manager->addMonitorOwn(LINK(handler), getCategoryLogMsgFilter(MSGAUD_all, MSGCLS_all, TopDetail));
+        manager->enterQueueingMode();
+        manager->setQueueDroppingLimit(64, 8);
+        CPPUNIT_ASSERT_EQUAL((unsigned __int64)0, manager->queryDroppedMessages());
+
+        manager->report(MCdebugInfo, "First message");
+        CPPUNIT_ASSERT(handler->started.wait(10000));
+        for (unsigned i = 0; i < 32; i++)
+            manager->report(MCdebugInfo, "Message %u", i);
+        CPPUNIT_ASSERT_EQUAL((unsigned __int64)0, manager->queryDroppedMessages());
+        for (unsigned i = 32; i < 200; i++)
+            manager->report(MCdebugInfo, "Message %u", i);
+        unsigned __int64 dropped = manager->queryDroppedMessages();
+        CPPUNIT_ASSERT(dropped != 0);
+
+        handler->release.signal();
+        CPPUNIT_ASSERT(manager->flushQueue(60000));
+        CPPUNIT_ASSERT(handler->handled < 201);
+        CPPUNIT_ASSERT_EQUAL(dropped, manager->queryDroppedMessages());
+        manager->removeMonitor(handler);
+    }
+
+    // Measure the cost of each logging call when many threads log at once through the queue, with a dropping limit
+    void testQueuedLogging()
+    {
+        const unsigned numThreads = 64;
+        const unsigned numIterations = 20000;
+        const char * filename = "JlibLogTiming.log";
+
+        Owned<ILogMsgManager> manager = createLogMsgManager();
+        ILogMsgHandler * handler = getFileLogMsgHandler(filename, nullptr, MSGFIELD_STANDARD, false, false, true);
+        manager->addMonitorOwn(handler, getCategoryLogMsgFilter(MSGAUD_all, MSGCLS_all, TopDetail));
+        manager->enterQueueingMode();
+        manager->setQueueDroppingLimit(512, 32);
+
+        Semaphore startSem;
+        CIArrayOf<LogThread> threads;
+        for (unsigned i = 0; i < numThreads; i++)
+        {
+            LogThread * next = new LogThread(*manager, startSem, numIterations);
+            threads.append(*next);
+            next->start();
+        }
+        cycle_t start = get_cycles_now();
+        startSem.signal(numThreads);
+        cycle_t totalCycles = 0;
+        ForEachItemIn(i, threads)
+        {
+            threads.item(i).join();
+            totalCycles += threads.item(i).elapsed;
+        }
+        cycle_t elapsed = get_cycles_now() - start;
+        CPPUNIT_ASSERT(manager->flushQueue(60000));
+        unsigned __int64 dropped = manager->queryDroppedMessages();
+
+        manager->removeMonitor(handler);
+        manager.clear();
+        removeFileTraceIfFail(filename);
+
+        const unsigned __int64 numCalls = (unsigned __int64)numThreads * numIterations;
+        DBGLOG("%u threads logging %u messages each: %.2f ns per call, %.2f ms elapsed, %" I64F "u messages dropped",
+               numThreads, numIterations, (double)cycle_to_nanosec(totalCycles) / numCalls, (double)cycle_to_nanosec(elapsed) / 1000000, dropped);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( JlibLogTiming );
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( JlibLogTiming, "JlibLogTiming" );
+
 
 
 #endif // _USE_CPPUNIT
@@ -74,6 +74,7 @@ public:
         CPPUNIT_TEST(Test_scoped_updater_classes);
         CPPUNIT_TEST(Test_metric_meta_data);
         CPPUNIT_TEST(Test_gauge_by_counters_metric);
+        CPPUNIT_TEST(Test_histogram_metric);
     CPPUNIT_TEST_SUITE_END();
 
 protected:
@@ -308,6 +309,42 @@ protected:
         CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(pCounterGauge->queryValue()));
     }
 
+
+    void Test_histogram_metric()
+    {
+        std::vector<__uint64> limits = createExponentialBuckets(10, 10, 3);
+        CPPUNIT_ASSERT_EQUAL(3, static_cast<int>(limits.size()));
+        CPPUNIT_ASSERT_EQUAL(1000, static_cast<int>(limits[2]));
+
+        std::shared_ptr<HistogramMetric> pHistogram = std::make_shared<HistogramMetric>("test-histogram", "description", SMeasureTimeNs, limits);
+        CPPUNIT_ASSERT_EQUAL(METRICS_HISTOGRAM, pHistogram->queryMetricType());
+        CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(pHistogram->queryValue()));
+
+        //
+        // Bucket limits are inclusive, values above the last limit go into the final bucket
+        pHistogram->recordMeasurement(5);
+        pHistogram->recordMeasurement(10);
+        pHistogram->recordMeasurement(11);
+        pHistogram->recordMeasurement(1000);
+        pHistogram->recordMeasurement(5000);
+
+        std::vector<__uint64> values = pHistogram->queryBucketValues();
+        CPPUNIT_ASSERT_EQUAL(4, static_cast<int>(values.size()));
+        CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(values[0]));
+        CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(values[1]));
+        CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(values[2]));
+        CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(values[3]));
+        CPPUNIT_ASSERT_EQUAL(5, static_cast<int>(pHistogram->queryValue()));
+        CPPUNIT_ASSERT_EQUAL(6026, static_cast<int>(pHistogram->querySum()));
+
+        //
+        // Updates from other threads are combined with this thread's
+        std::thread other([&pHistogram] { for (unsigned i=0; i < 100; i++) pHistogram->recordMeasurement(50); });
+        other.join();
+        CPPUNIT_ASSERT_EQUAL(101, static_cast<int>(pHistogram->queryBucketValues()[1]));
+        CPPUNIT_ASSERT_EQUAL(105, static_cast<int>(pHistogram->queryValue()));
+    }
+
 protected:
     MetricsManager frameworkTestManager;
     MetricFrameworkTestSink *pTestSink;
@@ -41,13 +41,20 @@
 
 #define NUMSLAVEPORTS       2
 
+//The rows are fetched one at a time, and the start of the rows for a batch of fetches is read in advance as a single
+//batch of concurrent reads (if the file supports it).  The fetches then read the rows from the prefetched blocks.
+static constexpr unsigned fetchPrefetchRows = 64;
+static constexpr size32_t fetchPrefetchSize = 0x1000;
+
 struct FPosTableEntryIFileIO : public FPosTableEntry
 {
     ~FPosTableEntryIFileIO()
     {
+        ::Release(prefetchFile);
         ::Release(file);
     }
     IFileIO *file = nullptr;
+    IPrefetchFileIO *prefetchFile = nullptr;  // wraps file, and is used for all the fetch reads
 };
 
 class CFetchStream : public IRowStream, implements IStopInput, implements IFetchStream, public CSimpleInterface
@@ -62,6 +69,10 @@ class CFetchStream : public IRowStream, implements IStopInput, implements IFetch
     CriticalSection stopsect;
     CPartDescriptorArray parts;
     FPosTableEntry *offsetTable;
+    OwnedConstThorRow pendingKeyRows[fetchPrefetchRows];
+    unsigned numPendingKeyRows = 0;
+    unsigned nextPendingKeyRow = 0;
+    bool keyRowsEos = false;
 
     static int partLookup(const void *_key, const void *e)
     {
@@ -160,6 +171,7 @@ public:
                 e->top = e->base + part.queryProperties().getPropInt64("@size");
                 e->index = f;
                 e->file = queryThor().queryFileCache().lookupIFileIO(owner, logicalFilename, part, nullptr, diskReadPartStatistics); // NB: freed by FPosTableEntryIFileIO dtor
+                e->prefetchFile = createPrefetchFileIO(e->file);
             }
         }
     }
@@ -181,7 +193,7 @@ public:
         keyOutStream.setown(distributor->connect(keyRowIf, keyIn, fposHash, NULL, NULL));
     }
     virtual IRowStream *queryOutput() override { return this; }
-    virtual IFileIO *getPartIO(unsigned part) override { assertex(part<files); return LINK(fPosMultiPartTable[part].file); }
+    virtual IFileIO *getPartIO(unsigned part) override { assertex(part<files); return LINK(fPosMultiPartTable[part].prefetchFile); }
     virtual StringBuffer &getPartName(unsigned part, StringBuffer &out) override { return getPartFilename(parts.item(part), 0, out, true); }
     virtual void abort() override
     {
@@ -201,6 +213,8 @@ public:
     }
     virtual void stop()
     {
+        while (nextPendingKeyRow < numPendingKeyRows)
+            pendingKeyRows[nextPendingKeyRow++].clear();
         if (keyOutStream)
         {
             keyOutStream->stop();
@@ -213,6 +227,60 @@ public:
         }
         stopInput();
     }
+    void prefetchPendingRows()
+    {
+        offset_t positions[fetchPrefetchRows];
+        for (unsigned f=0; f<files; f++)
+        {
+            FPosTableEntryIFileIO &entry = fPosMultiPartTable[f];
+            unsigned num = 0;
+            for (unsigned i=0; i<numPendingKeyRows; i++)
+            {
+                offset_t fpos = iFetchHandler->extractFpos(pendingKeyRows[i]);
+                offset_t localFpos;
+                if (isLocalFpos(fpos))
+                {
+                    if (files != 1)
+                        continue;
+                    localFpos = getLocalFposOffset(fpos);
+                }
+                else if ((fpos >= entry.base) && (fpos < entry.top))
+                    localFpos = fpos-entry.base;
+                else
+                    continue;
+                positions[num++] = localFpos;
+            }
+            if ((num > 1) && canReadFileConcurrently(entry.file))
+                entry.prefetchFile->prefetch(num, positions, fetchPrefetchSize);
+            else
+                entry.prefetchFile->clearPrefetched();
+        }
+    }
+    const void *nextKeyRow()
+    {
+        if (nextPendingKeyRow == numPendingKeyRows)
+        {
+            if (keyRowsEos)
+                return nullptr;
+            numPendingKeyRows = 0;
+            nextPendingKeyRow = 0;
+            while (numPendingKeyRows < fetchPrefetchRows)
+            {
+                const void *keyRow = keyOutStream->nextRow();
+                if (!keyRow)
+                {
+                    keyRowsEos = true;
+                    break;
+                }
+                pendingKeyRows[numPendingKeyRows++].setown(keyRow);
+            }
+            if (numPendingKeyRows > 1)
+                prefetchPendingRows();
+            if (!numPendingKeyRows)
+                return nullptr;
+        }
+        return pendingKeyRows[nextPendingKeyRow++].getClear();
+    }
     const void *nextRow()
     {
         if (abortSoon)
@@ -220,7 +288,7 @@ public:
 
         for (;;)
         {
-            OwnedConstThorRow keyRec = keyOutStream->nextRow(); // is this right?
+            OwnedConstThorRow keyRec = nextKeyRow();
             if (!keyRec)
                 break;
 
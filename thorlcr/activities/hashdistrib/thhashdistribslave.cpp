@@ -18,6 +18,7 @@
 #include "platform.h"
 #include "limits.h"
 #include <math.h>
+#include <unordered_map>
 
 #include "slave.ipp"
 
@@ -40,6 +41,11 @@
 #include "jhtree.hpp"
 #include "thalloc.hpp"
 
+#ifdef _USE_CPPUNIT
+#include "rtlfield.hpp"
+#include <cppunit/extensions/HelperMacros.h>
+#endif
+
 #ifdef _DEBUG
 //#define TRACE_UNIQUE
 //#define FULL_TRACE
@@ -77,6 +83,134 @@
 #define HDSendPrintLog5(M,P1,P2,P3,P4)
 #endif
 
+/*
+ * CColumnarRowCodec - rearranges a block of fixed size serialized rows into columns before it is compressed.
+ * Integer fields are delta encoded (zigzag'd so small negative steps stay small) and split into byte planes,
+ * other fields are stored as contiguous column values. The encoded block is the same size as the original,
+ * so the receiver can decode the expanded block in place.
+ */
+class CColumnarRowCodec : public CSimpleInterface
+{
+    struct Column
+    {
+        size32_t offset;
+        size32_t size;
+        bool delta;
+    };
+    std::vector<Column> columns;
+    size32_t rowSize = 0;
+
+    static inline unsigned __int64 readInt(const byte *src, size32_t size)
+    {
+        unsigned __int64 value = 0;
+        for (unsigned b=0; b<size; b++)
+            value |= ((unsigned __int64)src[b]) << (b*8);
+        return value;
+    }
+    static inline void writeInt(byte *dst, size32_t size, unsigned __int64 value)
+    {
+        for (unsigned b=0; b<size; b++)
+            dst[b] = (byte)(value >> (b*8));
+    }
+public:
+    static CColumnarRowCodec *create(IOutputMetaData *serializedMeta)
+    {
+        size32_t fixedSize = serializedMeta->getFixedSize();
+        if (!fixedSize)
+            return nullptr;
+        const RtlRecord &record = serializedMeta->queryRecordAccessor(true);
+        unsigned numFields = record.getNumFields();
+        Owned<CColumnarRowCodec> codec = new CColumnarRowCodec;
+        codec->rowSize = fixedSize;
+        bool anyDelta = false;
+        size32_t expectedOffset = 0;
+        for (unsigned f=0; f<numFields; f++)
+        {
+            if (!record.isFixedOffset(f))
+                return nullptr;
+            size32_t offset = (size32_t)record.getFixedOffset(f);
+            size32_t next = (f+1<numFields) ? (size32_t)record.getFixedOffset(f+1) : fixedSize;
+            if ((offset != expectedOffset) || (next < offset))
+                return nullptr;
+            if (next == offset) // e.g. leading bitfields sharing storage, or empty nested records
+                continue;
+            const RtlTypeInfo *type = record.queryType(f);
+            size32_t size = next - offset;
+            bool delta = (type_int == type->getType()) && (size == type->getMinSize()) && (size <= sizeof(unsigned __int64));
+            codec->columns.push_back({ offset, size, delta });
+            anyDelta = anyDelta || delta;
+            expectedOffset = next;
+        }
+        if (expectedOffset != fixedSize)
+            return nullptr;
+        if (!anyDelta && (codec->columns.size() < 2))
+            return nullptr; // nothing to gain
+        return codec.getClear();
+    }
+    size32_t queryRowSize() const { return rowSize; }
+    void encode(MemoryBuffer &out, const byte *rows, size32_t len) const
+    {
+        assertex(0 == (len % rowSize));
+        unsigned numRows = len / rowSize;
+        byte *dst = (byte *)out.reserveTruncate(len);
+        for (const Column &column : columns)
+        {
+            const byte *src = rows + column.offset;
+            if (column.delta)
+            {
+                unsigned shift = 64 - (column.size*8);
+                unsigned __int64 prev = 0;
+                for (unsigned r=0; r<numRows; r++, src+=rowSize)
+                {
+                    unsigned __int64 value = readInt(src, column.size);
+                    __int64 diff = ((__int64)((value - prev) << shift)) >> shift;
+                    unsigned __int64 zigzag = (((unsigned __int64)diff) << 1) ^ (unsigned __int64)(diff >> 63);
+                    prev = value;
+                    for (unsigned b=0; b<column.size; b++)
+                        dst[(b*numRows)+r] = (byte)(zigzag >> (b*8));
+                }
+            }
+            else
+            {
+                for (unsigned r=0; r<numRows; r++, src+=rowSize)
+                    memcpy(dst+(r*column.size), src, column.size);
+            }
+            dst += numRows * column.size;
+        }
+    }
+    void decode(byte *rows, size32_t len, MemoryBuffer &temp) const
+    {
+        if (0 != (len % rowSize))
+            throw MakeStringException(0, "Columnar distribute block size (%u) is not a multiple of the row size (%u)", len, rowSize);
+        unsigned numRows = len / rowSize;
+        const byte *src = (const byte *)memcpy(temp.clear().reserveTruncate(len), rows, len);
+        for (const Column &column : columns)
+        {
+            byte *dst = rows + column.offset;
+            if (column.delta)
+            {
+                unsigned __int64 mask = (column.size == sizeof(unsigned __int64)) ? (unsigned __int64)-1 : ((((unsigned __int64)1) << (column.size*8)) - 1);
+                unsigned __int64 prev = 0;
+                for (unsigned r=0; r<numRows; r++, dst+=rowSize)
+                {
+                    unsigned __int64 zigzag = 0;
+                    for (unsigned b=0; b<column.size; b++)
+                        zigzag |= ((unsigned __int64)src[(b*numRows)+r]) << (b*8);
+                    unsigned __int64 diff = (zigzag >> 1) ^ (0 - (zigzag & 1));
+                    prev = (prev + diff) & mask;
+                    writeInt(dst, column.size, prev);
+                }
+            }
+            else
+            {
+                for (unsigned r=0; r<numRows; r++, dst+=rowSize)
+                    memcpy(dst, src+(r*column.size), column.size);
+            }
+            src += numRows * column.size;
+        }
+    }
+};
+
 class CDistributorBase : implements IHashDistributor, implements IExceptionHandler, public CInterface
 {
     Linked<IThorRowInterfaces> rowIf;
@@ -96,6 +230,20 @@ class CDistributorBase : implements IHashDistributor, implements IExceptionHandl
     Owned<IRowWriter> pipewr;
     Owned<ISmartRowBuffer> piperd;
 
+    /* Hot key detection. The hashes of the first hotKeySampleSize rows sent are counted, any hash that
+     * accounts for more than hotKeyPercent of the sample is treated as a hot key. If a spread has been
+     * set, subsequent rows of a hot key are dealt round-robin over hotKeySpread consecutive targets.
+     * Only accessed by the sending thread, apart from the counters.
+     */
+    unsigned hotKeySampleSize = 0;
+    unsigned hotKeyPercent = 0;
+    unsigned hotKeySpread = 0;
+    unsigned hotKeySampled = 0;
+    std::unordered_map<unsigned, unsigned> hotKeySample; // hash -> # rows in sample
+    std::unordered_map<unsigned, unsigned> hotKeys; // hash -> next target offset
+    std::atomic<unsigned> numHotKeys{0};
+    RelaxedAtomic<rowcount_t> hotKeyRows{0};
+
 protected:
     /*
      * CSendBucket - a collection of rows destined for a particular target. A target can be a slave, or ALL
@@ -256,12 +404,25 @@ protected:
             size32_t dstPos = dstMb.length();
             dstMb.append(compSz); // placeholder
             compressor.open(dstMb, owner.bucketSendSize * 2);
-            for (;;)
+            if (owner.columnarCodec)
             {
-                OwnedConstThorRow row = nextRow();
-                if (!row)
-                    break;
-                owner.serializer->serialize(memSerializer, (const byte *)row.get());
+                MemoryBuffer rowMb, columnMb;
+                serializeClear(rowMb);
+                if (rowMb.length())
+                {
+                    owner.columnarCodec->encode(columnMb, (const byte *)rowMb.toByteArray(), rowMb.length());
+                    verifyex(0 != compressor.write(columnMb.toByteArray(), columnMb.length()));
+                }
+            }
+            else
+            {
+                for (;;)
+                {
+                    OwnedConstThorRow row = nextRow();
+                    if (!row)
+                        break;
+                    owner.serializer->serialize(memSerializer, (const byte *)row.get());
+                }
             }
             compressor.close();
             compSz = compressor.buflen();
@@ -269,8 +430,9 @@ protected:
             dstMb.setLength(dstPos + sizeof(compSz) + compSz);
             return sizeof(compSz) + compSz;
         }
-        static void deserializeCompress(MemoryBuffer &mb, MemoryBuffer &out, IExpander &expander)
+        static void deserializeCompress(MemoryBuffer &mb, MemoryBuffer &out, IExpander &expander, const CColumnarRowCodec *columnarCodec)
         {
+            MemoryBuffer temp;
             while (mb.remaining())
             {
                 size32_t compSz;
@@ -278,6 +440,8 @@ protected:
                 unsigned outSize = expander.init(mb.readDirect(compSz));
                 void *buff = out.reserve(outSize);
                 expander.expand(buff);
+                if (columnarCodec)
+                    columnarCodec->decode((byte *)buff, outSize, temp);
             }
         }
     // IRowStream impl.
@@ -837,7 +1001,7 @@ protected:
                         target = targets.item(0);
                     else
                     {
-                        unsigned dest = owner.ihash->hash(row)%owner.numnodes;
+                        unsigned dest = owner.mapTarget(row);
                         if (getSenderFinished(dest))
                             ReleaseThorRow(row);
                         else
@@ -869,6 +1033,7 @@ protected:
                 e->Release();
             }
 
+            owner.finishHotKeySample();
             owner.ActPrintLog("Distribute send finishing");
             if (!aborted)
             {
@@ -1036,6 +1201,8 @@ protected:
     StringAttr id; // for tracing
     ICompressHandler *compressHandler;
     StringBuffer compressOptions;
+    bool columnarCompression = false;
+    Owned<CColumnarRowCodec> columnarCodec; // set if columnarCompression and the rows are suitable
 public:
     IMPLEMENT_IINTERFACE_USING(CInterface);
 
@@ -1077,6 +1244,8 @@ public:
         else
             compressHandler = queryDefaultCompressHandler();
         ::ActPrintLog(activity, thorDetailedLogLevel, "Using compressor: %s", compressHandler ? compressHandler->queryType() : "NONE");
+        if (compressHandler)
+            columnarCompression = activity->getOptBool(THOROPT_HDIST_COLUMNAR);
 
         allowSpill = activity->getOptBool(THOROPT_HDIST_SPILL, true);
         if (allowSpill)
@@ -1090,6 +1259,14 @@ public:
         ::ActPrintLog(activity, thorDetailedLogLevel, "inputBufferSize : %d, bucketSendSize = %d, pullBufferSize=%d", inputBufferSize, bucketSendSize, pullBufferSize);
         targetWriterLimit = activity->getOptUInt(THOROPT_HDIST_TARGETWRITELIMIT);
         ::ActPrintLog(activity, thorDetailedLogLevel, "targetWriterLimit : %d", targetWriterLimit);
+        hotKeySampleSize = activity->getOptUInt(THOROPT_HDIST_HOTKEY_SAMPLE);
+        if (hotKeySampleSize)
+        {
+            hotKeyPercent = activity->getOptUInt(THOROPT_HDIST_HOTKEY_PERCENT, 5);
+            if (0 == hotKeyPercent || hotKeyPercent > 100)
+                hotKeyPercent = 5;
+            ::ActPrintLog(activity, thorDetailedLogLevel, "hotKeySampleSize : %u, hotKeyPercent = %u", hotKeySampleSize, hotKeyPercent);
+        }
     }
 
     virtual void beforeDispose()
@@ -1115,6 +1292,70 @@ public:
         return compressHandler ? compressHandler->getExpander(compressOptions) : NULL;
     }
 
+    inline const CColumnarRowCodec *queryColumnarCodec() const
+    {
+        return columnarCodec;
+    }
+
+    void identifyHotKeys()
+    {
+        unsigned threshold = (unsigned)(((unsigned __int64)hotKeySampled * hotKeyPercent) / 100);
+        if (threshold < 2)
+            threshold = 2;
+        std::vector<std::pair<unsigned, unsigned>> found;
+        for (auto &sample : hotKeySample)
+        {
+            if (sample.second >= threshold)
+                found.emplace_back(sample.first, sample.second);
+        }
+        hotKeySample.clear();
+        if (0 == found.size())
+            return;
+        std::sort(found.begin(), found.end(), [](const std::pair<unsigned, unsigned> &a, const std::pair<unsigned, unsigned> &b) { return a.second > b.second; });
+        StringBuffer report;
+        for (auto &hot : found)
+        {
+            report.appendf(" %08x(%u)", hot.first, hot.second);
+            if (hotKeySpread)
+                hotKeys[hot.first] = 0;
+        }
+        numHotKeys += found.size();
+        ActPrintLog("HDIST: %u hot key(s) in first %u rows%s, hash(rows):%s", (unsigned)found.size(), hotKeySampled, hotKeySpread ? ", spreading" : "", report.str());
+    }
+
+    unsigned mapTarget(const void *row)
+    {
+        unsigned hashValue = ihash->hash(row);
+        unsigned dest = hashValue % numnodes;
+        if (hotKeySampled < hotKeySampleSize)
+        {
+            ++hotKeySample[hashValue];
+            if (++hotKeySampled == hotKeySampleSize)
+                identifyHotKeys();
+        }
+        else if (hotKeys.size())
+        {
+            auto it = hotKeys.find(hashValue);
+            if (it != hotKeys.end())
+            {
+                dest = (dest + it->second) % numnodes;
+                if (++it->second == hotKeySpread)
+                    it->second = 0;
+                hotKeyRows++;
+            }
+        }
+        return dest;
+    }
+
+    void finishHotKeySample()
+    {
+        if (hotKeySampled && hotKeySampled < hotKeySampleSize) // input smaller than sample
+        {
+            identifyHotKeys();
+            hotKeySampled = hotKeySampleSize;
+        }
+    }
+
     size32_t rowMemSize(const void *row)
     {
         if (fixedEstSize)
@@ -1131,6 +1372,24 @@ public:
         if (_pullBufferSize) pullBufferSize = _pullBufferSize;
     }
 
+    virtual void setHotKeySpread(unsigned spread) override
+    {
+        dbgassertex(!doDedup && !isAll);
+        hotKeySpread = std::min(spread, numnodes);
+        if (hotKeySpread < 2)
+            hotKeySpread = 0;
+    }
+
+    virtual unsigned queryNumHotKeys() const override
+    {
+        return numHotKeys;
+    }
+
+    virtual rowcount_t queryHotKeyRows() const override
+    {
+        return hotKeyRows;
+    }
+
     virtual IRowStream *connect(IThorRowInterfaces *_rowIf, IRowStream *_input, IHash *_ihash, ICompare *_iCompare, ICompare *_keepBestCompare)
     {
         ::ActPrintLog(activity, thorDetailedLogLevel, "HASHDISTRIB: connect");
@@ -1142,11 +1401,19 @@ public:
         deserializer = _rowIf->queryRowDeserializer();
 
         fixedEstSize = meta->querySerializedDiskMeta()->getFixedSize();
+        if (columnarCompression)
+        {
+            columnarCodec.setown(CColumnarRowCodec::create(meta->querySerializedDiskMeta()));
+            ::ActPrintLog(activity, thorDetailedLogLevel, "Columnar compression : %s", columnarCodec ? "enabled" : "not applicable to row format");
+        }
 
         input.set(_input);
         ihash = _ihash;
         iCompare = _iCompare;
         keepBestCompare = _keepBestCompare;
+        hotKeySampled = 0;
+        hotKeySample.clear();
+        hotKeys.clear();
         if (allowSpill)
         {
             StringBuffer temp;
@@ -1195,6 +1462,7 @@ public:
         serializer = NULL;
         deserializer = NULL;
         fixedEstSize = 0;
+        columnarCodec.clear();
         input.clear();
         piperd.clear();
         pipewr.clear();
@@ -1239,7 +1507,7 @@ public:
                         size32_t sz = recvMb.length();
 #endif
                         if (expander)
-                            CSendBucket::deserializeCompress(recvMb, tempMb.clear(), *expander);
+                            CSendBucket::deserializeCompress(recvMb, tempMb.clear(), *expander, columnarCodec);
                         else
                             tempMb.clear().swapWith(recvMb);
                         HDSendPrintLog4("recvloop, blocksize=%d, deserializedSz=%d, from=%d", sz, tempMb.length(), n+1);
@@ -1678,7 +1946,7 @@ class CRowPullDistributor: public CDistributorBase
             if (mb.length()==0)
                 return NULL;
             if (expander)
-                CSendBucket::deserializeCompress(mb, bufs[idx], *expander);
+                CSendBucket::deserializeCompress(mb, bufs[idx], *expander, parent.queryColumnarCodec());
             else
                 bufs[idx].swapWith(mb);
             return nextRow(idx);
@@ -2058,7 +2326,7 @@ protected:
     bool isAll = false;
 public:
     HashDistributeSlaveBase(CGraphElementBase *_container)
-        : CSlaveActivity(_container)
+        : CSlaveActivity(_container, hashDistributeActivityStatistics)
     {
         appendOutputLinked(this);
     }
@@ -2080,7 +2348,21 @@ public:
         if (mergecmp)
             distributor = createPullHashDistributor(this, queryJobChannel().queryJobComm(), mptag, false, this);
         else
+        {
             distributor = createHashDistributor(this, queryJobChannel().queryJobComm(), mptag, false, isAll, this);
+            /* Spreading hot keys breaks the guarantee that all rows of a key end up on the same target,
+             * which LOCAL joins, dedups, rollups etc. that follow a distribute rely on. So it is only used
+             * when requested by a hint on this activity, by a query whose consumer can tolerate it (e.g. a
+             * local aggregate that is followed by a global combine). The job wide option is deliberately ignored.
+             */
+            if (!isAll)
+            {
+                VStringBuffer hint("hint[@name=\"%s\"]/@value", THOROPT_HDIST_HOTKEY_SPREAD);
+                unsigned hotKeySpread = queryContainer().queryXGMML().getPropInt(hint.toLowerCase().str());
+                if (hotKeySpread)
+                    distributor->setHotKeySpread(hotKeySpread);
+            }
+        }
     }
     void stopInput()
     {
@@ -2147,6 +2429,15 @@ public:
         info.canStall = true; // currently
         info.unknownRowsOutput = true; // mixed about
     }
+    virtual void serializeStats(MemoryBuffer &mb) override
+    {
+        if (distributor)
+        {
+            stats.setStatistic(StNumHotKeys, distributor->queryNumHotKeys());
+            stats.setStatistic(StNumHotKeyRows, distributor->queryHotKeyRows());
+        }
+        PARENT::serializeStats(mb);
+    }
 };
 
 
@@ -4611,3 +4902,100 @@ CActivityBase *createHashDistributedSlave(CGraphElementBase *container)
     return new CHashDistributedSlaveActivity(container);
 }
 
+#ifdef _USE_CPPUNIT
+
+class ColumnarRowCodecTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(ColumnarRowCodecTest);
+        CPPUNIT_TEST(testFixedSize);
+        CPPUNIT_TEST(testExtremes);
+        CPPUNIT_TEST(testVariableSize);
+        CPPUNIT_TEST(testEmpty);
+    CPPUNIT_TEST_SUITE_END();
+
+    // { integer8 id; unsigned4 seq; string6 name; integer2 small; }
+    const RtlIntTypeInfo int8Type{type_int, 8};
+    const RtlIntTypeInfo uint4Type{type_int|RFTMunsigned, 4};
+    const RtlStringTypeInfo str6Type{type_string, 6};
+    const RtlIntTypeInfo int2Type{type_int, 2};
+    const RtlFieldStrInfo idField{"id", nullptr, &int8Type};
+    const RtlFieldStrInfo seqField{"seq", nullptr, &uint4Type};
+    const RtlFieldStrInfo nameField{"name", nullptr, &str6Type};
+    const RtlFieldStrInfo smallField{"small", nullptr, &int2Type};
+    const RtlFieldInfo * const fixedFields[5] = { &idField, &seqField, &nameField, &smallField, nullptr };
+    const RtlRecordTypeInfo fixedRecord{type_record, 20, fixedFields};
+
+    // { integer8 id; string name; }
+    const RtlStringTypeInfo varStrType{type_string|RFTMunknownsize, 0};
+    const RtlFieldStrInfo varNameField{"name", nullptr, &varStrType};
+    const RtlFieldInfo * const varFields[3] = { &idField, &varNameField, nullptr };
+    const RtlRecordTypeInfo varRecord{type_record|RFTMunknownsize, 12, varFields};
+
+    unsigned __int64 seed = 0;
+    unsigned __int64 next()
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return seed >> 16;
+    }
+    void checkRoundTrip(const CColumnarRowCodec &codec, const MemoryBuffer &rows)
+    {
+        MemoryBuffer encoded, temp;
+        codec.encode(encoded, (const byte *)rows.toByteArray(), rows.length());
+        CPPUNIT_ASSERT_EQUAL(rows.length(), encoded.length());
+        codec.decode((byte *)encoded.bufferBase(), encoded.length(), temp);
+        CPPUNIT_ASSERT(0 == memcmp(rows.toByteArray(), encoded.toByteArray(), rows.length()));
+    }
+public:
+    void testFixedSize()
+    {
+        CDynamicOutputMetaData meta(fixedRecord);
+        Owned<CColumnarRowCodec> codec = CColumnarRowCodec::create(&meta);
+        CPPUNIT_ASSERT(codec);
+        CPPUNIT_ASSERT_EQUAL((size32_t)20, codec->queryRowSize());
+        for (unsigned numRows : { 1, 2, 7, 1000 })
+        {
+            MemoryBuffer rows;
+            __int64 id = 1000;
+            for (unsigned r=0; r<numRows; r++)
+            {
+                id += (__int64)(next() % 200) - 100; // small steps in both directions
+                unsigned seq = (unsigned)next();
+                short small = (short)next();
+                rows.append(id).append(seq).append(6, "abcdef").append(small);
+            }
+            checkRoundTrip(*codec, rows);
+        }
+    }
+    void testExtremes()
+    {
+        // Steps that overflow the field width must wrap rather than lose bits
+        CDynamicOutputMetaData meta(fixedRecord);
+        Owned<CColumnarRowCodec> codec = CColumnarRowCodec::create(&meta);
+        const __int64 ids[] = { 0, INT64_MIN, INT64_MAX, -1, INT64_MIN, 1, INT64_MAX };
+        const unsigned seqs[] = { 0, UINT_MAX, 0, 0x80000000, 1, UINT_MAX, 0x7fffffff };
+        const short smalls[] = { 0, SHRT_MIN, SHRT_MAX, -1, SHRT_MIN, 1, SHRT_MAX };
+        MemoryBuffer rows;
+        for (unsigned r=0; r<sizeof(ids)/sizeof(ids[0]); r++)
+            rows.append(ids[r]).append(seqs[r]).append(6, "\0\xff\0\xff\0\xff").append(smalls[r]);
+        checkRoundTrip(*codec, rows);
+    }
+    void testVariableSize()
+    {
+        // Variable size rows are not encoded, they are sent as before
+        CDynamicOutputMetaData meta(varRecord);
+        Owned<CColumnarRowCodec> codec = CColumnarRowCodec::create(&meta);
+        CPPUNIT_ASSERT(!codec);
+    }
+    void testEmpty()
+    {
+        CDynamicOutputMetaData meta(fixedRecord);
+        Owned<CColumnarRowCodec> codec = CColumnarRowCodec::create(&meta);
+        MemoryBuffer rows;
+        checkRoundTrip(*codec, rows);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ColumnarRowCodecTest);
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(ColumnarRowCodecTest, "ColumnarRowCodecTest");
+
+#endif // _USE_CPPUNIT
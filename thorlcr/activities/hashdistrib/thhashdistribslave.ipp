@@ -31,6 +31,9 @@ interface IHashDistributor : extends IInterface
     virtual void join()=0;
     virtual void setBufferSizes(unsigned sendBufferSize, unsigned outputBufferSize, unsigned pullBufferSize) = 0;
     virtual void abort()=0;
+    virtual void setHotKeySpread(unsigned spread)=0; // only valid if the consumer does not need all rows of a key on the same target
+    virtual unsigned queryNumHotKeys() const=0;
+    virtual rowcount_t queryHotKeyRows() const=0;
 };
 
 interface IStopInput;
@@ -1277,6 +1277,42 @@ class CKeyedJoinSlave : public CSlaveActivity, implements IJoinProcessor, implem
             limiter = &activity.lookupThreadLimiter;
             allParts = &activity.allIndexParts;
         }
+        void getKeyOrder(CThorExpandingRowArray &processing, IKeyManager *keyManager, std::vector<unsigned> &order)
+        {
+            /* Seeking the batch in key order means adjacent lookups often land in the leaf the previous lookup finished on,
+             * sharing the branch traversal and node loads, and walking the index forwards once per batch.
+             * Rows whose filter cannot match sort first, they will not touch the index.
+             */
+            unsigned numRows = processing.ordinality();
+            std::vector<size32_t> boundOffsets(numRows);
+            MemoryBuffer lowBounds;
+            size32_t boundSize = 0;
+            for (unsigned r=0; r<numRows; r++)
+            {
+                const void *keyedFieldsRow = (byte *)processing.query(r) + sizeof(KeyLookupHeader);
+                helper->createSegmentMonitors(keyManager, keyedFieldsRow);
+                keyManager->finishSegmentMonitors();
+                size32_t startOffset = lowBounds.length();
+                if (keyManager->getLowBound(lowBounds))
+                {
+                    boundSize = lowBounds.length() - startOffset;
+                    boundOffsets[r] = startOffset;
+                }
+                else
+                    boundOffsets[r] = NotFound;
+                keyManager->releaseSegmentMonitors();
+                order.push_back(r);
+            }
+            const byte *bounds = lowBounds.bytes();
+            std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b)
+            {
+                if (NotFound == boundOffsets[a])
+                    return NotFound != boundOffsets[b];
+                else if (NotFound == boundOffsets[b])
+                    return false;
+                return memcmp(bounds + boundOffsets[a], bounds + boundOffsets[b], boundSize) < 0;
+            });
+        }
         void processRows(CThorExpandingRowArray &processing, unsigned partNo, IKeyManager *keyManager)
         {
             unsigned __int64 startSeeks = keyManager->querySeeks();
@@ -1289,9 +1325,12 @@ class CKeyedJoinSlave : public CSlaveActivity, implements IJoinProcessor, implem
                 activity.stats.sumStatistic(StNumIndexWildSeeks, keyManager->queryWildSeeks()-startWildSeeks);
             };
             COnScopeExit scoped(onScopeExitFunc);
-            for (unsigned r=0; r<processing.ordinality() && !stopped; r++)
+            std::vector<unsigned> order;
+            if (activity.sortedLookupBatches && (processing.ordinality() > 1))
+                getKeyOrder(processing, keyManager, order);
+            for (unsigned i=0; i<processing.ordinality() && !stopped; i++)
             {
-                OwnedConstThorRow row = processing.getClear(r);
+                OwnedConstThorRow row = processing.getClear(order.size() ? order[i] : i);
                 CJoinGroup *joinGroup = *(CJoinGroup **)row.get();
 
                 const void *keyedFieldsRow = (byte *)row.get() + sizeof(KeyLookupHeader);
@@ -1825,9 +1864,19 @@ class CKeyedJoinSlave : public CSlaveActivity, implements IJoinProcessor, implem
                 activity.stats.mergeStatistic(StNumDiskSeeks, diskSeeks);
             };
             COnScopeExit scoped(onScopeExitFunc);
-            for (unsigned r=0; r<processing.ordinality() && !stopped; r++)
+
+            // Read the batch in file order, so nearby rows are served by the same read ahead and the disk seeks forwards
+            std::vector<std::pair<offset_t, unsigned>> order;
+            if (activity.sortedLookupBatches && (processing.ordinality() > 1))
+            {
+                order.reserve(processing.ordinality());
+                for (unsigned r=0; r<processing.ordinality(); r++)
+                    order.emplace_back(((const FetchRequestHeader *)processing.query(r))->fpos, r);
+                std::sort(order.begin(), order.end());
+            }
+            for (unsigned i=0; i<processing.ordinality() && !stopped; i++)
             {
-                OwnedConstThorRow row = processing.getClear(r);
+                OwnedConstThorRow row = processing.getClear(order.size() ? order[i].second : i);
                 FetchRequestHeader &requestHeader = *(FetchRequestHeader *)row.get();
                 CJoinGroup *joinGroup = requestHeader.jg;
 
@@ -2265,6 +2314,7 @@ class CKeyedJoinSlave : public CSlaveActivity, implements IJoinProcessor, implem
     bool forceRemoteKeyedLookup = false;
     bool forceRemoteKeyedFetch = false;
     bool messageCompression = false;
+    bool sortedLookupBatches = true;
 
     Owned<IThorRowInterfaces> keyLookupRowWithJGRowIf;
     Owned<IThorRowInterfaces> keyLookupReplyOutputMetaRowIf;
@@ -2965,6 +3015,7 @@ public:
         keyLookupProcessBatchLimit = getOptInt(THOROPT_KEYLOOKUP_PROCESS_BATCHLIMIT, defaultKeyLookupProcessBatchLimit);
         fetchLookupProcessBatchLimit = getOptInt(THOROPT_FETCHLOOKUP_PROCESS_BATCHLIMIT, defaultFetchLookupProcessBatchLimit);
         messageCompression = getOptBool(THOROPT_KEYLOOKUP_COMPRESS_MESSAGES, true);
+        sortedLookupBatches = getOptBool(THOROPT_KEYLOOKUP_SORTED_BATCHES, true);
 
         fetchLookupQueuedBatchSize = getOptInt(THOROPT_KEYLOOKUP_FETCH_QUEUED_BATCHSIZE, defaultKeyLookupFetchQueuedBatchSize);
 
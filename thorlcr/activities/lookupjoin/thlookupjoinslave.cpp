@@ -86,6 +86,8 @@ interface IBCastReceive
 /*
  * CBroadcaster, is a utility class, that sends CSendItem packets to sibling nodes, which in turn resend to others,
  * ensuring the data is broadcast to all other nodes.
+ * By default packets are resent down a binomial tree rooted at the originating node. In ring mode each node only
+ * resends to its successor, so every node sends each packet once, rather than the originator sending log2(nodes) copies.
  * sender and receiver threads are employed to handle the receipt/resending of packets.
  * CBroadcaster should be started on all receiving nodes, each receiver will receive CSendItem packets
  * through IBCastReceive::bCastReceive calls.
@@ -100,7 +102,11 @@ class CBroadcaster : public CSimpleInterface
     InterruptableSemaphore allDoneSem;
     CriticalSection allDoneLock, stopCrit;
     CriticalSection *broadcastLock;
-    bool allRequestStop, stopping, stopRecv, receiving, nodeBroadcast;
+    bool allRequestStop, stopping, stopRecv, receiving, nodeBroadcast, ringBroadcast;
+    CriticalSection hopStatsCrit;
+    unsigned numHops = 0;
+    unsigned __int64 hopBytes = 0;
+    cycle_t totalHopCycles = 0, maxHopCycles = 0; // time from send to ack, per target
     unsigned waitingAtAllDoneCount;
     broadcast_flags stopFlag;
     Owned<IBitSet> sendersDone, broadcastersStopping;
@@ -254,6 +260,8 @@ class CBroadcaster : public CSimpleInterface
     }
     unsigned target(unsigned i, unsigned node)
     {
+        if (ringBroadcast)
+            return (0 == i) ? node+1 : nodes; // only ever to the successor, nodes signifies no more targets
         // For a tree broadcast, calculate the next node to send the data to. i represents the ith copy sent from this node.
         // node is a 0 based node number.
         // It returns a 0 based node number of the next node to send the data to.
@@ -273,6 +281,7 @@ class CBroadcaster : public CSimpleInterface
         unsigned origin = sendItem->queryNode();
         unsigned pseudoNode = (myNode<origin) ? nodes-origin+myNode : myNode-origin;
         CMessageBuffer replyMsg;
+        cycle_t startCycles = get_cycles_now();
         // sends to all in 1st pass, then waits for ack from all
         for (unsigned sendRecv=0; sendRecv<2 && !activity.queryAbortSoon(); sendRecv++)
         {
@@ -306,6 +315,7 @@ class CBroadcaster : public CSimpleInterface
 #endif
                     if (!activity.receiveMsg(comm, replyMsg, t, rt))
                         break;
+                    noteHop(sendItem->length(), get_cycles_now()-startCycles);
 #ifdef _TRACEBROADCAST
                     ActPrintLog(&activity, "Broadcast node %d Sent to node %d, origin node %d, origin slave %d, size %d, code=%d - received ack", myNode+1, t, origin+1, sendItem->querySlave()+1, sendLen, (unsigned)sendItem->queryCode());
 #endif
@@ -313,6 +323,22 @@ class CBroadcaster : public CSimpleInterface
             }
         }
     }
+    void noteHop(size32_t len, cycle_t cycles)
+    {
+        CriticalBlock b(hopStatsCrit);
+        numHops++;
+        hopBytes += len;
+        totalHopCycles += cycles;
+        if (cycles > maxHopCycles)
+            maxHopCycles = cycles;
+    }
+    void resetHopStats()
+    {
+        CriticalBlock b(hopStatsCrit);
+        numHops = 0;
+        hopBytes = 0;
+        totalHopCycles = maxHopCycles = 0;
+    }
     void cancelReceive()
     {
         stopRecv = true;
@@ -417,6 +443,9 @@ public:
         broadcastLock = NULL;
         receiving = false;
         nodeBroadcast = false;
+        ringBroadcast = activity.getOptBool(THOROPT_LKJOIN_RING_BROADCAST);
+        if (ringBroadcast)
+            ActPrintLog(&activity, "CBroadcaster: using ring broadcast");
     }
     void start(IBCastReceive *_recvInterface, mptag_t _mpTag, bool _stopping, bool _nodeBroadcast)
     {
@@ -448,6 +477,7 @@ public:
         stopFlag = bcastflag_null;
         sendersDone->reset();
         broadcastersStopping->reset();
+        resetHopStats();
     }
     CSendItem *newSendItem(broadcast_code code)
     {
@@ -481,6 +511,20 @@ public:
     {
         receiver.wait(); // terminates when received stop from all others
         sender.wait(); // terminates when any remaining packets, including final stop packets have been re-broadcast
+        CriticalBlock b(hopStatsCrit);
+        if (numHops)
+        {
+            ActPrintLog(&activity, "CBroadcaster(%s): %u hops sent, %" I64F "u bytes, total hop time = %" I64F "u ms, avg hop = %" I64F "u us, max hop = %" I64F "u us",
+                        ringBroadcast ? "ring" : "tree", numHops, hopBytes, cycle_to_millisec(totalHopCycles), cycle_to_microsec(totalHopCycles)/numHops, cycle_to_microsec(maxHopCycles));
+            // merged, so that the stop broadcast and further iterations (e.g. in a loop) accumulate
+            CRuntimeStatisticCollection &stats = activity.queryStats();
+            stats.mergeStatistic(StNumBroadcastHops, numHops);
+            stats.mergeStatistic(StSizeBroadcastHops, hopBytes);
+            stats.mergeStatistic(StTimeBroadcastHops, cycle_to_nanosec(totalHopCycles));
+            numHops = 0;
+            hopBytes = 0;
+            totalHopCycles = maxHopCycles = 0;
+        }
     }
     void cancel(IException *e=NULL)
     {
@@ -2976,10 +3020,22 @@ public:
     }
 };
 
+/*
+ * The hash tables keep a one byte fingerprint of each entry's hash value in a separate array beside the slots.
+ * A probe only touches (and compares) the row in a slot whose tag matches, and a zero tag marks an empty slot,
+ * so most mismatching probes are rejected from the compact tag array without dereferencing the row.
+ */
+static inline byte getHashTag(unsigned hv)
+{
+    byte tag = (byte)(hv >> 24);
+    return tag ? tag : 1;
+}
+
 class CHTBase : public CTableCommon
 {
 protected:
     OwnedConstThorRow htMemory;
+    byte *htTags;
     IHash *leftHash, *rightHash;
     ICompare *compareLeftRight;
 
@@ -2990,13 +3046,16 @@ public:
     }
     void setup(CSlaveActivity *activity, roxiemem::IRowManager *rowManager, rowidx_t size, IHash *_leftHash, IHash *_rightHash, ICompare *_compareLeftRight)
     {
-        unsigned __int64 _sz = sizeof(const void *) * ((unsigned __int64)size);
+        // slot array followed by a tag byte per slot
+        unsigned __int64 _slotSz = sizeof(const void *) * ((unsigned __int64)size);
+        unsigned __int64 _sz = _slotSz + size;
         memsize_t sz = (memsize_t)_sz;
         if (sz != _sz) // treat as OOM exception for handling purposes.
             throw MakeStringException(ROXIEMM_MEMORY_LIMIT_EXCEEDED, "Unsigned overflow, trying to allocate hash table of size: %" I64F "d ", _sz);
         void *ht = rowManager->allocate(sz, activity->queryContainer().queryId(), SPILL_PRIORITY_LOW);
         memset(ht, 0, sz);
         htMemory.setown(ht);
+        htTags = ((byte *)ht) + (memsize_t)_slotSz;
         tableSize = size;
         leftHash = _leftHash;
         rightHash = _rightHash;
@@ -3006,6 +3065,7 @@ public:
     {
         CTableCommon::reset();
         htMemory.clear();
+        htTags = NULL;
         leftHash = rightHash = NULL;
         compareLeftRight = NULL;
     }
@@ -3018,14 +3078,20 @@ class CLookupHT : public CHTBase
 
     const void *findFirst(const void *left)
     {
-        unsigned h = leftHash->hash(left)%tableSize;
+        unsigned hv = leftHash->hash(left);
+        byte tag = getHashTag(hv);
+        unsigned h = hv%tableSize;
         for (;;)
         {
-            const void *right = ht[h];
-            if (!right)
+            byte slotTag = htTags[h];
+            if (!slotTag)
                 break;
-            if (0 == compareLeftRight->docompare(left, right))
-                return right;
+            if (slotTag == tag)
+            {
+                const void *right = ht[h];
+                if (0 == compareLeftRight->docompare(left, right))
+                    return right;
+            }
             h++;
             if (h>=tableSize)
                 h = 0;
@@ -3057,15 +3123,16 @@ public:
         CHTBase::reset();
         ht = NULL;
     }
-    inline void addEntry(const void *row, unsigned hash)
+    inline void addEntry(const void *row, unsigned hv)
     {
+        unsigned hash = hv%tableSize;
         for (;;)
         {
-            const void *&htRow = ht[hash];
-            if (!htRow)
+            if (!htTags[hash])
             {
                 LinkThorRow(row);
-                htRow = row;
+                ht[hash] = row;
+                htTags[hash] = getHashTag(hv);
                 break;
             }
             hash++;
@@ -3092,8 +3159,7 @@ public:
             if (0 == nextPos)
                 break;
             const void *row = rows[pos];
-            unsigned h = rightHash->hash(row)%tableSize;
-            addEntry(row, h);
+            addEntry(row, rightHash->hash(row));
             pos = nextPos;
         }
         // Rows now in hash table, rhs arrays no longer needed
@@ -3108,26 +3174,25 @@ class CLookupManyHT : public CHTBase
     HtEntry *ht;
     const void **rows;
 
-    inline HtEntry *lookup(unsigned hash)
-    {
-        HtEntry *e = ht+hash;
-        if (0 == e->count)
-            return NULL;
-        return e;
-    }
     const void *findFirst(const void *left, HtEntry &currentHashEntry)
     {
-        unsigned h = leftHash->hash(left)%tableSize;
+        unsigned hv = leftHash->hash(left);
+        byte tag = getHashTag(hv);
+        unsigned h = hv%tableSize;
         for (;;)
         {
-            HtEntry *e = lookup(h);
-            if (!e)
+            byte slotTag = htTags[h];
+            if (!slotTag)
                 break;
-            const void *right = rows[e->index];
-            if (0 == compareLeftRight->docompare(left, right))
+            if (slotTag == tag)
             {
-                currentHashEntry = *e;
-                return right;
+                HtEntry &e = ht[h];
+                const void *right = rows[e.index];
+                if (0 == compareLeftRight->docompare(left, right))
+                {
+                    currentHashEntry = e;
+                    return right;
+                }
             }
             h++;
             if (h>=tableSize)
@@ -3146,15 +3211,17 @@ public:
         CHTBase::setup(activity, rowManager, size, leftHash, rightHash, compareLeftRight);
         ht = (HtEntry *)htMemory.get();
     }
-    inline void addEntry(const void *row, unsigned hash, rowidx_t index, rowidx_t count)
+    inline void addEntry(const void *row, unsigned hv, rowidx_t index, rowidx_t count)
     {
+        unsigned hash = hv%tableSize;
         for (;;)
         {
-            HtEntry &e = ht[hash];
-            if (!e.count)
+            if (!htTags[hash])
             {
+                HtEntry &e = ht[hash];
                 e.index = index;
                 e.count = count;
+                htTags[hash] = getHashTag(hv);
                 break;
             }
             hash++;
@@ -3201,9 +3268,8 @@ public:
              * i.e. feels like LOOKUP without MANY should be deprecated..
             */
             const void *row = rows[pos];
-            unsigned h = rightHash->hash(row)%tableSize;
             // NB: 'pos' and 'count' won't be used if dedup variety
-            addEntry(row, h, pos, count);
+            addEntry(row, rightHash->hash(row), pos, count);
             pos = pos2;
         }
     }
@@ -3358,7 +3424,7 @@ protected:
         }
     }
 public:
-    CAllJoinSlaveActivity(CGraphElementBase *_container) : PARENT(_container)
+    CAllJoinSlaveActivity(CGraphElementBase *_container) : PARENT(_container, lookupJoinActivityStatistics)
     {
         returnMany = true;
     }
@@ -2830,6 +2830,7 @@ void CJobBase::startJob()
     unsigned keyLeafCacheMB = getWorkUnitValueInt("keyLeafCacheMB", DEFAULT_KEYLEAFCACHEMB * queryJobChannels());
     unsigned keyBlobCacheMB = getWorkUnitValueInt("keyBlobCacheMB", DEFAULT_KEYBLOBCACHEMB * queryJobChannels());
     bool legacyNodeCache = getWorkUnitValueBool("legacyNodeCache", false);
+    unsigned nodeCacheShards = (unsigned)getWorkUnitValueInt("nodeCacheShards", 1);
     keyNodeCacheBytes = ((memsize_t)0x100000) * keyNodeCacheMB;
     keyLeafCacheBytes = ((memsize_t)0x100000) * keyLeafCacheMB;
     keyBlobCacheBytes = ((memsize_t)0x100000) * keyBlobCacheMB;
@@ -2837,7 +2838,9 @@ void CJobBase::startJob()
     setLeafCacheMem(keyLeafCacheBytes);
     setBlobCacheMem(keyBlobCacheBytes);
     setLegacyNodeCache(legacyNodeCache);
-    PROGLOG("Key node caching setting: node=%u MB, leaf=%u MB, blob=%u MB", keyNodeCacheMB, keyLeafCacheMB, keyBlobCacheMB);
+    setNodeCacheShards(nodeCacheShards);
+    useKeyPrefixSearch = getWorkUnitValueBool("useKeyPrefixSearch", false);
+    PROGLOG("Key node caching setting: node=%u MB, leaf=%u MB, blob=%u MB, shards=%u", keyNodeCacheMB, keyLeafCacheMB, keyBlobCacheMB, nodeCacheShards);
 
     unsigned keyFileCacheLimit = (unsigned)getWorkUnitValueInt("keyFileCacheLimit", 0);
     if (!keyFileCacheLimit)
@@ -1992,7 +1992,7 @@ IActivityReplicatedFile *createEnsurePrimaryPartFile(const char *logicalFilename
 ///////////////
 
 class CFileCache;
-class CLazyFileIO : public CInterfaceOf<IFileIO>
+class CLazyFileIO : public CInterfaceOf<IFileIO>, implements IBatchReadFileIO
 {
     typedef CInterfaceOf<IFileIO> PARENT;
 
@@ -2039,6 +2039,17 @@ public:
         Owned<IFileIO> iFileIO = getOpenFileIO(*activity);
         return iFileIO->size();
     }
+// IBatchReadFileIO impl.
+    virtual bool canReadConcurrently() override
+    {
+        Owned<IFileIO> iFileIO = getOpenFileIO(*activity);
+        return canReadFileConcurrently(iFileIO);
+    }
+    virtual void readBatch(unsigned num, FileReadRequest * requests) override
+    {
+        Owned<IFileIO> iFileIO = getOpenFileIO(*activity);
+        readFileBatch(iFileIO, num, requests);
+    }
     virtual void close() override
     {
         /* NB: clears CLazyFileIO's ownership of the underlying IFileIO, there will be disposed on exit of this function if no other references,
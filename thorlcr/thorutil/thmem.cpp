@@ -62,6 +62,7 @@ static Owned<ILargeMemLimitNotify> MTthresholdnotify;
 static bool MTlocked = false;
 
 #define DEFAULT_SORT_COMPBLKSZ 0x10000 // 64K
+static constexpr rowidx_t radixSortThreshold = 1000; // rows, below which a comparison sort is quick enough
 
 void checkMultiThorMemoryThreshold(bool inc)
 {
@@ -583,6 +584,33 @@ bool CThorExpandingRowArray::resizeRowTable(void **&_rows, rowidx_t requiredRows
 void CThorExpandingRowArray::doSort(rowidx_t n, void **const rows, ICompare &compare, unsigned maxCores)
 {
     // NB: will only be called if numRows>1
+    if (n >= radixSortThreshold)
+    {
+        // If the generated compare provides a normalized key, a radix sort (which is stable) is significantly quicker
+        const ICompareNormalizedKey *keyCompare = dynamic_cast<const ICompareNormalizedKey *>(&compare);
+        if (keyCompare)
+        {
+            OwnedConstThorRow workspace;
+            try
+            {
+                // The workspace is optional, so never cause other activities to spill to provide it
+                workspace.setown(rowManager->allocate(radixSortWorkspaceSize(n), activity.queryContainer().queryId(), 0));
+            }
+            catch (IException *e)
+            {
+                // not fatal if out of memory, fall back to a comparison sort which needs less memory
+                unsigned code = e->errorCode();
+                if ((code != ROXIEMM_MEMORY_LIMIT_EXCEEDED) && (code != ROXIEMM_MEMORY_POOL_EXHAUSTED))
+                    throw;
+                e->Release();
+            }
+            if (workspace)
+            {
+                radixsortvecstableinplace(rows, n, *keyCompare, (void *)workspace.get(), maxCores);
+                return;
+            }
+        }
+    }
     if (stableSort_none != stableSort)
     {
         OwnedConstThorRow tmpStableTable;
@@ -53,6 +53,10 @@
 #define THOROPT_HDIST_TARGETWRITELIMIT "hdTargetLimit"          // Limit # of writer threads working on a single target                          (default = unbound, but picks round-robin)
 #define THOROPT_HDIST_COMP            "hdCompressorType"        // Distribute compressor to use                                                  (default = "LZ4")
 #define THOROPT_HDIST_COMPOPTIONS     "hdCompressorOptions"     // Distribute compressor options, e.g. AES key                                   (default = "")
+#define THOROPT_HDIST_COLUMNAR        "hdColumnar"              // Transpose fixed size rows into delta encoded columns before compressing       (default = false)
+#define THOROPT_HDIST_HOTKEY_SAMPLE   "hdHotKeySample"          // # of rows sampled at start of distribute to detect hot keys, 0 = disabled     (default = 0)
+#define THOROPT_HDIST_HOTKEY_PERCENT  "hdHotKeyPercent"         // % of sampled rows a key must exceed to be considered hot                      (default = 5)
+#define THOROPT_HDIST_HOTKEY_SPREAD   "hdHotKeySpread"          // # of targets to spread hot keys over (HASH DISTRIBUTE hint only), 0 = off     (default = 0)
 #define THOROPT_SPLITTER_SPILL        "splitterSpill"           // Force splitters to spill or not, default is to adhere to helper setting       (default = -1)
 #define THOROPT_LOOP_MAX_EMPTY        "loopMaxEmpty"            // Max # of iterations that LOOP can cycle through with 0 results before errors  (default = 1000)
 #define THOROPT_SMALLSORT             "smallSortThreshold"      // Use minisort approach, if estimate size of data to sort is below this setting (default = 0)
@@ -64,6 +68,7 @@
 #define THOROPT_JOINHELPER_THREADS    "joinHelperThreads"       // Number of threads to use in threaded variety of join helper
 #define THOROPT_LKJOIN_LOCALFAILOVER  "lkjoin_localfailover"    // Force SMART to failover to distributed local lookup join (for testing only)   (default = false)
 #define THOROPT_LKJOIN_HASHJOINFAILOVER "lkjoin_hashjoinfailover" // Force SMART to failover to hash join (for testing only)                     (default = false)
+#define THOROPT_LKJOIN_RING_BROADCAST "lkjoin_ringbroadcast"    // Broadcast RHS around a ring of nodes, rather than down a binomial tree        (default = false)
 #define THOROPT_MAX_KERNLOG           "max_kern_level"          // Max kernel logging level, to push to workunit, -1 to disable                  (default = 3)
 #define THOROPT_COMP_FORCELZW         "forceLZW"                // Forces file compression to use LZW                                            (default = false)
 #define THOROPT_COMP_FORCEFLZ         "forceFLZ"                // Forces file compression to use FLZ                                            (default = false)
@@ -97,6 +102,7 @@
 #define THOROPT_KEYLOOKUP_MAX_FETCH_LOCAL_HANDLERS "maxLocalFetchHandlers" // maximum number of fetch handlers dealing with local parts          (default = 10)
 #define THOROPT_KEYLOOKUP_MAX_FETCH_REMOTE_HANDLERS "maxRemoteFetchHandlers" // maximum number of fetch handlers per remote slave                (default = 2)
 #define THOROPT_KEYLOOKUP_COMPRESS_MESSAGES "keyedJoinCompressMsgs" // compress key and fetch request messages                                   (default = true)
+#define THOROPT_KEYLOOKUP_SORTED_BATCHES "keyedJoinSortedBatches" // process local key and fetch lookup batches in key/file position order     (default = true)
 #define THOROPT_FORCE_REMOTE_DISABLED "forceRemoteDisabled"     // disable remote (via dafilesrv) reads (NB: takes precedence over forceRemoteRead) (default = false)
 #define THOROPT_FORCE_REMOTE_READ     "forceRemoteRead"         // force remote (via dafilesrv) read (NB: takes precedence over environment.conf setting) (default = false)
 #define THOROPT_ACTINIT_WAITTIME_MINS "actInitWaitTimeMins"     // max time to wait for slave activity initialization message from master
@@ -125,6 +131,7 @@ enum RegistryCode:unsigned { rc_register, rc_deregister };
 extern graph_decl const StatisticsMapping spillStatistics;
 extern graph_decl const StatisticsMapping basicActivityStatistics;
 extern graph_decl const StatisticsMapping groupActivityStatistics;
+extern graph_decl const StatisticsMapping hashDistributeActivityStatistics;
 extern graph_decl const StatisticsMapping hashJoinActivityStatistics;
 extern graph_decl const StatisticsMapping indexReadActivityStatistics;
 extern graph_decl const StatisticsMapping indexWriteActivityStatistics;
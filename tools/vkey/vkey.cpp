@@ -76,6 +76,7 @@ inline void SwapBigEndian(KeyHdr &hdr)
     _WINREV(hdr.fileSize);
     _WINREV(hdr.nodeKeyLength);
     _WINREV(hdr.version);
+    _WINREV(hdr.extflags);
     _WINREV(hdr.blobHead);
     _WINREV(hdr.metadataHead);
 }
@@ -298,7 +299,8 @@ void checkLevel(int f, KeyHdr &h, unsigned &level, offset_t firstnode)
             {
                 unsigned expandSize;
                 memcpy(&expandSize, nodeData+sizeof(NodeHdr)+8, 4);
-                _WINREV(expandSize);
+                if (!(h.extflags & (HTREE_LZ4_COMPRESSED_KEY >> 8)))   // LZ4 sizes are stored in native order
+                    _WINREV(expandSize);
                 if (expandSize > maxExpandSize)
                     maxExpandSize = expandSize;
                 totalExpandSize += expandSize;